@@ -0,0 +1,58 @@
+//
+//  main.cpp
+//  Dynamixel
+//
+//  Created by Vinzenz Weist on 27.04.20.
+//  Copyright © 2020 Vinzenz Weist. All rights reserved.
+//
+
+#include <csignal>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include "../src/dynamixel.h"
+#include "../src/dynamixel_daemon.h"
+
+volatile sig_atomic_t g_running = 1;
+
+/**
+ * stop the tick loop
+ * @param t_signal the received signal
+ */
+void set_stop([[maybe_unused]] int t_signal) {
+    g_running = 0;
+}
+
+/**
+ * usage: DynamixelDaemon [device] [baud rate] [socket path] [tick rate]
+ */
+int main(int argc, const char * argv[]) {
+    const char* dxl_device = argc > 1 ? argv[1] : "/dev/ttyACM0";
+    int dxl_baud_rate = argc > 2 ? atoi(argv[2]) : 1000000;
+    const char* dxl_socket_path = argc > 3 ? argv[3] : DXL_DAEMON_SOCKET;
+    double dxl_rate = argc > 4 ? atof(argv[4]) : 100.0;
+
+    Dynamixel dynamixel = Dynamixel(dxl_device, 2.0, dxl_baud_rate);
+    if(!dynamixel.set_open()) {
+        printf("failed: could not open port, please check connection!");
+        return 1;
+    }
+    Dynamixel_Daemon daemon = Dynamixel_Daemon(dynamixel, dxl_socket_path, dxl_rate);
+    if (!daemon.set_open()) {
+        dynamixel.set_close();
+        return 1;
+    }
+    signal(SIGINT, set_stop);
+    signal(SIGTERM, set_stop);
+
+    auto dxl_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(daemon.get_period()));
+    auto dxl_next = std::chrono::steady_clock::now();
+    while (g_running) {
+        daemon.set_tick();
+        dxl_next += dxl_period;
+        std::this_thread::sleep_until(dxl_next);
+    }
+    daemon.set_close();
+    dynamixel.set_close();
+    return 0;
+}
@@ -17,6 +17,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include "dynamixel_audit.h"
 #include "dynamixel.h"
 
 /**
@@ -40,6 +42,7 @@ void Dynamixel::set_reboot(uint8_t t_dxl_id) {
     uint8_t t_dxl_error;
     uint8_t t_dxl_result = m_packet_handler->reboot(m_port_handler, t_dxl_id, &t_dxl_error);
     m_get_validated_result(t_dxl_result, t_dxl_error);
+    m_clock.set_reset(t_dxl_id);
 }
 /**
  * factory reset a dynamixel
@@ -104,6 +107,15 @@ uint8_t Dynamixel::get_operating_mode(uint8_t t_dxl_id) {
     uint8_t dxl_operating_mode = m_get_small_register(t_dxl_id, ADDR_OPERATING_MODE);
     return dxl_operating_mode;
 }
+/**
+ * get the current return delay time of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel return delay time value (2 usec units)
+ */
+uint8_t Dynamixel::get_return_delay_time(uint8_t t_dxl_id) {
+    uint8_t dxl_return_delay_time = m_get_small_register(t_dxl_id, ADDR_RETURN_DELAY_TIME);
+    return dxl_return_delay_time;
+}
 /**
  * get the current firmware version of a dynamixel
  * @param t_dxl_id the identifier of the dynamixel
@@ -257,6 +269,112 @@ uint32_t Dynamixel::get_present_position(uint8_t t_dxl_id) {
     uint32_t dxl_position = m_get_large_register(t_dxl_id, ADDR_PRESENT_POSITION);
     return dxl_position;
 }
+/**
+ * get a time stamped state snapshot of a dynamixel (realtime tick up to present position in one read)
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the state snapshot
+ */
+Dynamixel_State Dynamixel::get_state(uint8_t t_dxl_id) {
+    uint8_t t_dxl_error = 0;
+    uint8_t dxl_data[ADDR_STATE_LEN] = {0};
+    double dxl_tx_time = 0.0;
+    int t_dxl_result = COMM_TX_FAIL;
+    for (int i = 0; i <= m_policies[DXL_CALL_READ].retries && t_dxl_result != COMM_SUCCESS; i++) {
+        dxl_tx_time = Dynamixel_Clock::get_monotonic_time();
+        t_dxl_result = m_packet_handler->readTxRx(m_port_handler, t_dxl_id, ADDR_REALTIME_TICK, ADDR_STATE_LEN, dxl_data, &t_dxl_error);
+    }
+    double dxl_rx_time = Dynamixel_Clock::get_monotonic_time();
+    m_get_validated_result(t_dxl_result, t_dxl_error);
+
+    Dynamixel_State dxl_state{};
+    dxl_state.id = t_dxl_id;
+    dxl_state.realtime_tick = DXL_MAKEWORD(dxl_data[0], dxl_data[1]);
+    dxl_state.moving = dxl_data[ADDR_MOVING - ADDR_REALTIME_TICK];
+    dxl_state.moving_status = dxl_data[ADDR_MOVING_STATUS - ADDR_REALTIME_TICK];
+    dxl_state.pwm = (int16_t)DXL_MAKEWORD(dxl_data[4], dxl_data[5]);
+    dxl_state.load = (int16_t)DXL_MAKEWORD(dxl_data[6], dxl_data[7]);
+    dxl_state.velocity = (int32_t)DXL_MAKEDWORD(DXL_MAKEWORD(dxl_data[8], dxl_data[9]), DXL_MAKEWORD(dxl_data[10], dxl_data[11]));
+    dxl_state.position = (int32_t)DXL_MAKEDWORD(DXL_MAKEWORD(dxl_data[12], dxl_data[13]), DXL_MAKEWORD(dxl_data[14], dxl_data[15]));
+    if (t_dxl_result == COMM_SUCCESS) {
+        m_clock.set_sample(t_dxl_id, dxl_state.realtime_tick, dxl_tx_time, dxl_rx_time);
+        dxl_state.time = m_clock.get_sample_time(t_dxl_id, dxl_state.realtime_tick);
+    } else {
+        dxl_state.time = dxl_rx_time;
+    }
+    return dxl_state;
+}
+/**
+ * get the clock correlation of all dynamixel's
+ * @return the clock correlation
+ */
+Dynamixel_Clock &Dynamixel::get_clock() {
+    return m_clock;
+}
+/**
+ * get the port handler the dynamixel's are connected to
+ * @return the port handler
+ */
+dynamixel::PortHandler *Dynamixel::get_port_handler() {
+    return m_port_handler;
+}
+/**
+ * get the packet handler of the used protocol
+ * @return the packet handler
+ */
+dynamixel::PacketHandler *Dynamixel::get_packet_handler() {
+    return m_packet_handler;
+}
+/**
+ * get the configured baudrate
+ * @return the baudrate
+ */
+int Dynamixel::get_baud_rate() {
+    return m_baud_rate;
+}
+/**
+ * get the port which computes the packet timeouts and tracks the latency
+ * @return the timeout port
+ */
+Dynamixel_Timeout_Port &Dynamixel::get_timeout_port() {
+    return m_timeout_port;
+}
+/**
+ * read the return delay time of a dynamixel once and use it for the packet timeouts
+ * @param t_dxl_id the identifier of the dynamixel
+ */
+void Dynamixel::set_return_delay(uint8_t t_dxl_id) {
+    m_timeout_port.set_return_delay(get_return_delay_time(t_dxl_id));
+}
+/**
+ * set the retry policy of a call class
+ * @param t_call the call class -> DXL_CALL_READ, DXL_CALL_WRITE, DXL_CALL_GOAL
+ * @param t_policy the policy
+ */
+void Dynamixel::set_policy(Dynamixel_Call t_call, Dynamixel_Policy t_policy) {
+    m_policies[t_call] = t_policy;
+}
+/**
+ * get the retry policy of a call class
+ * @param t_call the call class -> DXL_CALL_READ, DXL_CALL_WRITE, DXL_CALL_GOAL
+ * @return the policy
+ */
+Dynamixel_Policy Dynamixel::get_policy(Dynamixel_Call t_call) {
+    return m_policies[t_call];
+}
+/**
+ * get the worst case time of a single register call including all retries
+ * @param t_call the call class -> DXL_CALL_READ, DXL_CALL_WRITE, DXL_CALL_GOAL
+ * @param t_length the length of the register -> 1, 2, 4
+ * @return the worst case time in seconds
+ */
+double Dynamixel::get_worst_case_time(Dynamixel_Call t_call, uint16_t t_length) {
+    // read: 10 + address + length, status: 11 + data | write: 10 + address + data, status: 11
+    const Dynamixel_Policy &dxl_policy = m_policies[t_call];
+    if (t_call == DXL_CALL_READ) {
+        return m_timeout_port.get_worst_case(14, 11 + t_length, dxl_policy.retries);
+    }
+    return m_timeout_port.get_worst_case(12 + t_length, dxl_policy.acknowledge ? 11 : 0, dxl_policy.retries);
+}
 /**
  * set the torque of a dynamixel
  * @param t_dxl_id the identifier of the dynamixel
@@ -367,7 +485,7 @@ void Dynamixel::set_feedforward_second_gain(uint8_t t_dxl_id, uint16_t t_gain) {
  * @param pwm value -> 0-885
  */
 void Dynamixel::set_goal_pwm(uint8_t t_dxl_id, uint16_t t_pwm) {
-    m_set_medium_register(t_dxl_id, ADDR_GOAL_PWM, t_pwm);
+    m_set_medium_register(t_dxl_id, ADDR_GOAL_PWM, t_pwm, DXL_CALL_GOAL);
 }
 /**
  * set the goal velocity of a dynamixel
@@ -375,7 +493,7 @@ void Dynamixel::set_goal_pwm(uint8_t t_dxl_id, uint16_t t_pwm) {
  * @param goal velocity value -> 0-265
  */
 void Dynamixel::set_goal_velocity(uint8_t t_dxl_id, uint32_t t_velocity) {
-    m_set_large_register(t_dxl_id, ADDR_GOAL_VELOCITY, t_velocity);
+    m_set_large_register(t_dxl_id, ADDR_GOAL_VELOCITY, t_velocity, DXL_CALL_GOAL);
 }
 /**
  * set the goal t_position of a dynamixel
@@ -383,7 +501,7 @@ void Dynamixel::set_goal_velocity(uint8_t t_dxl_id, uint32_t t_velocity) {
  * @param t_position goal t_position value -> 0-4096
  */
 void Dynamixel::set_goal_position(uint8_t t_dxl_id, uint32_t t_position) {
-    m_set_large_register(t_dxl_id, ADDR_GOAL_POSITION, t_position);
+    m_set_large_register(t_dxl_id, ADDR_GOAL_POSITION, t_position, DXL_CALL_GOAL);
 }
 /**
  * set the goal velocity of two dynamixel's
@@ -393,9 +511,7 @@ void Dynamixel::set_goal_position(uint8_t t_dxl_id, uint32_t t_position) {
  * @param t_dxl2_velocity goal velocity value -> 0-265
  */
 void Dynamixel::set_group_goal_velocity(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint32_t t_dxl1_velocity, uint32_t t_dxl2_velocity) {
-    std::vector<uint8_t> dxl1_velocity_data = m_get_group_data(t_dxl1_velocity);
-    std::vector<uint8_t> dxl2_velocity_data = m_get_group_data(t_dxl2_velocity);
-    m_set_group_register(t_dxl1_id, t_dxl2_id, ADDR_GOAL_VELOCITY, dxl1_velocity_data.data(), dxl2_velocity_data.data());
+    m_set_group_register(t_dxl1_id, t_dxl2_id, ADDR_GOAL_VELOCITY, t_dxl1_velocity, t_dxl2_velocity);
 }
 /**
  * set the goal t_position of two dynamixel's
@@ -405,11 +521,78 @@ void Dynamixel::set_group_goal_velocity(uint8_t t_dxl1_id, uint8_t t_dxl2_id, ui
  * @param t_dxl2_position goal t_position value -> 0-4096
  */
 void Dynamixel::set_group_goal_position(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint32_t t_dxl1_position, uint32_t t_dxl2_position) {
-    std::vector<uint8_t> dxl1_position_data = m_get_group_data(t_dxl1_position);
-    std::vector<uint8_t> dxl2_position_data = m_get_group_data(t_dxl2_position);
-    m_set_group_register(t_dxl1_id, t_dxl2_id, ADDR_GOAL_POSITION, dxl1_position_data.data(), dxl2_position_data.data());
+    m_set_group_register(t_dxl1_id, t_dxl2_id, ADDR_GOAL_POSITION, t_dxl1_position, t_dxl2_position);
 }
 
+/**
+ * disable the torque of every dynamixel on the bus with one broadcast packet
+ */
+void Dynamixel::set_broadcast_torque_off() {
+    uint8_t t_dxl_result = m_packet_handler->write1ByteTxOnly(m_port_handler, BROADCAST_ID, ADDR_TORQUE, 0);
+    m_get_validated_result(t_dxl_result, 0);
+}
+/**
+ * set the led of every dynamixel on the bus with one broadcast packet
+ * @param t_led_state enable or disable
+ */
+void Dynamixel::set_broadcast_led(bool t_led_state) {
+    uint8_t t_dxl_result = m_packet_handler->write1ByteTxOnly(m_port_handler, BROADCAST_ID, ADDR_LED, t_led_state);
+    m_get_validated_result(t_dxl_result, 0);
+}
+/**
+ * set the torque of many dynamixel's with one sync write
+ * @param t_dxl_ids the identifiers of the dynamixel's
+ * @param t_torque_state enable or disable
+ */
+void Dynamixel::set_group_torque(const std::vector<uint8_t> &t_dxl_ids, bool t_torque_state) {
+    m_set_fleet_register(t_dxl_ids, ADDR_TORQUE, t_torque_state);
+}
+/**
+ * set the led of many dynamixel's with one sync write
+ * @param t_dxl_ids the identifiers of the dynamixel's
+ * @param t_led_state enable or disable
+ */
+void Dynamixel::set_group_led(const std::vector<uint8_t> &t_dxl_ids, bool t_led_state) {
+    m_set_fleet_register(t_dxl_ids, ADDR_LED, t_led_state);
+}
+/**
+ * set the operating mode of many dynamixel's with one sync write, the torque must be off
+ * @param t_dxl_ids the identifiers of the dynamixel's
+ * @param t_control_mode the operating mode -> ADDR_CONTROL_MODE_VELOCITY, ADDR_CONTROL_MODE_POSITION, ...
+ */
+void Dynamixel::set_group_operating_mode(const std::vector<uint8_t> &t_dxl_ids, uint8_t t_control_mode) {
+    m_set_fleet_register(t_dxl_ids, ADDR_OPERATING_MODE, t_control_mode);
+}
+/**
+ * reboot many dynamixel's, the boot times overlap and all are polled back online with broadcast pings
+ * @param t_dxl_ids the identifiers of the dynamixel's
+ * @param t_timeout the time to wait for all dynamixel's to answer again in seconds | default -> 1.0
+ * @return true if every dynamixel is back online otherwise false
+ */
+bool Dynamixel::set_group_reboot(const std::vector<uint8_t> &t_dxl_ids, double t_timeout) {
+    // a reboot is acknowledged before the dynamixel boots, so the next one is sent right away
+    for (uint8_t dxl_id : t_dxl_ids) {
+        uint8_t t_dxl_error = 0;
+        uint8_t t_dxl_result = m_packet_handler->reboot(m_port_handler, dxl_id, &t_dxl_error);
+        m_get_validated_result(t_dxl_result, t_dxl_error);
+        m_clock.set_reset(dxl_id);
+    }
+    std::vector<uint8_t> dxl_missing(t_dxl_ids);
+    std::vector<uint8_t> dxl_found;
+    double dxl_deadline = Dynamixel_Clock::get_monotonic_time() + t_timeout;
+    while (!dxl_missing.empty() && Dynamixel_Clock::get_monotonic_time() < dxl_deadline) {
+        if (m_packet_handler->broadcastPing(m_port_handler, dxl_found) != COMM_SUCCESS) {
+            continue;
+        }
+        dxl_missing.erase(std::remove_if(dxl_missing.begin(), dxl_missing.end(), [&](uint8_t t_dxl_id) {
+            return std::find(dxl_found.begin(), dxl_found.end(), t_dxl_id) != dxl_found.end();
+        }), dxl_missing.end());
+    }
+    for (uint8_t dxl_id : dxl_missing) {
+        printf("failed: id: %i not back online\n", dxl_id);
+    }
+    return dxl_missing.empty();
+}
 // MARK: - Private Functions to read/write to dynamixel register
 /**
  * validate the transmitted result
@@ -424,34 +607,6 @@ void Dynamixel::m_get_validated_result(uint8_t t_dxl_result, uint8_t t_dxl_error
         printf("%s", m_packet_handler->getRxPacketError(t_dxl_error));
     }
 }
-/**
- * validate given parameters
- * @param t_dxl1_id dynamixel first identifier
- * @param t_dxl2_id dynamixel second identifier
- * @param t_dxl1_param dynamixel first parameter
- * @param t_dxl2_param dynamixel second parameter
- */
-void Dynamixel::m_get_validated_param(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint8_t t_dxl1_param, uint8_t t_dxl2_param) {
-    if (!t_dxl1_param) {
-        printf("failed: param not added for id: %i\n", t_dxl1_id);
-    }
-    if (!t_dxl2_param) {
-        printf("failed: param not added for id: %i\n", t_dxl2_id);
-    }
-}
-/**
- * map a value and return it as 4 byte data array
- * @param value the input value
- * @return the mapped array
- */
-std::vector<uint8_t> Dynamixel::m_get_group_data(uint32_t t_value) {
-    std::vector<uint8_t> param_data = std::vector<uint8_t>(4);
-    param_data.insert(param_data.begin() + 0, DXL_LOBYTE(DXL_LOWORD(t_value)));
-    param_data.insert(param_data.begin() + 1, DXL_HIBYTE(DXL_LOWORD(t_value)));
-    param_data.insert(param_data.begin() + 2, DXL_LOBYTE(DXL_HIWORD(t_value)));
-    param_data.insert(param_data.begin() + 3, DXL_HIBYTE(DXL_HIWORD(t_value)));
-    return param_data;
-}
 /**
  * read from a dynamixel small register
  * @param t_dxl_id the dynamixel identifier
@@ -459,9 +614,12 @@ std::vector<uint8_t> Dynamixel::m_get_group_data(uint32_t t_value) {
  * @return the value which was read
  */
 uint8_t Dynamixel::m_get_small_register(uint8_t t_dxl_id, uint16_t t_address) {
-    uint8_t t_dxl_error;
-    uint8_t dxl_value;
-    uint8_t t_dxl_result = m_packet_handler->read1ByteTxRx(m_port_handler, t_dxl_id, t_address, (uint8_t*)&dxl_value, &t_dxl_error);
+    uint8_t t_dxl_error = 0;
+    uint8_t dxl_value = 0;
+    int t_dxl_result = COMM_TX_FAIL;
+    for (int i = 0; i <= m_policies[DXL_CALL_READ].retries && t_dxl_result != COMM_SUCCESS; i++) {
+        t_dxl_result = m_packet_handler->read1ByteTxRx(m_port_handler, t_dxl_id, t_address, (uint8_t*)&dxl_value, &t_dxl_error);
+    }
     m_get_validated_result(t_dxl_result, t_dxl_error);
     return dxl_value;
 }
@@ -472,9 +630,12 @@ uint8_t Dynamixel::m_get_small_register(uint8_t t_dxl_id, uint16_t t_address) {
  * @return the value which was read
  */
 uint16_t Dynamixel::m_get_medium_register(uint8_t t_dxl_id, uint16_t t_address) {
-    uint8_t t_dxl_error;
-    uint16_t dxl_value;
-    uint8_t t_dxl_result = m_packet_handler->read2ByteTxRx(m_port_handler, t_dxl_id, t_address, (uint16_t*)&dxl_value, &t_dxl_error);
+    uint8_t t_dxl_error = 0;
+    uint16_t dxl_value = 0;
+    int t_dxl_result = COMM_TX_FAIL;
+    for (int i = 0; i <= m_policies[DXL_CALL_READ].retries && t_dxl_result != COMM_SUCCESS; i++) {
+        t_dxl_result = m_packet_handler->read2ByteTxRx(m_port_handler, t_dxl_id, t_address, (uint16_t*)&dxl_value, &t_dxl_error);
+    }
     m_get_validated_result(t_dxl_result, t_dxl_error);
     return dxl_value;
 }
@@ -485,9 +646,12 @@ uint16_t Dynamixel::m_get_medium_register(uint8_t t_dxl_id, uint16_t t_address)
  * @return the value which was read
  */
 uint32_t Dynamixel::m_get_large_register(uint8_t t_dxl_id, uint16_t t_address) {
-    uint8_t t_dxl_error;
-    uint32_t dxl_value;
-    uint8_t t_dxl_result = m_packet_handler->read4ByteTxRx(m_port_handler, t_dxl_id, t_address, (uint32_t*)&dxl_value, &t_dxl_error);
+    uint8_t t_dxl_error = 0;
+    uint32_t dxl_value = 0;
+    int t_dxl_result = COMM_TX_FAIL;
+    for (int i = 0; i <= m_policies[DXL_CALL_READ].retries && t_dxl_result != COMM_SUCCESS; i++) {
+        t_dxl_result = m_packet_handler->read4ByteTxRx(m_port_handler, t_dxl_id, t_address, (uint32_t*)&dxl_value, &t_dxl_error);
+    }
     m_get_validated_result(t_dxl_result, t_dxl_error);
     return dxl_value;
 }
@@ -496,10 +660,18 @@ uint32_t Dynamixel::m_get_large_register(uint8_t t_dxl_id, uint16_t t_address) {
  * @param t_dxl_id dynamixel identifier
  * @param t_address the address to write to
  * @param value the value to be written -> small write uint8_t value
- */
-void Dynamixel::m_set_small_register(uint8_t t_dxl_id, uint16_t t_address, uint8_t t_value) {
-    uint8_t t_dxl_error;
-    uint8_t t_dxl_result = m_packet_handler->write1ByteTxRx(m_port_handler, t_dxl_id, t_address, t_value, &t_dxl_error);
+ * @param t_call the call class which selects the retry policy
+ */
+void Dynamixel::m_set_small_register(uint8_t t_dxl_id, uint16_t t_address, uint8_t t_value, Dynamixel_Call t_call) {
+    uint8_t t_dxl_error = 0;
+    int t_dxl_result = COMM_TX_FAIL;
+    for (int i = 0; i <= m_policies[t_call].retries && t_dxl_result != COMM_SUCCESS; i++) {
+        if (m_policies[t_call].acknowledge) {
+            t_dxl_result = m_packet_handler->write1ByteTxRx(m_port_handler, t_dxl_id, t_address, t_value, &t_dxl_error);
+        } else {
+            t_dxl_result = m_packet_handler->write1ByteTxOnly(m_port_handler, t_dxl_id, t_address, t_value);
+        }
+    }
     m_get_validated_result(t_dxl_result, t_dxl_error);
 }
 /**
@@ -507,10 +679,18 @@ void Dynamixel::m_set_small_register(uint8_t t_dxl_id, uint16_t t_address, uint8
  * @param t_dxl_id dynamixel identifier
  * @param t_address the address to write to
  * @param t_value the value to be written -> medium write uint16_t value
- */
-void Dynamixel::m_set_medium_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_value) {
-    uint8_t t_dxl_error;
-    uint8_t t_dxl_result = m_packet_handler->write2ByteTxRx(m_port_handler, t_dxl_id, t_address, t_value, &t_dxl_error);
+ * @param t_call the call class which selects the retry policy
+ */
+void Dynamixel::m_set_medium_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_value, Dynamixel_Call t_call) {
+    uint8_t t_dxl_error = 0;
+    int t_dxl_result = COMM_TX_FAIL;
+    for (int i = 0; i <= m_policies[t_call].retries && t_dxl_result != COMM_SUCCESS; i++) {
+        if (m_policies[t_call].acknowledge) {
+            t_dxl_result = m_packet_handler->write2ByteTxRx(m_port_handler, t_dxl_id, t_address, t_value, &t_dxl_error);
+        } else {
+            t_dxl_result = m_packet_handler->write2ByteTxOnly(m_port_handler, t_dxl_id, t_address, t_value);
+        }
+    }
     m_get_validated_result(t_dxl_result, t_dxl_error);
 }
 /**
@@ -518,10 +698,18 @@ void Dynamixel::m_set_medium_register(uint8_t t_dxl_id, uint16_t t_address, uint
  * @param t_dxl_id dynamixel identifier
  * @param t_address the address to write to
  * @param value the value to be written -> large write uint32_t value
- */
-void Dynamixel::m_set_large_register(uint8_t t_dxl_id, uint16_t t_address, uint32_t t_value) {
-    uint8_t t_dxl_error;
-    uint8_t t_dxl_result = m_packet_handler->write4ByteTxRx(m_port_handler, t_dxl_id, t_address, t_value, &t_dxl_error);
+ * @param t_call the call class which selects the retry policy
+ */
+void Dynamixel::m_set_large_register(uint8_t t_dxl_id, uint16_t t_address, uint32_t t_value, Dynamixel_Call t_call) {
+    uint8_t t_dxl_error = 0;
+    int t_dxl_result = COMM_TX_FAIL;
+    for (int i = 0; i <= m_policies[t_call].retries && t_dxl_result != COMM_SUCCESS; i++) {
+        if (m_policies[t_call].acknowledge) {
+            t_dxl_result = m_packet_handler->write4ByteTxRx(m_port_handler, t_dxl_id, t_address, t_value, &t_dxl_error);
+        } else {
+            t_dxl_result = m_packet_handler->write4ByteTxOnly(m_port_handler, t_dxl_id, t_address, t_value);
+        }
+    }
     m_get_validated_result(t_dxl_result, t_dxl_error);
 }
 /**
@@ -532,12 +720,50 @@ void Dynamixel::m_set_large_register(uint8_t t_dxl_id, uint16_t t_address, uint3
  * @param t_dxl1_value the value to be written for the first dynamixel
  * @param t_dxl2_value the value to be written for the second dynamixel
  */
-void Dynamixel::m_set_group_register(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint16_t t_address, uint8_t *t_dxl1_value, uint8_t *t_dxl2_value) {
-    uint8_t t_dxl1_param = m_group_bulk_write.addParam(t_dxl1_id, t_address, ADDR_GROUP_WRITE_LEN, t_dxl1_value);
-    uint8_t t_dxl2_param = m_group_bulk_write.addParam(t_dxl2_id, t_address, ADDR_GROUP_WRITE_LEN, t_dxl2_value);
-    m_get_validated_param(t_dxl1_id, t_dxl2_id, t_dxl1_param, t_dxl2_param);
-
-    uint8_t t_dxl_result = m_group_bulk_write.txPacket();
+void Dynamixel::m_set_group_register(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint16_t t_address, uint32_t t_dxl1_value, uint32_t t_dxl2_value) {
+    Dynamixel_Tick_Guard dxl_guard("Dynamixel::m_set_group_register");
+    if (t_dxl1_id == t_dxl2_id) {
+        printf("failed: param not added for id: %i\n", t_dxl2_id);
+        return;
+    }
+    // the packet is encoded into the member buffers, a group write doesn't allocate
+    m_group_param[0] = DXL_LOBYTE(t_address);
+    m_group_param[1] = DXL_HIBYTE(t_address);
+    m_group_param[2] = DXL_LOBYTE(ADDR_GROUP_WRITE_LEN);
+    m_group_param[3] = DXL_HIBYTE(ADDR_GROUP_WRITE_LEN);
+    uint8_t dxl_ids[2] = {t_dxl1_id, t_dxl2_id};
+    uint32_t dxl_values[2] = {t_dxl1_value, t_dxl2_value};
+    for (size_t i = 0; i < 2; i++) {
+        uint8_t *dxl_param = m_group_param.data() + 4 + i * (1 + ADDR_GROUP_WRITE_LEN);
+        dxl_param[0] = dxl_ids[i];
+        dxl_param[1] = DXL_LOBYTE(DXL_LOWORD(dxl_values[i]));
+        dxl_param[2] = DXL_HIBYTE(DXL_LOWORD(dxl_values[i]));
+        dxl_param[3] = DXL_LOBYTE(DXL_HIWORD(dxl_values[i]));
+        dxl_param[4] = DXL_HIBYTE(DXL_HIWORD(dxl_values[i]));
+    }
+    size_t dxl_packet_length = Dynamixel_Packet::set_instruction(m_group_packet.data(), m_group_packet.size(), BROADCAST_ID, INST_SYNC_WRITE, m_group_param.data(), m_group_param.size());
+    int t_dxl_result = Dynamixel_Packet::set_transmit(m_port_handler, m_group_packet.data(), dxl_packet_length);
+    m_get_validated_result(t_dxl_result, 0);
+}
+/**
+ * write the same value into a small register of many dynamixel's with one sync write
+ * @param t_dxl_ids the identifiers of the dynamixel's
+ * @param t_address the address to be written
+ * @param t_value the value to be written
+ */
+void Dynamixel::m_set_fleet_register(const std::vector<uint8_t> &t_dxl_ids, uint16_t t_address, uint8_t t_value) {
+    uint8_t dxl_param[2 * BROADCAST_ID];
+    uint16_t dxl_length = 0;
+    for (uint8_t dxl_id : t_dxl_ids) {
+        if (dxl_length == sizeof(dxl_param)) {
+            break;
+        }
+        dxl_param[dxl_length++] = dxl_id;
+        dxl_param[dxl_length++] = t_value;
+    }
+    if (dxl_length == 0) {
+        return;
+    }
+    uint8_t t_dxl_result = m_packet_handler->syncWriteTxOnly(m_port_handler, t_address, 1, dxl_param, dxl_length);
     m_get_validated_result(t_dxl_result, 0);
-    m_group_bulk_write.clearParam();
 }
\ No newline at end of file
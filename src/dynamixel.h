@@ -22,9 +22,82 @@
 
 #include <cstdio>
 #include <cstdint>
+#include <array>
 #include <vector>
 #include <dynamixel_sdk.h>
 #include "dynamixel_address_table.h"
+#include "dynamixel_clock.h"
+#include "dynamixel_packet.h"
+#include "dynamixel_timeout.h"
+
+#define DXL_GROUP_PARAM_LEN (4 + 2 * (1 + ADDR_GROUP_WRITE_LEN))
+#define DXL_GROUP_PACKET_LEN (DXL_INSTRUCTION_FRAME_LEN + DXL_GROUP_PARAM_LEN + DXL_GROUP_PARAM_LEN / 3)
+
+/**
+ * a time stamped state snapshot of a dynamixel
+ */
+struct Dynamixel_State {
+    /**
+     * the identifier of the dynamixel
+     */
+    uint8_t id;
+    /**
+     * the realtime tick at which the dynamixel took the sample
+     */
+    uint16_t realtime_tick;
+    /**
+     * the moving flag
+     */
+    uint8_t moving;
+    /**
+     * the moving status
+     */
+    uint8_t moving_status;
+    /**
+     * the present pwm
+     */
+    int16_t pwm;
+    /**
+     * the present load
+     */
+    int16_t load;
+    /**
+     * the present velocity
+     */
+    int32_t velocity;
+    /**
+     * the present position
+     */
+    int32_t position;
+    /**
+     * the host time of the sample in seconds
+     */
+    double time;
+};
+
+/**
+ * the classes of calls which have their own retry policy
+ */
+enum Dynamixel_Call {
+    DXL_CALL_READ = 0,
+    DXL_CALL_WRITE = 1,
+    DXL_CALL_GOAL = 2,
+    DXL_CALL_COUNT = 3
+};
+
+/**
+ * the retry policy of a call class
+ */
+struct Dynamixel_Policy {
+    /**
+     * the amount of retries after a failed call
+     */
+    int retries;
+    /**
+     * false to send without waiting for a status (a lost goal is replaced by the next one anyway)
+     */
+    bool acknowledge;
+};
 
 class Dynamixel {
 // public declaration
@@ -40,6 +113,18 @@ public:
             m_protocol_version(t_protocol_version),
             m_baud_rate(t_baud_rate) {
     };
+    /**
+     * initialize dynamixel class on top of an existing port, e.g. a capture or replay port
+     * @param t_port_handler the port handler, must outlive the dynamixel class
+     * @param t_protocol_version the protocol version | default -> 2.0
+     * @param t_baud_rate the baudrate | default -> 1_000_000
+     */
+    explicit Dynamixel(dynamixel::PortHandler *t_port_handler, float t_protocol_version = 2.0, int t_baud_rate = 1000000):
+            m_device_name(t_port_handler->getPortName()),
+            m_protocol_version(t_protocol_version),
+            m_baud_rate(t_baud_rate),
+            m_timeout_port(t_port_handler, t_baud_rate) {
+    };
     /**
      * open a connection to the dynamixel
      * @return true if success otherwise false
@@ -95,6 +180,12 @@ public:
      * @return the dynamixel operating mode value
      */
     uint8_t get_operating_mode(uint8_t t_dxl_id);
+    /**
+     * get the current return delay time of a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return the dynamixel return delay time value (2 usec units)
+     */
+    uint8_t get_return_delay_time(uint8_t t_dxl_id);
     /**
      * get the current firmware version of a dynamixel
      * @param t_dxl_id the identifier of the dynamixel
@@ -197,6 +288,61 @@ public:
      * @return the dynamixel present t_position value
      */
     uint32_t get_present_position(uint8_t t_dxl_id);
+    /**
+     * get a time stamped state snapshot of a dynamixel (realtime tick up to present position in one read)
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return the state snapshot
+     */
+    Dynamixel_State get_state(uint8_t t_dxl_id);
+    /**
+     * get the clock correlation of all dynamixel's
+     * @return the clock correlation
+     */
+    Dynamixel_Clock &get_clock();
+    /**
+     * get the port handler the dynamixel's are connected to
+     * @return the port handler
+     */
+    dynamixel::PortHandler *get_port_handler();
+    /**
+     * get the packet handler of the used protocol
+     * @return the packet handler
+     */
+    dynamixel::PacketHandler *get_packet_handler();
+    /**
+     * get the configured baudrate
+     * @return the baudrate
+     */
+    int get_baud_rate();
+    /**
+     * get the port which computes the packet timeouts and tracks the latency
+     * @return the timeout port
+     */
+    Dynamixel_Timeout_Port &get_timeout_port();
+    /**
+     * read the return delay time of a dynamixel once and use it for the packet timeouts
+     * @param t_dxl_id the identifier of the dynamixel
+     */
+    void set_return_delay(uint8_t t_dxl_id);
+    /**
+     * set the retry policy of a call class
+     * @param t_call the call class -> DXL_CALL_READ, DXL_CALL_WRITE, DXL_CALL_GOAL
+     * @param t_policy the policy
+     */
+    void set_policy(Dynamixel_Call t_call, Dynamixel_Policy t_policy);
+    /**
+     * get the retry policy of a call class
+     * @param t_call the call class -> DXL_CALL_READ, DXL_CALL_WRITE, DXL_CALL_GOAL
+     * @return the policy
+     */
+    Dynamixel_Policy get_policy(Dynamixel_Call t_call);
+    /**
+     * get the worst case time of a single register call including all retries
+     * @param t_call the call class -> DXL_CALL_READ, DXL_CALL_WRITE, DXL_CALL_GOAL
+     * @param t_length the length of the register -> 1, 2, 4
+     * @return the worst case time in seconds
+     */
+    double get_worst_case_time(Dynamixel_Call t_call, uint16_t t_length);
     /**
      * set the torque of a dynamixel
      * @param t_dxl_id the identifier of the dynamixel
@@ -309,6 +455,40 @@ public:
      * @param t_dxl2_position goal t_position value -> 0-4096
      */
     void set_group_goal_position(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint32_t t_dxl1_position, uint32_t t_dxl2_position);
+    /**
+     * disable the torque of every dynamixel on the bus with one broadcast packet
+     */
+    void set_broadcast_torque_off();
+    /**
+     * set the led of every dynamixel on the bus with one broadcast packet
+     * @param t_led_state enable or disable
+     */
+    void set_broadcast_led(bool t_led_state);
+    /**
+     * set the torque of many dynamixel's with one sync write
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     * @param t_torque_state enable or disable
+     */
+    void set_group_torque(const std::vector<uint8_t> &t_dxl_ids, bool t_torque_state);
+    /**
+     * set the led of many dynamixel's with one sync write
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     * @param t_led_state enable or disable
+     */
+    void set_group_led(const std::vector<uint8_t> &t_dxl_ids, bool t_led_state);
+    /**
+     * set the operating mode of many dynamixel's with one sync write, the torque must be off
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     * @param t_control_mode the operating mode -> ADDR_CONTROL_MODE_VELOCITY, ADDR_CONTROL_MODE_POSITION, ...
+     */
+    void set_group_operating_mode(const std::vector<uint8_t> &t_dxl_ids, uint8_t t_control_mode);
+    /**
+     * reboot many dynamixel's, the boot times overlap and all are polled back online with broadcast pings
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     * @param t_timeout the time to wait for all dynamixel's to answer again in seconds | default -> 1.0
+     * @return true if every dynamixel is back online otherwise false
+     */
+    bool set_group_reboot(const std::vector<uint8_t> &t_dxl_ids, double t_timeout = 1.0);
 
 // private declaration
 private:
@@ -328,34 +508,36 @@ private:
      * set up packet handler
      */
     dynamixel::PacketHandler *m_packet_handler = dynamixel::PacketHandler::getPacketHandler(m_protocol_version);
+    /**
+     * set up the timeout port around the port handler of the sdk
+     */
+    Dynamixel_Timeout_Port m_timeout_port = Dynamixel_Timeout_Port(dynamixel::PortHandler::getPortHandler(m_device_name), m_baud_rate);
     /**
      * set up port handler
      */
-    dynamixel::PortHandler *m_port_handler = dynamixel::PortHandler::getPortHandler(m_device_name);
+    dynamixel::PortHandler *m_port_handler = &m_timeout_port;
     /**
-     * set up bulk write
+     * the sync write parameters of a group write, reused every call
      */
-    dynamixel::GroupBulkWrite m_group_bulk_write = dynamixel::GroupBulkWrite(m_port_handler, m_packet_handler);
+    std::array<uint8_t, DXL_GROUP_PARAM_LEN> m_group_param{};
     /**
-     * validate the transmitted result
-     * @param t_dxl_result the result value
-     * @param t_dxl_error the 'possible' error value
+     * the encoded sync write packet of a group write, reused every call
      */
-    void m_get_validated_result(uint8_t t_dxl_result, uint8_t t_dxl_error);
+    std::array<uint8_t, DXL_GROUP_PACKET_LEN> m_group_packet{};
     /**
-     * validate given parameters
-     * @param t_dxl1_id dynamixel first identifier
-     * @param t_dxl2_id dynamixel second identifier
-     * @param t_dxl1_param dynamixel first parameter
-     * @param t_dxl2_param dynamixel second parameter
+     * correlate realtime ticks with the host clock
      */
-    void m_get_validated_param(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint8_t t_dxl1_param, uint8_t t_dxl2_param);
+    Dynamixel_Clock m_clock = Dynamixel_Clock();
     /**
-     * map a value and return it as 4 byte data array
-     * @param value the input value
-     * @return the mapped array
+     * the retry policies -> reads are retried, stale goals are dropped
      */
-    std::vector<uint8_t> m_get_group_data(uint32_t t_value);
+    Dynamixel_Policy m_policies[DXL_CALL_COUNT] = {{2, true}, {1, true}, {0, true}};
+    /**
+     * validate the transmitted result
+     * @param t_dxl_result the result value
+     * @param t_dxl_error the 'possible' error value
+     */
+    void m_get_validated_result(uint8_t t_dxl_result, uint8_t t_dxl_error);
     /**
      * read from a dynamixel small register
      * @param t_dxl_id the dynamixel identifier
@@ -382,22 +564,25 @@ private:
      * @param t_dxl_id dynamixel identifier
      * @param t_address the address to write to
      * @param value the value to be written -> small write uint8_t value
+     * @param t_call the call class which selects the retry policy
      */
-    void m_set_small_register(uint8_t t_dxl_id, uint16_t t_address, uint8_t t_value);
+    void m_set_small_register(uint8_t t_dxl_id, uint16_t t_address, uint8_t t_value, Dynamixel_Call t_call = DXL_CALL_WRITE);
     /**
      * write on dynamixel medium register
      * @param t_dxl_id dynamixel identifier
      * @param t_address the address to write to
      * @param t_value the value to be written -> medium write uint16_t value
+     * @param t_call the call class which selects the retry policy
      */
-    void m_set_medium_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_value);
+    void m_set_medium_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_value, Dynamixel_Call t_call = DXL_CALL_WRITE);
     /**
      * write on dynamixel large register
      * @param t_dxl_id dynamixel identifier
      * @param t_address the address to write to
      * @param t_value the value to be written -> large write uint32_t value
+     * @param t_call the call class which selects the retry policy
      */
-    void m_set_large_register(uint8_t t_dxl_id, uint16_t t_address, uint32_t t_value);
+    void m_set_large_register(uint8_t t_dxl_id, uint16_t t_address, uint32_t t_value, Dynamixel_Call t_call = DXL_CALL_WRITE);
     /**
      * write on a group register (write against two dynamixel)
      * @param t_dxl1_id first dynamixel identifier
@@ -406,7 +591,14 @@ private:
      * @param t_dxl1_value the t_value to be written for the first dynamixel
      * @param t_dxl2_value the t_value to be written for the second dynamixel
      */
-    void m_set_group_register(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint16_t t_address, uint8_t *t_dxl1_value, uint8_t *t_dxl2_value);
+    void m_set_group_register(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint16_t t_address, uint32_t t_dxl1_value, uint32_t t_dxl2_value);
+    /**
+     * write the same value into a small register of many dynamixel's with one sync write
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     * @param t_address the address to be written
+     * @param t_value the value to be written
+     */
+    void m_set_fleet_register(const std::vector<uint8_t> &t_dxl_ids, uint16_t t_address, uint8_t t_value);
 };
 
 #endif
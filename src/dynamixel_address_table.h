@@ -79,14 +79,18 @@ enum Dynamixel_Address_Table {
     ADDR_POSITION_TRAJECTORY = 140,
     ADDR_PRESENT_INPUT_VOLTAGE = 144,
     ADDR_PRESENT_TEMPERATURE = 146,
+    ADDR_INDIRECT_ADDRESS_1 = 168,
+    ADDR_INDIRECT_DATA_1 = 224,
 
     /**
      * dynamixel specific codes
      */
     ADDR_GROUP_WRITE_LEN = 4,
+    ADDR_STATE_LEN = 16,
     ADDR_CONTROL_MODE_VELOCITY = 1,
     ADDR_CONTROL_MODE_POSITION = 3,
     ADDR_CONTROL_MODE_EXTENDED_POSITION = 4,
+    ADDR_CONTROL_MODE_CURRENT_POSITION = 5,
     ADDR_CONTROL_MODE_PWM = 16,
     ADDR_DRIVE_MODE_NORMAL = 0,
     ADDR_DRIVE_MODE_REVERSED = 1,
@@ -0,0 +1,191 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include "dynamixel_audit.h"
+#include "dynamixel_arbiter.h"
+
+/**
+ * stop the flush thread if it is running
+ */
+Dynamixel_Arbiter::~Dynamixel_Arbiter() {
+    set_stop();
+}
+/**
+ * allow writes to a register (setup only, not thread safe)
+ * @param t_address the address of the register
+ * @param t_length the length of the register -> 1, 2 or 4
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Arbiter::set_register(uint16_t t_address, uint16_t t_length) {
+    if (m_get_register(t_address) != nullptr) {
+        return true;
+    }
+    if (m_register_count >= DXL_ARBITER_MAX_REGISTERS || (t_length != 1 && t_length != 2 && t_length != 4)) {
+        printf("failed: register not added for address: %i\n", t_address);
+        return false;
+    }
+    m_registers[m_register_count].address = t_address;
+    m_registers[m_register_count].length = t_length;
+    m_register_count++;
+    return true;
+}
+/**
+ * submit a write and wait until it is on the wire (thread safe, lock free),
+ * never call it from the thread which runs set_flush, it would wait for itself forever
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_address the address of the register
+ * @param t_value the value to be written
+ * @return true if the write was transmitted
+ */
+bool Dynamixel_Arbiter::set_goal(uint8_t t_dxl_id, uint16_t t_address, uint32_t t_value) {
+    Dynamixel_Arbiter_Register *dxl_register = m_get_register(t_address);
+    if (dxl_register == nullptr || t_dxl_id >= DXL_ARBITER_MAX_IDS) {
+        printf("failed: no writable register %i for id: %i\n", t_address, t_dxl_id);
+        return false;
+    }
+    dxl_register->values[t_dxl_id].store(t_value, std::memory_order_relaxed);
+    dxl_register->dirty[t_dxl_id].store(true, std::memory_order_seq_cst);
+    // the flag is set before the window is read, so the flush of this window is guaranteed to see it
+    uint64_t dxl_epoch = m_open_epoch.load(std::memory_order_seq_cst);
+    while (m_flushed_epoch.load(std::memory_order_acquire) < dxl_epoch) {
+        std::this_thread::yield();
+    }
+    // the flag may have been taken by the window before, so the outcome of the window which sent it counts,
+    // a later window may already have marked the next goal of this id as sent without a published outcome
+    uint64_t dxl_sent = std::min(dxl_register->sent[t_dxl_id].load(std::memory_order_acquire), dxl_epoch);
+    uint64_t dxl_outcome = m_outcomes[dxl_sent % DXL_ARBITER_OUTCOMES].load(std::memory_order_acquire);
+    if ((dxl_outcome >> 1) != dxl_sent) {
+        printf("failed: outcome of the write for id: %i is gone\n", t_dxl_id);
+        return false;
+    }
+    return (dxl_outcome & 1) == 0;
+}
+/**
+ * submit a goal position and wait until it is on the wire
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_position goal position value -> 0-4096
+ * @return true if the write was transmitted
+ */
+bool Dynamixel_Arbiter::set_goal_position(uint8_t t_dxl_id, uint32_t t_position) {
+    return set_goal(t_dxl_id, ADDR_GOAL_POSITION, t_position);
+}
+/**
+ * submit a goal velocity and wait until it is on the wire
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_velocity goal velocity value -> 0-265
+ * @return true if the write was transmitted
+ */
+bool Dynamixel_Arbiter::set_goal_velocity(uint8_t t_dxl_id, uint32_t t_velocity) {
+    return set_goal(t_dxl_id, ADDR_GOAL_VELOCITY, t_velocity);
+}
+/**
+ * close the current tick window and send one sync write per register
+ * @return the amount of values which were written
+ */
+uint32_t Dynamixel_Arbiter::set_flush() {
+    Dynamixel_Tick_Guard dxl_guard("Dynamixel_Arbiter::set_flush");
+    uint64_t dxl_epoch = m_open_epoch.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t dxl_written = 0;
+    bool dxl_failed = false;
+
+    for (uint32_t i = 0; i < m_register_count; i++) {
+        Dynamixel_Arbiter_Register &dxl_register = m_registers[i];
+        size_t dxl_length = 4;
+        uint32_t dxl_count = 0;
+        for (uint8_t dxl_id = 0; dxl_id < DXL_ARBITER_MAX_IDS; dxl_id++) {
+            if (!dxl_register.dirty[dxl_id].exchange(false, std::memory_order_acq_rel)) {
+                continue;
+            }
+            uint32_t dxl_value = dxl_register.values[dxl_id].load(std::memory_order_relaxed);
+            dxl_register.sent[dxl_id].store(dxl_epoch, std::memory_order_relaxed);
+            m_param[dxl_length++] = dxl_id;
+            for (uint16_t j = 0; j < dxl_register.length; j++) {
+                m_param[dxl_length++] = (uint8_t)(dxl_value >> (8 * j));
+            }
+            dxl_count++;
+        }
+        if (dxl_count == 0) {
+            continue;
+        }
+        m_param[0] = DXL_LOBYTE(dxl_register.address);
+        m_param[1] = DXL_HIBYTE(dxl_register.address);
+        m_param[2] = DXL_LOBYTE(dxl_register.length);
+        m_param[3] = DXL_HIBYTE(dxl_register.length);
+
+        size_t dxl_packet_length = Dynamixel_Packet::set_instruction(m_packet.data(), m_packet.size(), BROADCAST_ID, INST_SYNC_WRITE, m_param.data(), dxl_length);
+        int t_dxl_result = Dynamixel_Packet::set_transmit(m_dynamixel.get_port_handler(), m_packet.data(), dxl_packet_length);
+        if (t_dxl_result != COMM_SUCCESS) {
+            printf("%s", m_dynamixel.get_packet_handler()->getTxRxResult(t_dxl_result));
+            dxl_failed = true;
+            continue;
+        }
+        dxl_written += dxl_count;
+    }
+    m_outcomes[dxl_epoch % DXL_ARBITER_OUTCOMES].store(dxl_epoch << 1 | (dxl_failed ? 1 : 0), std::memory_order_release);
+    m_flushed_epoch.store(dxl_epoch, std::memory_order_release);
+    return dxl_written;
+}
+/**
+ * flush in a background thread at the end of every tick window
+ * @param t_window the tick window in seconds
+ */
+void Dynamixel_Arbiter::set_start(double t_window) {
+    if (m_running.exchange(true)) {
+        return;
+    }
+    m_thread = std::thread([this, t_window]() {
+        auto dxl_window = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(t_window));
+        auto dxl_deadline = std::chrono::steady_clock::now() + dxl_window;
+        while (m_running.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_until(dxl_deadline);
+            set_flush();
+            dxl_deadline += dxl_window;
+        }
+        // release everybody who submitted while stopping
+        set_flush();
+    });
+}
+/**
+ * stop the background flush thread
+ */
+void Dynamixel_Arbiter::set_stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+// MARK: - Private Functions
+/**
+ * find a writable register
+ * @param t_address the address of the register
+ * @return the register or nullptr
+ */
+Dynamixel_Arbiter::Dynamixel_Arbiter_Register *Dynamixel_Arbiter::m_get_register(uint16_t t_address) {
+    for (uint32_t i = 0; i < m_register_count; i++) {
+        if (m_registers[i].address == t_address) {
+            return &m_registers[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,159 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_ARBITER_H
+#define DYNAMIXEL_DYNAMIXEL_ARBITER_H
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <thread>
+#include "dynamixel.h"
+#include "dynamixel_packet.h"
+
+#define DXL_ARBITER_MAX_REGISTERS 8
+#define DXL_ARBITER_MAX_IDS 253
+#define DXL_ARBITER_PARAM_LEN (4 + DXL_ARBITER_MAX_IDS * 5)
+#define DXL_ARBITER_PACKET_LEN (DXL_INSTRUCTION_FRAME_LEN + DXL_ARBITER_PARAM_LEN + DXL_ARBITER_PARAM_LEN / 3)
+#define DXL_ARBITER_OUTCOMES 64
+
+/**
+ * accepts goal writes from many threads and merges everything submitted
+ * within a tick window into one sync write per register (last writer wins)
+ */
+class Dynamixel_Arbiter {
+// public declaration
+public:
+    /**
+     * initialize the arbiter
+     * @param t_dynamixel the dynamixel bus to write to
+     */
+    explicit Dynamixel_Arbiter(Dynamixel &t_dynamixel):
+            m_dynamixel(t_dynamixel) {
+    };
+    /**
+     * stop the flush thread if it is running
+     */
+    ~Dynamixel_Arbiter();
+    /**
+     * allow writes to a register (setup only, not thread safe)
+     * @param t_address the address of the register
+     * @param t_length the length of the register -> 1, 2 or 4
+     * @return true if success otherwise false
+     */
+    bool set_register(uint16_t t_address, uint16_t t_length);
+    /**
+     * submit a write and wait until it is on the wire (thread safe, lock free),
+     * never call it from the thread which runs set_flush, it would wait for itself forever
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the address of the register
+     * @param t_value the value to be written
+     * @return true if the write was transmitted
+     */
+    bool set_goal(uint8_t t_dxl_id, uint16_t t_address, uint32_t t_value);
+    /**
+     * submit a goal position and wait until it is on the wire
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_position goal position value -> 0-4096
+     * @return true if the write was transmitted
+     */
+    bool set_goal_position(uint8_t t_dxl_id, uint32_t t_position);
+    /**
+     * submit a goal velocity and wait until it is on the wire
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_velocity goal velocity value -> 0-265
+     * @return true if the write was transmitted
+     */
+    bool set_goal_velocity(uint8_t t_dxl_id, uint32_t t_velocity);
+    /**
+     * close the current tick window and send one sync write per register
+     * @return the amount of values which were written
+     */
+    uint32_t set_flush();
+    /**
+     * flush in a background thread at the end of every tick window
+     * @param t_window the tick window in seconds
+     */
+    void set_start(double t_window);
+    /**
+     * stop the background flush thread
+     */
+    void set_stop();
+
+// private declaration
+private:
+    /**
+     * the pending writes of a register
+     */
+    struct Dynamixel_Arbiter_Register {
+        uint16_t address = 0;
+        uint16_t length = 0;
+        std::array<std::atomic<uint32_t>, DXL_ARBITER_MAX_IDS> values{};
+        std::array<std::atomic<bool>, DXL_ARBITER_MAX_IDS> dirty{};
+        std::array<std::atomic<uint64_t>, DXL_ARBITER_MAX_IDS> sent{};
+    };
+    /**
+     * the dynamixel bus to write to
+     */
+    Dynamixel &m_dynamixel;
+    /**
+     * the writable registers
+     */
+    std::array<Dynamixel_Arbiter_Register, DXL_ARBITER_MAX_REGISTERS> m_registers{};
+    /**
+     * the amount of writable registers
+     */
+    uint32_t m_register_count = 0;
+    /**
+     * the tick window submitters currently write into
+     */
+    std::atomic<uint64_t> m_open_epoch{1};
+    /**
+     * the last tick window which is on the wire
+     */
+    std::atomic<uint64_t> m_flushed_epoch{0};
+    /**
+     * the outcome of the recent tick windows -> window << 1 | failed, indexed by window
+     */
+    std::array<std::atomic<uint64_t>, DXL_ARBITER_OUTCOMES> m_outcomes{};
+    /**
+     * the background flush thread
+     */
+    std::thread m_thread;
+    /**
+     * true while the background flush thread runs
+     */
+    std::atomic<bool> m_running{false};
+    /**
+     * the sync write parameters, reused every flush
+     */
+    std::array<uint8_t, DXL_ARBITER_PARAM_LEN> m_param{};
+    /**
+     * the encoded sync write packet, reused every flush
+     */
+    std::array<uint8_t, DXL_ARBITER_PACKET_LEN> m_packet{};
+    /**
+     * find a writable register
+     * @param t_address the address of the register
+     * @return the register or nullptr
+     */
+    Dynamixel_Arbiter_Register *m_get_register(uint16_t t_address);
+};
+
+#endif
@@ -0,0 +1,303 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "dynamixel_async.h"
+
+// MARK: - Awaiters
+/**
+ * queue the read for the next tick
+ * @param t_handle the waiting coroutine
+ */
+void Dynamixel_Read_Awaiter::await_suspend(std::coroutine_handle<> t_handle) {
+    handle = t_handle;
+    loop.m_reads.push_back(this);
+}
+/**
+ * queue the write for the next tick
+ * @param t_handle the waiting coroutine
+ */
+void Dynamixel_Write_Awaiter::await_suspend(std::coroutine_handle<> t_handle) {
+    handle = t_handle;
+    loop.m_writes.push_back(this);
+}
+/**
+ * queue the coroutine until its time has come
+ * @param t_handle the waiting coroutine
+ */
+void Dynamixel_Timer_Awaiter::await_suspend(std::coroutine_handle<> t_handle) {
+    loop.m_timers.push_back({time, tick, t_handle});
+}
+
+// MARK: - Event Loop
+/**
+ * set the bus model used to bound the wait for status packets
+ * @param t_model the (calibrated) bus model
+ */
+void Dynamixel_Async::set_model(const Dynamixel_Bus_Model &t_model) {
+    m_model = t_model;
+}
+/**
+ * read a register of many dynamixel's
+ * @param t_address the address of the register
+ * @param t_length the length of the register -> 1, 2 or 4
+ * @param t_dxl_ids the identifiers of the dynamixel's
+ * @return an awaitable which yields one sample per identifier
+ */
+Dynamixel_Read_Awaiter Dynamixel_Async::read(uint16_t t_address, uint16_t t_length, std::vector<uint8_t> t_dxl_ids) {
+    // an awaiter without identifiers is ready at once and never touches the bus
+    if (t_length != 1 && t_length != 2 && t_length != 4) {
+        printf("failed: invalid read length: %i\n", t_length);
+        t_dxl_ids.clear();
+    }
+    return Dynamixel_Read_Awaiter{*this, t_address, t_length, std::move(t_dxl_ids), {}, nullptr};
+}
+/**
+ * write a register of many dynamixel's
+ * @param t_address the address of the register
+ * @param t_length the length of the register -> 1, 2 or 4
+ * @param t_dxl_ids the identifiers of the dynamixel's
+ * @param t_values one value per identifier
+ * @return an awaitable which yields true once the write is on the wire
+ */
+Dynamixel_Write_Awaiter Dynamixel_Async::write(uint16_t t_address, uint16_t t_length, std::vector<uint8_t> t_dxl_ids, std::vector<uint32_t> t_values) {
+    if (t_length != 1 && t_length != 2 && t_length != 4) {
+        printf("failed: invalid write length: %i\n", t_length);
+        t_dxl_ids.clear();
+    } else if (t_dxl_ids.size() != t_values.size()) {
+        printf("failed: %zu identifiers but %zu values\n", t_dxl_ids.size(), t_values.size());
+        t_dxl_ids.clear();
+    }
+    return Dynamixel_Write_Awaiter{*this, t_address, t_length, std::move(t_dxl_ids), std::move(t_values), false, nullptr};
+}
+/**
+ * wait for the next tick
+ * @return an awaitable
+ */
+Dynamixel_Timer_Awaiter Dynamixel_Async::tick() {
+    return Dynamixel_Timer_Awaiter{*this, 0.0, m_ticks};
+}
+/**
+ * wait for some time without blocking the other coroutines
+ * @param t_duration the duration in seconds
+ * @return an awaitable
+ */
+Dynamixel_Timer_Awaiter Dynamixel_Async::sleep(double t_duration) {
+    return Dynamixel_Timer_Awaiter{*this, Dynamixel_Clock::get_monotonic_time() + t_duration, 0};
+}
+/**
+ * run one tick: send the merged writes, send the merged reads and resume the waiting coroutines
+ * @return true if coroutines are still waiting
+ */
+bool Dynamixel_Async::set_tick() {
+    m_ticks++;
+    // everything submitted while this tick runs belongs to the next one
+    m_tick_writes.swap(m_writes);
+    m_tick_reads.swap(m_reads);
+
+    if (!m_tick_writes.empty()) {
+        m_set_writes(m_tick_writes);
+    }
+    if (!m_tick_reads.empty()) {
+        m_set_reads(m_tick_reads);
+    }
+    m_tick_writes.clear();
+    m_tick_reads.clear();
+    m_set_timers(Dynamixel_Clock::get_monotonic_time());
+    return !m_reads.empty() || !m_writes.empty() || !m_timers.empty();
+}
+/**
+ * run ticks at a fixed period until no coroutine is waiting anymore
+ * @param t_period the tick period in seconds
+ */
+void Dynamixel_Async::set_run(double t_period) {
+    auto dxl_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(t_period));
+    auto dxl_deadline = std::chrono::steady_clock::now();
+    while (set_tick()) {
+        dxl_deadline += dxl_period;
+        std::this_thread::sleep_until(dxl_deadline);
+    }
+}
+/**
+ * get the quarantine, dynamixel's which missed too many reads are only pinged until they recover
+ * @return the quarantine
+ */
+Dynamixel_Quarantine &Dynamixel_Async::get_quarantine() {
+    return m_quarantine;
+}
+
+// MARK: - Private Functions
+/**
+ * send all writes of a tick, one sync write per register
+ * @param t_writes the writes of the tick
+ */
+void Dynamixel_Async::m_set_writes(std::vector<Dynamixel_Write_Awaiter*> &t_writes) {
+    m_done.assign(t_writes.size(), 0);
+    for (size_t i = 0; i < t_writes.size(); i++) {
+        if (m_done[i]) {
+            continue;
+        }
+        uint16_t dxl_address = t_writes[i]->address;
+        uint16_t dxl_length = t_writes[i]->length;
+        std::array<bool, 256> dxl_used{};
+        std::array<uint32_t, 256> dxl_values{};
+
+        // later submissions overwrite earlier ones for the same dynamixel
+        for (size_t j = i; j < t_writes.size(); j++) {
+            if (t_writes[j]->address != dxl_address || t_writes[j]->length != dxl_length) {
+                continue;
+            }
+            for (size_t k = 0; k < t_writes[j]->ids.size(); k++) {
+                dxl_used[t_writes[j]->ids[k]] = true;
+                dxl_values[t_writes[j]->ids[k]] = t_writes[j]->values[k];
+            }
+            m_done[j] = 1;
+        }
+        m_param.assign({DXL_LOBYTE(dxl_address), DXL_HIBYTE(dxl_address), DXL_LOBYTE(dxl_length), DXL_HIBYTE(dxl_length)});
+        for (uint16_t dxl_id = 0; dxl_id < 256; dxl_id++) {
+            if (!dxl_used[dxl_id]) {
+                continue;
+            }
+            m_param.push_back((uint8_t)dxl_id);
+            for (uint16_t k = 0; k < dxl_length; k++) {
+                m_param.push_back((uint8_t)(dxl_values[dxl_id] >> (8 * k)));
+            }
+        }
+        m_packet.resize(std::max(m_packet.size(), DXL_INSTRUCTION_FRAME_LEN + m_param.size() + m_param.size() / 3));
+        size_t dxl_packet_length = Dynamixel_Packet::set_instruction(m_packet.data(), m_packet.size(), BROADCAST_ID, INST_SYNC_WRITE, m_param.data(), m_param.size());
+        int t_dxl_result = Dynamixel_Packet::set_transmit(m_dynamixel.get_port_handler(), m_packet.data(), dxl_packet_length);
+        if (t_dxl_result != COMM_SUCCESS) {
+            printf("%s", m_dynamixel.get_packet_handler()->getTxRxResult(t_dxl_result));
+        }
+        for (size_t j = i; j < t_writes.size(); j++) {
+            if (t_writes[j]->address == dxl_address && t_writes[j]->length == dxl_length) {
+                t_writes[j]->result = t_dxl_result == COMM_SUCCESS;
+            }
+        }
+    }
+    for (Dynamixel_Write_Awaiter *dxl_write : t_writes) {
+        dxl_write->handle.resume();
+    }
+}
+/**
+ * send all reads of a tick, one sync read per register
+ * @param t_reads the reads of the tick
+ */
+void Dynamixel_Async::m_set_reads(std::vector<Dynamixel_Read_Awaiter*> &t_reads) {
+    dynamixel::PortHandler *dxl_port = m_dynamixel.get_port_handler();
+    dynamixel::PacketHandler *dxl_packet = m_dynamixel.get_packet_handler();
+    m_done.assign(t_reads.size(), 0);
+
+    for (size_t i = 0; i < t_reads.size(); i++) {
+        if (m_done[i]) {
+            continue;
+        }
+        uint16_t dxl_address = t_reads[i]->address;
+        uint16_t dxl_length = t_reads[i]->length;
+        m_ids.clear();
+        for (size_t j = i; j < t_reads.size(); j++) {
+            if (t_reads[j]->address == dxl_address && t_reads[j]->length == dxl_length) {
+                m_ids.insert(m_ids.end(), t_reads[j]->ids.begin(), t_reads[j]->ids.end());
+            }
+        }
+        std::sort(m_ids.begin(), m_ids.end());
+        m_ids.erase(std::unique(m_ids.begin(), m_ids.end()), m_ids.end());
+        for (uint8_t dxl_id : m_ids) {
+            m_samples[dxl_id] = {0, 0.0, false};
+        }
+        // quarantined dynamixel's are left out and stay invalid
+        m_ids.erase(std::remove_if(m_ids.begin(), m_ids.end(), [&](uint8_t t_dxl_id) {
+            return !m_quarantine.get_admitted(t_dxl_id);
+        }), m_ids.end());
+
+        m_param.assign({DXL_LOBYTE(dxl_address), DXL_HIBYTE(dxl_address), DXL_LOBYTE(dxl_length), DXL_HIBYTE(dxl_length)});
+        m_param.insert(m_param.end(), m_ids.begin(), m_ids.end());
+        m_packet.resize(std::max(m_packet.size(), DXL_INSTRUCTION_FRAME_LEN + m_param.size() + m_param.size() / 3));
+        size_t dxl_packet_length = Dynamixel_Packet::set_instruction(m_packet.data(), m_packet.size(), BROADCAST_ID, INST_SYNC_READ, m_param.data(), m_param.size());
+        double dxl_start = Dynamixel_Clock::get_monotonic_time();
+        int t_dxl_result = m_ids.empty() ? COMM_SUCCESS : Dynamixel_Packet::set_transmit(dxl_port, m_packet.data(), dxl_packet_length);
+        if (t_dxl_result == COMM_SUCCESS && !m_ids.empty()) {
+            // keep the other coroutines going until every status packet is in the buffer
+            Dynamixel_Transaction dxl_transaction{INST_SYNC_READ, (uint16_t)m_ids.size(), (uint16_t)(m_ids.size() * dxl_length)};
+            int dxl_expected = (int)m_model.get_status_length(dxl_transaction);
+            double dxl_deadline = dxl_start + 2.0 * m_model.get_transaction_time(dxl_transaction);
+            double dxl_now = dxl_start;
+            while (dxl_port->getBytesAvailable() < dxl_expected && dxl_now < dxl_deadline) {
+                m_set_timers(dxl_now);
+                dxl_now = Dynamixel_Clock::get_monotonic_time();
+            }
+            // the statuses which arrived are kept, even if one in between is missing
+            m_receiver.set_clear();
+            for (size_t j = 0; j < m_ids.size(); j++) {
+                Dynamixel_Status dxl_status{};
+                if (m_receiver.get_status(dxl_port, dxl_deadline, dxl_status) != COMM_SUCCESS) {
+                    break;
+                }
+                Dynamixel_Sample &dxl_sample = m_samples[dxl_status.id];
+                if (dxl_sample.valid || !std::binary_search(m_ids.begin(), m_ids.end(), dxl_status.id)) {
+                    continue;
+                }
+                for (uint16_t k = 0; k < dxl_length && k < 4 && k < dxl_status.length; k++) {
+                    dxl_sample.value |= (uint32_t)dxl_status.param[k] << (8 * k);
+                }
+                dxl_sample.valid = true;
+            }
+            for (uint8_t dxl_id : m_ids) {
+                if (!m_samples[dxl_id].valid) {
+                    printf("failed: no status for id: %i\n", dxl_id);
+                }
+                m_quarantine.set_result(dxl_id, m_samples[dxl_id].valid);
+            }
+        } else if (t_dxl_result != COMM_SUCCESS) {
+            printf("%s", dxl_packet->getTxRxResult(t_dxl_result));
+        }
+        for (size_t j = i; j < t_reads.size(); j++) {
+            if (t_reads[j]->address != dxl_address || t_reads[j]->length != dxl_length) {
+                continue;
+            }
+            for (uint8_t dxl_id : t_reads[j]->ids) {
+                t_reads[j]->result.push_back(m_samples[dxl_id]);
+            }
+            m_done[j] = 1;
+        }
+    }
+    m_quarantine.set_recovery(dxl_port, 2.0 * m_model.get_transaction_time({INST_PING, 1, 3}));
+    for (Dynamixel_Read_Awaiter *dxl_read : t_reads) {
+        dxl_read->handle.resume();
+    }
+}
+/**
+ * resume the coroutines whose time has come
+ * @param t_now the host time
+ */
+void Dynamixel_Async::m_set_timers(double t_now) {
+    m_ready.clear();
+    auto dxl_waiting = std::partition(m_timers.begin(), m_timers.end(), [&](const Dynamixel_Timer &t_timer) {
+        return !(t_timer.time <= t_now && t_timer.tick < m_ticks);
+    });
+    for (auto dxl_timer = dxl_waiting; dxl_timer != m_timers.end(); dxl_timer++) {
+        m_ready.push_back(dxl_timer->handle);
+    }
+    m_timers.erase(dxl_waiting, m_timers.end());
+    for (std::coroutine_handle<> dxl_handle : m_ready) {
+        dxl_handle.resume();
+    }
+}
@@ -0,0 +1,346 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_ASYNC_H
+#define DYNAMIXEL_DYNAMIXEL_ASYNC_H
+
+#include <cstdint>
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <vector>
+#include "dynamixel.h"
+#include "dynamixel_bus_model.h"
+#include "dynamixel_packet.h"
+#include "dynamixel_quarantine.h"
+#include "dynamixel_register.h"
+#include "dynamixel_scheduler.h"
+
+#define DXL_ASYNC_PARAM_LEN (4 + 253 * 5)
+
+class Dynamixel_Async;
+
+/**
+ * an eagerly started coroutine which can await bus operations and other tasks
+ */
+class Dynamixel_Task {
+// public declaration
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation;
+        Dynamixel_Task get_return_object() {
+            return Dynamixel_Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        auto final_suspend() noexcept {
+            struct Dynamixel_Final_Awaiter {
+                bool await_ready() noexcept {
+                    return false;
+                }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> t_handle) noexcept {
+                    std::coroutine_handle<> dxl_continuation = t_handle.promise().continuation;
+                    return dxl_continuation ? dxl_continuation : std::noop_coroutine();
+                }
+                void await_resume() noexcept {
+                }
+            };
+            return Dynamixel_Final_Awaiter{};
+        }
+        void return_void() {
+        }
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+    explicit Dynamixel_Task(std::coroutine_handle<promise_type> t_handle):
+            m_handle(t_handle) {
+    };
+    Dynamixel_Task(Dynamixel_Task &&t_task) noexcept:
+            m_handle(std::exchange(t_task.m_handle, nullptr)) {
+    };
+    Dynamixel_Task(const Dynamixel_Task &) = delete;
+    Dynamixel_Task &operator=(const Dynamixel_Task &) = delete;
+    ~Dynamixel_Task() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    };
+    /**
+     * check if the task ran to completion
+     * @return true if done
+     */
+    bool get_done() const {
+        return !m_handle || m_handle.done();
+    };
+    bool await_ready() const {
+        return get_done();
+    };
+    void await_suspend(std::coroutine_handle<> t_handle) {
+        m_handle.promise().continuation = t_handle;
+    };
+    void await_resume() {
+    };
+
+// private declaration
+private:
+    /**
+     * the coroutine of the task
+     */
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/**
+ * awaits a register of many dynamixel's, batched with all reads of the same tick
+ */
+struct Dynamixel_Read_Awaiter {
+    Dynamixel_Async &loop;
+    uint16_t address;
+    uint16_t length;
+    std::vector<uint8_t> ids;
+    std::vector<Dynamixel_Sample> result;
+    std::coroutine_handle<> handle;
+    bool await_ready() const noexcept {
+        return ids.empty();
+    };
+    void await_suspend(std::coroutine_handle<> t_handle);
+    std::vector<Dynamixel_Sample> await_resume() {
+        return std::move(result);
+    };
+};
+
+/**
+ * awaits a register write to many dynamixel's, batched with all writes of the same tick
+ */
+struct Dynamixel_Write_Awaiter {
+    Dynamixel_Async &loop;
+    uint16_t address;
+    uint16_t length;
+    std::vector<uint8_t> ids;
+    std::vector<uint32_t> values;
+    bool result;
+    std::coroutine_handle<> handle;
+    bool await_ready() const noexcept {
+        return ids.empty() || ids.size() != values.size();
+    };
+    void await_suspend(std::coroutine_handle<> t_handle);
+    bool await_resume() const noexcept {
+        return result;
+    };
+};
+
+/**
+ * awaits the next tick or a point in time of the event loop
+ */
+struct Dynamixel_Timer_Awaiter {
+    Dynamixel_Async &loop;
+    double time;
+    uint64_t tick;
+    bool await_ready() const noexcept {
+        return false;
+    };
+    void await_suspend(std::coroutine_handle<> t_handle);
+    void await_resume() const noexcept {
+    };
+};
+
+/**
+ * a single threaded event loop which interleaves many coroutines on one bus,
+ * every tick the pending writes and reads are merged into sync packets
+ */
+class Dynamixel_Async {
+// public declaration
+public:
+    /**
+     * initialize the event loop
+     * @param t_dynamixel the dynamixel bus
+     */
+    explicit Dynamixel_Async(Dynamixel &t_dynamixel):
+            m_dynamixel(t_dynamixel) {
+        m_param.reserve(DXL_ASYNC_PARAM_LEN);
+        m_packet.reserve(DXL_INSTRUCTION_FRAME_LEN + DXL_ASYNC_PARAM_LEN + DXL_ASYNC_PARAM_LEN / 3);
+        m_ids.reserve(256);
+    };
+    /**
+     * set the bus model used to bound the wait for status packets
+     * @param t_model the (calibrated) bus model
+     */
+    void set_model(const Dynamixel_Bus_Model &t_model);
+    /**
+     * read a register of many dynamixel's
+     * @param t_address the address of the register
+     * @param t_length the length of the register -> 1, 2 or 4
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     * @return an awaitable which yields one sample per identifier
+     */
+    Dynamixel_Read_Awaiter read(uint16_t t_address, uint16_t t_length, std::vector<uint8_t> t_dxl_ids);
+    /**
+     * read a register of many dynamixel's
+     * @tparam T the register -> e.g. Dynamixel_Present_Position
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     * @return an awaitable which yields one sample per identifier
+     */
+    template<typename T>
+    Dynamixel_Read_Awaiter read(std::vector<uint8_t> t_dxl_ids) {
+        return read(T::address, T::length, std::move(t_dxl_ids));
+    };
+    /**
+     * write a register of many dynamixel's
+     * @param t_address the address of the register
+     * @param t_length the length of the register -> 1, 2 or 4
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     * @param t_values one value per identifier
+     * @return an awaitable which yields true once the write is on the wire
+     */
+    Dynamixel_Write_Awaiter write(uint16_t t_address, uint16_t t_length, std::vector<uint8_t> t_dxl_ids, std::vector<uint32_t> t_values);
+    /**
+     * write a register of many dynamixel's
+     * @tparam T the register -> e.g. Dynamixel_Goal_Position
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     * @param t_values one value per identifier
+     * @return an awaitable which yields true once the write is on the wire
+     */
+    template<typename T>
+    Dynamixel_Write_Awaiter write(std::vector<uint8_t> t_dxl_ids, std::vector<uint32_t> t_values) {
+        return write(T::address, T::length, std::move(t_dxl_ids), std::move(t_values));
+    };
+    /**
+     * wait for the next tick
+     * @return an awaitable
+     */
+    Dynamixel_Timer_Awaiter tick();
+    /**
+     * wait for some time without blocking the other coroutines
+     * @param t_duration the duration in seconds
+     * @return an awaitable
+     */
+    Dynamixel_Timer_Awaiter sleep(double t_duration);
+    /**
+     * run one tick: send the merged writes, send the merged reads and resume the waiting coroutines
+     * @return true if coroutines are still waiting
+     */
+    bool set_tick();
+    /**
+     * run ticks at a fixed period until no coroutine is waiting anymore
+     * @param t_period the tick period in seconds
+     */
+    void set_run(double t_period);
+    /**
+     * get the quarantine, dynamixel's which missed too many reads are only pinged until they recover
+     * @return the quarantine
+     */
+    Dynamixel_Quarantine &get_quarantine();
+
+// private declaration
+private:
+    friend struct Dynamixel_Read_Awaiter;
+    friend struct Dynamixel_Write_Awaiter;
+    friend struct Dynamixel_Timer_Awaiter;
+    /**
+     * a coroutine waiting for a point in time
+     */
+    struct Dynamixel_Timer {
+        double time;
+        uint64_t tick;
+        std::coroutine_handle<> handle;
+    };
+    /**
+     * the dynamixel bus
+     */
+    Dynamixel &m_dynamixel;
+    /**
+     * the bus model used to bound the wait for status packets
+     */
+    Dynamixel_Bus_Model m_model = Dynamixel_Bus_Model(m_dynamixel.get_baud_rate());
+    /**
+     * the reads submitted for the next tick
+     */
+    std::vector<Dynamixel_Read_Awaiter*> m_reads;
+    /**
+     * the writes submitted for the next tick
+     */
+    std::vector<Dynamixel_Write_Awaiter*> m_writes;
+    /**
+     * the reads of the running tick, swapped with the submitted ones so both keep their capacity
+     */
+    std::vector<Dynamixel_Read_Awaiter*> m_tick_reads;
+    /**
+     * the writes of the running tick, swapped with the submitted ones so both keep their capacity
+     */
+    std::vector<Dynamixel_Write_Awaiter*> m_tick_writes;
+    /**
+     * the coroutines waiting for a point in time
+     */
+    std::vector<Dynamixel_Timer> m_timers;
+    /**
+     * the coroutines whose time has come, reused every tick
+     */
+    std::vector<std::coroutine_handle<>> m_ready;
+    /**
+     * true for every read or write which is already sent, reused every tick
+     */
+    std::vector<uint8_t> m_done;
+    /**
+     * the identifiers of the current sync read, reused every tick
+     */
+    std::vector<uint8_t> m_ids;
+    /**
+     * the amount of ticks run so far
+     */
+    uint64_t m_ticks = 0;
+    /**
+     * the sync packet parameters, reused every tick
+     */
+    std::vector<uint8_t> m_param;
+    /**
+     * the encoded sync write packet, reused every tick
+     */
+    std::vector<uint8_t> m_packet;
+    /**
+     * the samples of the current sync read
+     */
+    std::array<Dynamixel_Sample, 256> m_samples{};
+    /**
+     * the receiver of the status packets
+     */
+    Dynamixel_Receiver m_receiver;
+    /**
+     * the dynamixel's which are left out of the reads
+     */
+    Dynamixel_Quarantine m_quarantine;
+    /**
+     * send all writes of a tick, one sync write per register
+     * @param t_writes the writes of the tick
+     */
+    void m_set_writes(std::vector<Dynamixel_Write_Awaiter*> &t_writes);
+    /**
+     * send all reads of a tick, one sync read per register
+     * @param t_reads the reads of the tick
+     */
+    void m_set_reads(std::vector<Dynamixel_Read_Awaiter*> &t_reads);
+    /**
+     * resume the coroutines whose time has come
+     * @param t_now the host time
+     */
+    void m_set_timers(double t_now);
+};
+
+#endif
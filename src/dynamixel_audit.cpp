@@ -0,0 +1,143 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include "dynamixel_audit.h"
+
+/**
+ * the tick depth and the tick allocations of every thread, plain integers so the allocator can use them
+ */
+static thread_local uint32_t dxl_tick_depth = 0;
+static thread_local uint64_t dxl_tick_allocations = 0;
+/**
+ * the ticks which allocated and the abort switch, shared by all threads
+ */
+static std::atomic<uint64_t> dxl_tick_failures{0};
+static std::atomic<bool> dxl_tick_fatal{true};
+
+/**
+ * enter a control tick on the calling thread, ticks may be nested
+ */
+void Dynamixel_Audit::set_enter() {
+    dxl_tick_depth++;
+}
+/**
+ * leave a control tick on the calling thread and report its allocations
+ * @param t_name the name of the tick
+ * @param t_allocations the allocations of the calling thread when the tick was entered
+ * @return the amount of allocations inside the tick
+ */
+uint64_t Dynamixel_Audit::set_leave(const char *t_name, uint64_t t_allocations) {
+    if (dxl_tick_depth > 0) {
+        dxl_tick_depth--;
+    }
+    uint64_t dxl_allocations = dxl_tick_allocations - t_allocations;
+    if (dxl_allocations == 0) {
+        return 0;
+    }
+    dxl_tick_failures.fetch_add(1, std::memory_order_relaxed);
+    printf("failed: %llu heap allocations inside tick: %s\n", (unsigned long long)dxl_allocations, t_name);
+    if (dxl_tick_fatal.load(std::memory_order_relaxed)) {
+        fflush(stdout);
+        std::abort();
+    }
+    return dxl_allocations;
+}
+/**
+ * abort the process on the first allocation inside a tick | default -> true
+ * @param t_fatal false to only count and report the allocations
+ */
+void Dynamixel_Audit::set_fatal(bool t_fatal) {
+    dxl_tick_fatal.store(t_fatal, std::memory_order_relaxed);
+}
+/**
+ * get the allocations of the calling thread inside ticks
+ * @return the amount of allocations
+ */
+uint64_t Dynamixel_Audit::get_allocations() {
+    return dxl_tick_allocations;
+}
+/**
+ * get the amount of ticks (of all threads) which allocated
+ * @return the amount of failed ticks
+ */
+uint64_t Dynamixel_Audit::get_failures() {
+    return dxl_tick_failures.load(std::memory_order_relaxed);
+}
+
+#ifdef DYNAMIXEL_ALLOCATION_AUDIT
+// MARK: - Global Allocator
+/**
+ * allocate and count the allocation if the calling thread is inside a tick
+ * @param t_size the size in bytes
+ * @param t_alignment the alignment, 0 for the default alignment
+ * @return the memory or nullptr
+ */
+static void *dxl_get_memory(std::size_t t_size, std::size_t t_alignment) {
+    if (dxl_tick_depth > 0) {
+        dxl_tick_allocations++;
+    }
+    if (t_size == 0) {
+        t_size = 1;
+    }
+    if (t_alignment <= alignof(std::max_align_t)) {
+        return std::malloc(t_size);
+    }
+    return std::aligned_alloc(t_alignment, (t_size + t_alignment - 1) / t_alignment * t_alignment);
+}
+/**
+ * allocate like the default operator new, throws on failure
+ * @param t_size the size in bytes
+ * @param t_alignment the alignment, 0 for the default alignment
+ * @return the memory
+ */
+static void *dxl_get_checked_memory(std::size_t t_size, std::size_t t_alignment) {
+    void *dxl_memory = dxl_get_memory(t_size, t_alignment);
+    if (dxl_memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return dxl_memory;
+}
+
+void *operator new(std::size_t t_size) { return dxl_get_checked_memory(t_size, 0); }
+void *operator new[](std::size_t t_size) { return dxl_get_checked_memory(t_size, 0); }
+void *operator new(std::size_t t_size, std::align_val_t t_alignment) { return dxl_get_checked_memory(t_size, (std::size_t)t_alignment); }
+void *operator new[](std::size_t t_size, std::align_val_t t_alignment) { return dxl_get_checked_memory(t_size, (std::size_t)t_alignment); }
+void *operator new(std::size_t t_size, const std::nothrow_t &) noexcept { return dxl_get_memory(t_size, 0); }
+void *operator new[](std::size_t t_size, const std::nothrow_t &) noexcept { return dxl_get_memory(t_size, 0); }
+void *operator new(std::size_t t_size, std::align_val_t t_alignment, const std::nothrow_t &) noexcept { return dxl_get_memory(t_size, (std::size_t)t_alignment); }
+void *operator new[](std::size_t t_size, std::align_val_t t_alignment, const std::nothrow_t &) noexcept { return dxl_get_memory(t_size, (std::size_t)t_alignment); }
+
+void operator delete(void *t_memory) noexcept { std::free(t_memory); }
+void operator delete[](void *t_memory) noexcept { std::free(t_memory); }
+void operator delete(void *t_memory, std::size_t) noexcept { std::free(t_memory); }
+void operator delete[](void *t_memory, std::size_t) noexcept { std::free(t_memory); }
+void operator delete(void *t_memory, std::align_val_t) noexcept { std::free(t_memory); }
+void operator delete[](void *t_memory, std::align_val_t) noexcept { std::free(t_memory); }
+void operator delete(void *t_memory, std::size_t, std::align_val_t) noexcept { std::free(t_memory); }
+void operator delete[](void *t_memory, std::size_t, std::align_val_t) noexcept { std::free(t_memory); }
+void operator delete(void *t_memory, const std::nothrow_t &) noexcept { std::free(t_memory); }
+void operator delete[](void *t_memory, const std::nothrow_t &) noexcept { std::free(t_memory); }
+void operator delete(void *t_memory, std::align_val_t, const std::nothrow_t &) noexcept { std::free(t_memory); }
+void operator delete[](void *t_memory, std::align_val_t, const std::nothrow_t &) noexcept { std::free(t_memory); }
+#endif
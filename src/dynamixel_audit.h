@@ -0,0 +1,108 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_AUDIT_H
+#define DYNAMIXEL_DYNAMIXEL_AUDIT_H
+
+#include <cstdint>
+
+/**
+ * counts the heap allocations (global operator new) made inside marked control ticks,
+ * only active in an audit build -> cmake -DDYNAMIXEL_ALLOCATION_AUDIT=ON
+ */
+class Dynamixel_Audit {
+// public declaration
+public:
+    /**
+     * enter a control tick on the calling thread, ticks may be nested
+     */
+    static void set_enter();
+    /**
+     * leave a control tick on the calling thread and report its allocations
+     * @param t_name the name of the tick
+     * @param t_allocations the allocations of the calling thread when the tick was entered
+     * @return the amount of allocations inside the tick
+     */
+    static uint64_t set_leave(const char *t_name, uint64_t t_allocations);
+    /**
+     * abort the process on the first allocation inside a tick | default -> true
+     * @param t_fatal false to only count and report the allocations
+     */
+    static void set_fatal(bool t_fatal);
+    /**
+     * get the allocations of the calling thread inside ticks
+     * @return the amount of allocations
+     */
+    static uint64_t get_allocations();
+    /**
+     * get the amount of ticks (of all threads) which allocated
+     * @return the amount of failed ticks
+     */
+    static uint64_t get_failures();
+};
+
+/**
+ * marks the scope of a control tick, the steady state of a tick must not allocate,
+ * an audit build fails the tick on any allocation and other builds compile it to nothing
+ */
+class Dynamixel_Tick_Guard {
+// public declaration
+public:
+#ifdef DYNAMIXEL_ALLOCATION_AUDIT
+    /**
+     * enter the tick
+     * @param t_name the name of the tick, used in the report
+     */
+    explicit Dynamixel_Tick_Guard(const char *t_name):
+            m_name(t_name), m_allocations(Dynamixel_Audit::get_allocations()) {
+        Dynamixel_Audit::set_enter();
+    };
+    /**
+     * leave the tick and fail it if it allocated
+     */
+    ~Dynamixel_Tick_Guard() {
+        Dynamixel_Audit::set_leave(m_name, m_allocations);
+    };
+#else
+    /**
+     * mark the tick, does nothing without an audit build
+     * @param t_name the name of the tick
+     */
+    explicit Dynamixel_Tick_Guard(const char *t_name) {
+        (void)t_name;
+    };
+#endif
+    Dynamixel_Tick_Guard(const Dynamixel_Tick_Guard &) = delete;
+    Dynamixel_Tick_Guard &operator=(const Dynamixel_Tick_Guard &) = delete;
+
+#ifdef DYNAMIXEL_ALLOCATION_AUDIT
+// private declaration
+private:
+    /**
+     * the name of the tick
+     */
+    const char *m_name;
+    /**
+     * the allocations of the calling thread when the tick was entered
+     */
+    uint64_t m_allocations;
+#endif
+};
+
+#endif
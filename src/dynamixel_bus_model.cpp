@@ -0,0 +1,345 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <utility>
+#include "dynamixel_bus_model.h"
+
+#define DXL_CALIBRATION_PARAMS 3
+#define DXL_CALIBRATION_MIN_SAMPLES 8
+
+/**
+ * account for the worst case byte stuffing instead of none
+ * @param t_worst_case enable or disable
+ */
+void Dynamixel_Bus_Model::set_worst_case(bool t_worst_case) {
+    m_worst_case = t_worst_case;
+}
+/**
+ * get the length of an instruction packet on the wire
+ * @param t_transaction the transaction
+ * @return the length in bytes
+ */
+uint32_t Dynamixel_Bus_Model::get_instruction_length(const Dynamixel_Transaction &t_transaction) {
+    uint32_t dxl_param_length = m_get_param_length(t_transaction);
+    uint32_t dxl_stuffing = m_worst_case ? dxl_param_length / 3 : 0;
+    return DXL_INSTRUCTION_FRAME_LEN + dxl_param_length + dxl_stuffing;
+}
+/**
+ * get the length of all status packets of a transaction on the wire
+ * @param t_transaction the transaction
+ * @return the length in bytes
+ */
+uint32_t Dynamixel_Bus_Model::get_status_length(const Dynamixel_Transaction &t_transaction) {
+    uint32_t dxl_count = get_status_count(t_transaction);
+    uint32_t dxl_data_length = t_transaction.data_length;
+    switch (t_transaction.instruction) {
+        case INST_WRITE:
+        case INST_REBOOT:
+            dxl_data_length = 0;
+            break;
+        default:
+            break;
+    }
+    uint32_t dxl_stuffing = m_worst_case ? dxl_data_length / 3 : 0;
+    return dxl_count * DXL_STATUS_FRAME_LEN + dxl_data_length + dxl_stuffing;
+}
+/**
+ * get the amount of status packets of a transaction
+ * @param t_transaction the transaction
+ * @return the amount of status packets
+ */
+uint32_t Dynamixel_Bus_Model::get_status_count(const Dynamixel_Transaction &t_transaction) {
+    switch (t_transaction.instruction) {
+        case INST_SYNC_WRITE:
+        case INST_BULK_WRITE:
+            return 0;
+        default:
+            return t_transaction.count;
+    }
+}
+/**
+ * get the wire time of an encoded packet
+ * @param t_length the length of the packet in bytes
+ * @return the wire time in seconds
+ */
+double Dynamixel_Bus_Model::get_wire_time(size_t t_length) {
+    return t_length * m_byte_time;
+}
+/**
+ * get the predicted time of a transaction including return delay and latency
+ * @param t_transaction the transaction
+ * @return the time in seconds
+ */
+double Dynamixel_Bus_Model::get_transaction_time(const Dynamixel_Transaction &t_transaction) {
+    uint32_t dxl_statuses = get_status_count(t_transaction);
+    double dxl_time = m_overhead + get_wire_time(get_instruction_length(t_transaction) + get_status_length(t_transaction));
+    if (dxl_statuses > 0) {
+        dxl_time += m_latency + dxl_statuses * m_return_delay;
+    }
+    return dxl_time;
+}
+/**
+ * get the predicted time of a planned tick
+ * @param t_plan the transactions of a tick
+ * @return the time in seconds
+ */
+double Dynamixel_Bus_Model::get_cycle_time(const std::vector<Dynamixel_Transaction> &t_plan) {
+    double dxl_time = 0.0;
+    for (const Dynamixel_Transaction &dxl_transaction : t_plan) {
+        dxl_time += get_transaction_time(dxl_transaction);
+    }
+    return dxl_time;
+}
+/**
+ * check if a planned tick can be sustained at a target rate
+ * @param t_plan the transactions of a tick
+ * @param t_rate the target rate in hz
+ * @param t_margin the usable fraction of the period before warning | default -> 0.8
+ * @return accept, warn or reject
+ */
+Dynamixel_Admission Dynamixel_Bus_Model::get_admission(const std::vector<Dynamixel_Transaction> &t_plan, double t_rate, double t_margin) {
+    double dxl_cycle = get_cycle_time(t_plan);
+    double dxl_period = 1.0 / t_rate;
+    if (dxl_cycle > dxl_period) {
+        printf("failed: planned tick needs %.1f us, the period is %.1f us\n", dxl_cycle * 1.0e6, dxl_period * 1.0e6);
+        return DXL_ADMISSION_REJECT;
+    }
+    if (dxl_cycle > t_margin * dxl_period) {
+        printf("warning: planned tick needs %.1f us, only %.1f us are left\n", dxl_cycle * 1.0e6, (dxl_period - dxl_cycle) * 1.0e6);
+        return DXL_ADMISSION_WARN;
+    }
+    return DXL_ADMISSION_ACCEPT;
+}
+/**
+ * add a measured transaction time for the calibration
+ * @param t_transaction the transaction
+ * @param t_time the measured time in seconds
+ */
+void Dynamixel_Bus_Model::set_measurement(const Dynamixel_Transaction &t_transaction, double t_time) {
+    Dynamixel_Measurement dxl_measurement{};
+    dxl_measurement.bytes = get_instruction_length(t_transaction) + get_status_length(t_transaction);
+    dxl_measurement.statuses = get_status_count(t_transaction);
+    dxl_measurement.replied = dxl_measurement.statuses > 0 ? 1.0 : 0.0;
+    dxl_measurement.time = t_time;
+    m_measurements.push_back(dxl_measurement);
+}
+/**
+ * measure transactions on the real bus and fit the model to them,
+ * with a single dynamixel the return delay is taken from its register
+ * @param t_dynamixel the dynamixel bus
+ * @param t_dxl_ids the identifiers of the connected dynamixel's
+ * @param t_rounds the amount of measurements per transaction type | default -> 20
+ * @return true if the fit succeeded
+ */
+bool Dynamixel_Bus_Model::set_calibration(Dynamixel &t_dynamixel, const std::vector<uint8_t> &t_dxl_ids, uint32_t t_rounds) {
+    if (t_dxl_ids.empty()) {
+        printf("failed: no dynamixel to calibrate against\n");
+        return false;
+    }
+    dynamixel::PortHandler *dxl_port = t_dynamixel.get_port_handler();
+    dynamixel::PacketHandler *dxl_packet = t_dynamixel.get_packet_handler();
+    const uint16_t dxl_lengths[] = {1, 16, 64};
+    uint8_t dxl_data[64];
+    uint8_t t_dxl_error = 0;
+
+    // the configured return delay is the fallback if the fit can't separate it (a single dynamixel)
+    uint8_t dxl_return_delay_time = 0;
+    if (dxl_packet->read1ByteTxRx(dxl_port, t_dxl_ids.front(), ADDR_RETURN_DELAY_TIME, &dxl_return_delay_time, &t_dxl_error) == COMM_SUCCESS) {
+        m_return_delay = dxl_return_delay_time * 2.0e-6;
+    }
+    // the led state is written back as it is, so the sync write doesn't change anything
+    std::vector<uint8_t> dxl_led_param;
+    for (uint8_t dxl_id : t_dxl_ids) {
+        dxl_led_param.push_back(dxl_id);
+        dxl_led_param.push_back(t_dynamixel.get_led(dxl_id));
+    }
+    std::vector<uint8_t> dxl_ids(t_dxl_ids);
+    uint16_t dxl_count = t_dxl_ids.size();
+
+    for (uint32_t i = 0; i < t_rounds; i++) {
+        for (uint8_t dxl_id : t_dxl_ids) {
+            double dxl_start = Dynamixel_Clock::get_monotonic_time();
+            if (dxl_packet->ping(dxl_port, dxl_id, &t_dxl_error) == COMM_SUCCESS) {
+                set_measurement({INST_PING, 1, 3}, Dynamixel_Clock::get_monotonic_time() - dxl_start);
+            }
+            for (uint16_t dxl_length : dxl_lengths) {
+                dxl_start = Dynamixel_Clock::get_monotonic_time();
+                if (dxl_packet->readTxRx(dxl_port, dxl_id, ADDR_MODEL_NUMBER, dxl_length, dxl_data, &t_dxl_error) == COMM_SUCCESS) {
+                    set_measurement({INST_READ, 1, dxl_length}, Dynamixel_Clock::get_monotonic_time() - dxl_start);
+                }
+            }
+        }
+        for (uint16_t dxl_length : dxl_lengths) {
+            double dxl_start = Dynamixel_Clock::get_monotonic_time();
+            bool dxl_success = dxl_packet->syncReadTx(dxl_port, ADDR_MODEL_NUMBER, dxl_length, dxl_ids.data(), dxl_count) == COMM_SUCCESS;
+            for (uint8_t dxl_id : t_dxl_ids) {
+                dxl_success = dxl_success && dxl_packet->readRx(dxl_port, dxl_id, dxl_length, dxl_data, &t_dxl_error) == COMM_SUCCESS;
+            }
+            if (dxl_success) {
+                set_measurement({INST_SYNC_READ, dxl_count, (uint16_t)(dxl_count * dxl_length)}, Dynamixel_Clock::get_monotonic_time() - dxl_start);
+            }
+        }
+        // only times the write syscall, it is used for the overhead and not for the byte time
+        double dxl_start = Dynamixel_Clock::get_monotonic_time();
+        if (dxl_packet->syncWriteTxOnly(dxl_port, ADDR_LED, 1, dxl_led_param.data(), dxl_led_param.size()) == COMM_SUCCESS) {
+            set_measurement({INST_SYNC_WRITE, dxl_count, dxl_count}, Dynamixel_Clock::get_monotonic_time() - dxl_start);
+        }
+    }
+    return set_calibration();
+}
+/**
+ * fit the model to the added measurements
+ * @return true if the fit succeeded
+ */
+bool Dynamixel_Bus_Model::set_calibration() {
+    // a packet without a status only times the write syscall -> the overhead, nothing about the bus
+    // the return delay can only be separated from the latency if a packet had several statuses
+    double dxl_overhead = 0.0;
+    size_t dxl_writes = 0;
+    size_t dxl_samples = 0;
+    bool dxl_separable = false;
+    for (const Dynamixel_Measurement &dxl_measurement : m_measurements) {
+        if (dxl_measurement.replied == 0.0) {
+            dxl_overhead += dxl_measurement.time;
+            dxl_writes++;
+            continue;
+        }
+        dxl_samples++;
+        dxl_separable = dxl_separable || dxl_measurement.statuses > dxl_measurement.replied;
+    }
+    if (dxl_samples < DXL_CALIBRATION_MIN_SAMPLES) {
+        printf("failed: not enough measurements with a status to calibrate: %zu\n", dxl_samples);
+        return false;
+    }
+    dxl_overhead = dxl_writes > 0 ? dxl_overhead / dxl_writes : m_overhead;
+    int dxl_count = dxl_separable ? DXL_CALIBRATION_PARAMS : DXL_CALIBRATION_PARAMS - 1;
+
+    // least squares over time - overhead = latency + bytes * byte time + statuses * return delay
+    // without a multi status packet the return delay is kept and subtracted from the time as well
+    double dxl_matrix[DXL_CALIBRATION_PARAMS][DXL_CALIBRATION_PARAMS + 1] = {};
+    for (const Dynamixel_Measurement &dxl_measurement : m_measurements) {
+        if (dxl_measurement.replied == 0.0) {
+            continue;
+        }
+        const double dxl_row[DXL_CALIBRATION_PARAMS] = {dxl_measurement.replied, dxl_measurement.bytes, dxl_measurement.statuses};
+        double dxl_time = dxl_measurement.time - dxl_overhead;
+        if (!dxl_separable) {
+            dxl_time -= dxl_measurement.statuses * m_return_delay;
+        }
+        for (int i = 0; i < dxl_count; i++) {
+            for (int j = 0; j < dxl_count; j++) {
+                dxl_matrix[i][j] += dxl_row[i] * dxl_row[j];
+            }
+            dxl_matrix[i][DXL_CALIBRATION_PARAMS] += dxl_row[i] * dxl_time;
+        }
+    }
+    for (int i = 0; i < dxl_count; i++) {
+        int dxl_pivot = i;
+        for (int j = i + 1; j < dxl_count; j++) {
+            if (std::fabs(dxl_matrix[j][i]) > std::fabs(dxl_matrix[dxl_pivot][i])) {
+                dxl_pivot = j;
+            }
+        }
+        if (std::fabs(dxl_matrix[dxl_pivot][i]) < 1.0e-12) {
+            printf("failed: measurements don't cover every model parameter\n");
+            return false;
+        }
+        std::swap(dxl_matrix[i], dxl_matrix[dxl_pivot]);
+        for (int j = 0; j < dxl_count; j++) {
+            if (j == i) {
+                continue;
+            }
+            double dxl_factor = dxl_matrix[j][i] / dxl_matrix[i][i];
+            for (int k = i; k < dxl_count; k++) {
+                dxl_matrix[j][k] -= dxl_factor * dxl_matrix[i][k];
+            }
+            dxl_matrix[j][DXL_CALIBRATION_PARAMS] -= dxl_factor * dxl_matrix[i][DXL_CALIBRATION_PARAMS];
+        }
+    }
+    double dxl_params[DXL_CALIBRATION_PARAMS] = {0.0, 0.0, m_return_delay};
+    for (int i = 0; i < dxl_count; i++) {
+        dxl_params[i] = dxl_matrix[i][DXL_CALIBRATION_PARAMS] / dxl_matrix[i][i];
+    }
+    if (dxl_params[1] <= 0.0) {
+        printf("failed: calibration produced an invalid byte time\n");
+        return false;
+    }
+    m_overhead = std::fmax(dxl_overhead, 0.0);
+    m_latency = std::fmax(dxl_params[0], 0.0);
+    m_byte_time = dxl_params[1];
+    m_return_delay = std::fmax(dxl_params[2], 0.0);
+    return true;
+}
+/**
+ * get the time per byte on the wire
+ * @return the time in seconds
+ */
+double Dynamixel_Bus_Model::get_byte_time() {
+    return m_byte_time;
+}
+/**
+ * get the return delay of a dynamixel
+ * @return the time in seconds
+ */
+double Dynamixel_Bus_Model::get_return_delay() {
+    return m_return_delay;
+}
+/**
+ * get the latency of the usb adapter
+ * @return the time in seconds
+ */
+double Dynamixel_Bus_Model::get_latency() {
+    return m_latency;
+}
+/**
+ * get the fixed overhead of every transaction
+ * @return the time in seconds
+ */
+double Dynamixel_Bus_Model::get_overhead() {
+    return m_overhead;
+}
+
+// MARK: - Private Functions
+/**
+ * get the length of the instruction parameters of a transaction
+ * @param t_transaction the transaction
+ * @return the length in bytes
+ */
+uint32_t Dynamixel_Bus_Model::m_get_param_length(const Dynamixel_Transaction &t_transaction) {
+    switch (t_transaction.instruction) {
+        case INST_PING:
+        case INST_REBOOT:
+            return 0;
+        case INST_READ:
+            return 4;
+        case INST_WRITE:
+            return 2 + t_transaction.data_length;
+        case INST_SYNC_READ:
+            return 4 + t_transaction.count;
+        case INST_SYNC_WRITE:
+            return 4 + t_transaction.count + t_transaction.data_length;
+        case INST_BULK_READ:
+            return 5 * t_transaction.count;
+        case INST_BULK_WRITE:
+            return 5 * t_transaction.count + t_transaction.data_length;
+        default:
+            return t_transaction.data_length;
+    }
+}
@@ -0,0 +1,206 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_BUS_MODEL_H
+#define DYNAMIXEL_DYNAMIXEL_BUS_MODEL_H
+
+#include <cstdint>
+#include <vector>
+#include "dynamixel.h"
+#include "dynamixel_packet.h"
+
+/**
+ * a single bus transaction of a planned tick
+ */
+struct Dynamixel_Transaction {
+    /**
+     * the instruction -> INST_PING, INST_READ, INST_WRITE, INST_REBOOT, INST_SYNC_READ, INST_SYNC_WRITE, INST_BULK_READ, INST_BULK_WRITE
+     */
+    uint8_t instruction;
+    /**
+     * the amount of addressed dynamixel's
+     */
+    uint16_t count;
+    /**
+     * the amount of data bytes summed over all addressed dynamixel's
+     */
+    uint16_t data_length;
+};
+
+/**
+ * the result of an admission check
+ */
+enum Dynamixel_Admission {
+    DXL_ADMISSION_ACCEPT = 0,
+    DXL_ADMISSION_WARN = 1,
+    DXL_ADMISSION_REJECT = 2,
+};
+
+/**
+ * predicts the bus time of the packets the library emits
+ * time = overhead + latency (if a status is expected) + bytes * byte time + statuses * return delay
+ */
+class Dynamixel_Bus_Model {
+// public declaration
+public:
+    /**
+     * initialize the bus model
+     * @param t_baud_rate the baudrate | default -> 1_000_000
+     * @param t_return_delay_time the return delay time register value (2 usec units) | default -> 250
+     * @param t_latency the latency of the usb adapter in seconds | default -> 0.001
+     */
+    explicit Dynamixel_Bus_Model(int t_baud_rate = 1000000, uint8_t t_return_delay_time = 250, double t_latency = 1.0e-3):
+            m_byte_time(10.0 / t_baud_rate),
+            m_return_delay(t_return_delay_time * 2.0e-6),
+            m_latency(t_latency) {
+    };
+    /**
+     * account for the worst case byte stuffing instead of none
+     * @param t_worst_case enable or disable
+     */
+    void set_worst_case(bool t_worst_case);
+    /**
+     * get the length of an instruction packet on the wire
+     * @param t_transaction the transaction
+     * @return the length in bytes
+     */
+    uint32_t get_instruction_length(const Dynamixel_Transaction &t_transaction);
+    /**
+     * get the length of all status packets of a transaction on the wire
+     * @param t_transaction the transaction
+     * @return the length in bytes
+     */
+    uint32_t get_status_length(const Dynamixel_Transaction &t_transaction);
+    /**
+     * get the amount of status packets of a transaction
+     * @param t_transaction the transaction
+     * @return the amount of status packets
+     */
+    uint32_t get_status_count(const Dynamixel_Transaction &t_transaction);
+    /**
+     * get the wire time of an encoded packet
+     * @param t_length the length of the packet in bytes
+     * @return the wire time in seconds
+     */
+    double get_wire_time(size_t t_length);
+    /**
+     * get the predicted time of a transaction including return delay and latency
+     * @param t_transaction the transaction
+     * @return the time in seconds
+     */
+    double get_transaction_time(const Dynamixel_Transaction &t_transaction);
+    /**
+     * get the predicted time of a planned tick
+     * @param t_plan the transactions of a tick
+     * @return the time in seconds
+     */
+    double get_cycle_time(const std::vector<Dynamixel_Transaction> &t_plan);
+    /**
+     * check if a planned tick can be sustained at a target rate
+     * @param t_plan the transactions of a tick
+     * @param t_rate the target rate in hz
+     * @param t_margin the usable fraction of the period before warning | default -> 0.8
+     * @return accept, warn or reject
+     */
+    Dynamixel_Admission get_admission(const std::vector<Dynamixel_Transaction> &t_plan, double t_rate, double t_margin = 0.8);
+    /**
+     * add a measured transaction time for the calibration
+     * @param t_transaction the transaction
+     * @param t_time the measured time in seconds
+     */
+    void set_measurement(const Dynamixel_Transaction &t_transaction, double t_time);
+    /**
+     * measure transactions on the real bus and fit the model to them,
+     * with a single dynamixel the return delay is taken from its register
+     * @param t_dynamixel the dynamixel bus
+     * @param t_dxl_ids the identifiers of the connected dynamixel's
+     * @param t_rounds the amount of measurements per transaction type | default -> 20
+     * @return true if the fit succeeded
+     */
+    bool set_calibration(Dynamixel &t_dynamixel, const std::vector<uint8_t> &t_dxl_ids, uint32_t t_rounds = 20);
+    /**
+     * fit the model to the added measurements
+     * @return true if the fit succeeded
+     */
+    bool set_calibration();
+    /**
+     * get the time per byte on the wire
+     * @return the time in seconds
+     */
+    double get_byte_time();
+    /**
+     * get the return delay of a dynamixel
+     * @return the time in seconds
+     */
+    double get_return_delay();
+    /**
+     * get the latency of the usb adapter
+     * @return the time in seconds
+     */
+    double get_latency();
+    /**
+     * get the fixed overhead of every transaction
+     * @return the time in seconds
+     */
+    double get_overhead();
+
+// private declaration
+private:
+    /**
+     * a measured transaction
+     */
+    struct Dynamixel_Measurement {
+        double bytes;
+        double statuses;
+        double replied;
+        double time;
+    };
+    /**
+     * the time per byte (start + 8 data + stop bit)
+     */
+    double m_byte_time;
+    /**
+     * the return delay of a dynamixel
+     */
+    double m_return_delay;
+    /**
+     * the latency of the usb adapter until a status is seen
+     */
+    double m_latency;
+    /**
+     * the fixed overhead (syscalls) of every transaction
+     */
+    double m_overhead = 0.0;
+    /**
+     * account for worst case stuffing
+     */
+    bool m_worst_case = false;
+    /**
+     * the measurements for the calibration
+     */
+    std::vector<Dynamixel_Measurement> m_measurements;
+    /**
+     * get the length of the instruction parameters of a transaction
+     * @param t_transaction the transaction
+     * @return the length in bytes
+     */
+    uint32_t m_get_param_length(const Dynamixel_Transaction &t_transaction);
+};
+
+#endif
@@ -0,0 +1,383 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <algorithm>
+#include "dynamixel_clock.h"
+#include "dynamixel_capture.h"
+
+/**
+ * initialize the capture
+ * @param t_port_handler the wrapped port handler
+ * @param t_path the path of the capture file
+ */
+Dynamixel_Capture_Port::Dynamixel_Capture_Port(dynamixel::PortHandler *t_port_handler, const char* t_path):
+        m_port_handler(t_port_handler),
+        m_file(fopen(t_path, "wb")) {
+    is_using_ = false;
+    if (m_file == nullptr) {
+        printf("failed: open capture file %s\n", t_path);
+        return;
+    }
+    fwrite(DXL_CAPTURE_MAGIC, 1, DXL_CAPTURE_MAGIC_LEN, m_file);
+}
+/**
+ * flush and close the capture file
+ */
+Dynamixel_Capture_Port::~Dynamixel_Capture_Port() {
+    if (m_file != nullptr) {
+        fclose(m_file);
+    }
+}
+/**
+ * open the wrapped port
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Capture_Port::openPort() {
+    return m_port_handler->openPort();
+}
+/**
+ * close the wrapped port and flush the capture file
+ */
+void Dynamixel_Capture_Port::closePort() {
+    m_port_handler->closePort();
+    if (m_file != nullptr) {
+        fflush(m_file);
+    }
+}
+/**
+ * clear the wrapped port
+ */
+void Dynamixel_Capture_Port::clearPort() {
+    m_port_handler->clearPort();
+}
+/**
+ * set the name of the wrapped port
+ * @param t_port_name the name of the port
+ */
+void Dynamixel_Capture_Port::setPortName(const char *t_port_name) {
+    m_port_handler->setPortName(t_port_name);
+}
+/**
+ * get the name of the wrapped port
+ * @return the name of the port
+ */
+char *Dynamixel_Capture_Port::getPortName() {
+    return m_port_handler->getPortName();
+}
+/**
+ * set the baud rate of the wrapped port
+ * @param t_baud_rate the baud rate
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Capture_Port::setBaudRate(const int t_baud_rate) {
+    return m_port_handler->setBaudRate(t_baud_rate);
+}
+/**
+ * get the baud rate of the wrapped port
+ * @return the baud rate
+ */
+int Dynamixel_Capture_Port::getBaudRate() {
+    return m_port_handler->getBaudRate();
+}
+/**
+ * get the amount of received bytes
+ * @return the amount of bytes
+ */
+int Dynamixel_Capture_Port::getBytesAvailable() {
+    return m_port_handler->getBytesAvailable();
+}
+/**
+ * read from the wrapped port and capture the bytes
+ * @param t_packet the buffer
+ * @param t_length the length of the buffer
+ * @return the amount of bytes which were read
+ */
+int Dynamixel_Capture_Port::readPort(uint8_t *t_packet, int t_length) {
+    int dxl_length = m_port_handler->readPort(t_packet, t_length);
+    if (dxl_length > 0) {
+        m_set_record(DXL_CAPTURE_RX, t_packet, dxl_length);
+    }
+    return dxl_length;
+}
+/**
+ * capture the bytes and write them to the wrapped port
+ * @param t_packet the packet
+ * @param t_length the length of the packet
+ * @return the amount of bytes which were written
+ */
+int Dynamixel_Capture_Port::writePort(uint8_t *t_packet, int t_length) {
+    m_set_record(DXL_CAPTURE_TX, t_packet, t_length);
+    return m_port_handler->writePort(t_packet, t_length);
+}
+/**
+ * start waiting for a status of a known length
+ * @param t_packet_length the length of the status in bytes
+ */
+void Dynamixel_Capture_Port::setPacketTimeout(uint16_t t_packet_length) {
+    m_port_handler->setPacketTimeout(t_packet_length);
+}
+/**
+ * start waiting for a fixed time
+ * @param t_msec the time in milliseconds
+ */
+void Dynamixel_Capture_Port::setPacketTimeout(double t_msec) {
+    m_port_handler->setPacketTimeout(t_msec);
+}
+/**
+ * check if the wait timed out
+ * @return true if timed out otherwise false
+ */
+bool Dynamixel_Capture_Port::isPacketTimeout() {
+    return m_port_handler->isPacketTimeout();
+}
+/**
+ * get the amount of captured bytes
+ * @return the amount of bytes
+ */
+uint64_t Dynamixel_Capture_Port::get_captured() {
+    return m_captured;
+}
+
+/**
+ * load a capture file
+ * @param t_path the path of the capture file
+ */
+Dynamixel_Replay_Port::Dynamixel_Replay_Port(const char* t_path) {
+    is_using_ = false;
+    strncpy(m_port_name, t_path, sizeof(m_port_name) - 1);
+    m_port_name[sizeof(m_port_name) - 1] = '\0';
+    FILE *dxl_file = fopen(t_path, "rb");
+    if (dxl_file == nullptr) {
+        printf("failed: open capture file %s\n", t_path);
+        return;
+    }
+    char dxl_magic[DXL_CAPTURE_MAGIC_LEN];
+    if (fread(dxl_magic, 1, DXL_CAPTURE_MAGIC_LEN, dxl_file) != DXL_CAPTURE_MAGIC_LEN || memcmp(dxl_magic, DXL_CAPTURE_MAGIC, DXL_CAPTURE_MAGIC_LEN) != 0) {
+        printf("failed: %s is not a capture file\n", t_path);
+        fclose(dxl_file);
+        return;
+    }
+    uint8_t dxl_header[DXL_CAPTURE_RECORD_LEN];
+    while (fread(dxl_header, 1, DXL_CAPTURE_RECORD_LEN, dxl_file) == DXL_CAPTURE_RECORD_LEN) {
+        uint64_t dxl_time = 0;
+        for (int i = 7; i >= 0; i--) {
+            dxl_time = (dxl_time << 8) | dxl_header[i];
+        }
+        uint32_t dxl_length = 0;
+        for (int i = 12; i >= 9; i--) {
+            dxl_length = (dxl_length << 8) | dxl_header[i];
+        }
+        Dynamixel_Record dxl_record = {(double)dxl_time * 1e-9, dxl_header[8], m_data.size(), dxl_length};
+        m_data.resize(dxl_record.offset + dxl_record.length);
+        if (fread(m_data.data() + dxl_record.offset, 1, dxl_record.length, dxl_file) != dxl_record.length) {
+            // a capture which was cut off while writing, keep every complete record
+            m_data.resize(dxl_record.offset);
+            break;
+        }
+        m_records.push_back(dxl_record);
+    }
+    fclose(dxl_file);
+    m_loaded = true;
+}
+/**
+ * open the replay
+ * @return true if the capture was loaded otherwise false
+ */
+bool Dynamixel_Replay_Port::openPort() {
+    return m_loaded;
+}
+/**
+ * close the replay
+ */
+void Dynamixel_Replay_Port::closePort() {
+}
+/**
+ * drop all bytes which are already received
+ */
+void Dynamixel_Replay_Port::clearPort() {
+    while (m_next < m_records.size() && m_records[m_next].direction == DXL_CAPTURE_RX && m_get_due(m_next)) {
+        m_next++;
+        m_consumed = 0;
+    }
+}
+/**
+ * set the name of the replay
+ * @param t_port_name the name of the port
+ */
+void Dynamixel_Replay_Port::setPortName(const char *t_port_name) {
+    strncpy(m_port_name, t_port_name, sizeof(m_port_name) - 1);
+    m_port_name[sizeof(m_port_name) - 1] = '\0';
+}
+/**
+ * get the name of the replay
+ * @return the name of the port
+ */
+char *Dynamixel_Replay_Port::getPortName() {
+    return m_port_name;
+}
+/**
+ * set the baud rate, only used for the packet timeout
+ * @param t_baud_rate the baud rate
+ * @return true
+ */
+bool Dynamixel_Replay_Port::setBaudRate(const int t_baud_rate) {
+    m_baud_rate = t_baud_rate;
+    return true;
+}
+/**
+ * get the baud rate
+ * @return the baud rate
+ */
+int Dynamixel_Replay_Port::getBaudRate() {
+    return m_baud_rate;
+}
+/**
+ * get the amount of received bytes which are due
+ * @return the amount of bytes
+ */
+int Dynamixel_Replay_Port::getBytesAvailable() {
+    int dxl_available = 0;
+    size_t dxl_consumed = m_consumed;
+    for (size_t i = m_next; i < m_records.size() && m_records[i].direction == DXL_CAPTURE_RX && m_get_due(i); i++) {
+        dxl_available += (int)(m_records[i].length - dxl_consumed);
+        dxl_consumed = 0;
+    }
+    return dxl_available;
+}
+/**
+ * read the received bytes which are due
+ * @param t_packet the buffer
+ * @param t_length the length of the buffer
+ * @return the amount of bytes which were read
+ */
+int Dynamixel_Replay_Port::readPort(uint8_t *t_packet, int t_length) {
+    int dxl_length = 0;
+    while (dxl_length < t_length && m_next < m_records.size() && m_records[m_next].direction == DXL_CAPTURE_RX && m_get_due(m_next)) {
+        const Dynamixel_Record &dxl_record = m_records[m_next];
+        size_t dxl_count = std::min((size_t)(t_length - dxl_length), dxl_record.length - m_consumed);
+        memcpy(t_packet + dxl_length, m_data.data() + dxl_record.offset + m_consumed, dxl_count);
+        dxl_length += (int)dxl_count;
+        m_consumed += dxl_count;
+        if (m_consumed == dxl_record.length) {
+            m_next++;
+            m_consumed = 0;
+        }
+    }
+    return dxl_length;
+}
+/**
+ * match a write against the next captured write, starts the clock of the following received bytes
+ * @param t_packet the packet
+ * @param t_length the length of the packet
+ * @return the amount of bytes which were written
+ */
+int Dynamixel_Replay_Port::writePort(uint8_t *t_packet, int t_length) {
+    // received bytes which were never read are dropped, same as a real port after the next clear
+    while (m_next < m_records.size() && m_records[m_next].direction != DXL_CAPTURE_TX) {
+        m_next++;
+    }
+    m_consumed = 0;
+    if (m_next == m_records.size()) {
+        printf("failed: replay has no more writes\n");
+        m_divergences++;
+        return t_length;
+    }
+    const Dynamixel_Record &dxl_record = m_records[m_next];
+    if (dxl_record.length != (uint32_t)t_length || memcmp(m_data.data() + dxl_record.offset, t_packet, t_length) != 0) {
+        m_divergences++;
+    }
+    m_anchor_host = Dynamixel_Clock::get_monotonic_time();
+    m_anchor_record = dxl_record.time;
+    m_next++;
+    return t_length;
+}
+/**
+ * start waiting for a status of a known length
+ * @param t_packet_length the length of the status in bytes
+ */
+void Dynamixel_Replay_Port::setPacketTimeout(uint16_t t_packet_length) {
+    // same as the sdk: byte time, twice the usb latency timer and 2 ms
+    m_start = Dynamixel_Clock::get_monotonic_time();
+    m_timeout = (10.0 / m_baud_rate) * t_packet_length + 0.016 * 2 + 0.002;
+}
+/**
+ * start waiting for a fixed time
+ * @param t_msec the time in milliseconds
+ */
+void Dynamixel_Replay_Port::setPacketTimeout(double t_msec) {
+    m_start = Dynamixel_Clock::get_monotonic_time();
+    m_timeout = t_msec / 1000.0;
+}
+/**
+ * check if the wait timed out
+ * @return true if timed out otherwise false
+ */
+bool Dynamixel_Replay_Port::isPacketTimeout() {
+    return Dynamixel_Clock::get_monotonic_time() - m_start > m_timeout;
+}
+/**
+ * get the amount of writes which did not match the capture
+ * @return the amount of writes
+ */
+size_t Dynamixel_Replay_Port::get_divergences() {
+    return m_divergences;
+}
+/**
+ * check if every record of the capture was played
+ * @return true if finished otherwise false
+ */
+bool Dynamixel_Replay_Port::get_finished() {
+    return m_next == m_records.size();
+}
+
+// MARK: - Private Functions
+
+/**
+ * write a record into the capture file
+ * @param t_direction the direction -> DXL_CAPTURE_TX, DXL_CAPTURE_RX
+ * @param t_data the bytes
+ * @param t_length the amount of bytes
+ */
+void Dynamixel_Capture_Port::m_set_record(uint8_t t_direction, const uint8_t *t_data, int t_length) {
+    if (m_file == nullptr || t_length <= 0) {
+        return;
+    }
+    uint64_t dxl_time = (uint64_t)(Dynamixel_Clock::get_monotonic_time() * 1e9);
+    uint8_t dxl_header[DXL_CAPTURE_RECORD_LEN];
+    for (int i = 0; i < 8; i++) {
+        dxl_header[i] = (uint8_t)(dxl_time >> (8 * i));
+    }
+    dxl_header[8] = t_direction;
+    for (int i = 0; i < 4; i++) {
+        dxl_header[9 + i] = (uint8_t)((uint32_t)t_length >> (8 * i));
+    }
+    fwrite(dxl_header, 1, DXL_CAPTURE_RECORD_LEN, m_file);
+    fwrite(t_data, 1, t_length, m_file);
+    m_captured += t_length;
+}
+/**
+ * check if a received record is due
+ * @param t_index the index of the record
+ * @return true if due otherwise false
+ */
+bool Dynamixel_Replay_Port::m_get_due(size_t t_index) {
+    // a status arrives at the same time after its write as in the capture
+    return Dynamixel_Clock::get_monotonic_time() - m_anchor_host >= m_records[t_index].time - m_anchor_record;
+}
@@ -0,0 +1,307 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_CAPTURE_H
+#define DYNAMIXEL_DYNAMIXEL_CAPTURE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <dynamixel_sdk.h>
+
+#define DXL_CAPTURE_MAGIC "DXLCAP02"
+#define DXL_CAPTURE_MAGIC_LEN 8
+#define DXL_CAPTURE_RECORD_LEN 13
+#define DXL_CAPTURE_TX 0
+#define DXL_CAPTURE_RX 1
+
+/**
+ * wraps a port handler and writes every transmitted and received byte with a
+ * monotonic time stamp into a capture file
+ * file: "DXLCAP02", then records of u64 time in ns, u8 direction (0 = tx, 1 = rx), u32 length, bytes (little endian)
+ */
+class Dynamixel_Capture_Port : public dynamixel::PortHandler {
+// public declaration
+public:
+    /**
+     * initialize the capture
+     * @param t_port_handler the wrapped port handler
+     * @param t_path the path of the capture file
+     */
+    Dynamixel_Capture_Port(dynamixel::PortHandler *t_port_handler, const char* t_path);
+    /**
+     * flush and close the capture file
+     */
+    ~Dynamixel_Capture_Port() override;
+    /**
+     * open the wrapped port
+     * @return true if success otherwise false
+     */
+    bool openPort() override;
+    /**
+     * close the wrapped port and flush the capture file
+     */
+    void closePort() override;
+    /**
+     * clear the wrapped port
+     */
+    void clearPort() override;
+    /**
+     * set the name of the wrapped port
+     * @param t_port_name the name of the port
+     */
+    void setPortName(const char *t_port_name) override;
+    /**
+     * get the name of the wrapped port
+     * @return the name of the port
+     */
+    char *getPortName() override;
+    /**
+     * set the baud rate of the wrapped port
+     * @param t_baud_rate the baud rate
+     * @return true if success otherwise false
+     */
+    bool setBaudRate(const int t_baud_rate) override;
+    /**
+     * get the baud rate of the wrapped port
+     * @return the baud rate
+     */
+    int getBaudRate() override;
+    /**
+     * get the amount of received bytes
+     * @return the amount of bytes
+     */
+    int getBytesAvailable() override;
+    /**
+     * read from the wrapped port and capture the bytes
+     * @param t_packet the buffer
+     * @param t_length the length of the buffer
+     * @return the amount of bytes which were read
+     */
+    int readPort(uint8_t *t_packet, int t_length) override;
+    /**
+     * capture the bytes and write them to the wrapped port
+     * @param t_packet the packet
+     * @param t_length the length of the packet
+     * @return the amount of bytes which were written
+     */
+    int writePort(uint8_t *t_packet, int t_length) override;
+    /**
+     * start waiting for a status of a known length
+     * @param t_packet_length the length of the status in bytes
+     */
+    void setPacketTimeout(uint16_t t_packet_length) override;
+    /**
+     * start waiting for a fixed time
+     * @param t_msec the time in milliseconds
+     */
+    void setPacketTimeout(double t_msec) override;
+    /**
+     * check if the wait timed out
+     * @return true if timed out otherwise false
+     */
+    bool isPacketTimeout() override;
+    /**
+     * get the amount of captured bytes
+     * @return the amount of bytes
+     */
+    uint64_t get_captured();
+
+// private declaration
+private:
+    /**
+     * the wrapped port handler
+     */
+    dynamixel::PortHandler *m_port_handler;
+    /**
+     * the capture file
+     */
+    FILE *m_file;
+    /**
+     * the amount of captured bytes
+     */
+    uint64_t m_captured = 0;
+    /**
+     * write a record into the capture file
+     * @param t_direction the direction -> DXL_CAPTURE_TX, DXL_CAPTURE_RX
+     * @param t_data the bytes
+     * @param t_length the amount of bytes
+     */
+    void m_set_record(uint8_t t_direction, const uint8_t *t_data, int t_length);
+};
+
+/**
+ * a port handler which plays a capture file back, every received byte becomes
+ * available at the same time after the preceding write as in the capture
+ */
+class Dynamixel_Replay_Port : public dynamixel::PortHandler {
+// public declaration
+public:
+    /**
+     * load a capture file
+     * @param t_path the path of the capture file
+     */
+    explicit Dynamixel_Replay_Port(const char* t_path);
+    /**
+     * open the replay
+     * @return true if the capture was loaded otherwise false
+     */
+    bool openPort() override;
+    /**
+     * close the replay
+     */
+    void closePort() override;
+    /**
+     * drop all bytes which are already received
+     */
+    void clearPort() override;
+    /**
+     * set the name of the replay
+     * @param t_port_name the name of the port
+     */
+    void setPortName(const char *t_port_name) override;
+    /**
+     * get the name of the replay
+     * @return the name of the port
+     */
+    char *getPortName() override;
+    /**
+     * set the baud rate, only used for the packet timeout
+     * @param t_baud_rate the baud rate
+     * @return true
+     */
+    bool setBaudRate(const int t_baud_rate) override;
+    /**
+     * get the baud rate
+     * @return the baud rate
+     */
+    int getBaudRate() override;
+    /**
+     * get the amount of received bytes which are due
+     * @return the amount of bytes
+     */
+    int getBytesAvailable() override;
+    /**
+     * read the received bytes which are due
+     * @param t_packet the buffer
+     * @param t_length the length of the buffer
+     * @return the amount of bytes which were read
+     */
+    int readPort(uint8_t *t_packet, int t_length) override;
+    /**
+     * match a write against the next captured write, starts the clock of the following received bytes
+     * @param t_packet the packet
+     * @param t_length the length of the packet
+     * @return the amount of bytes which were written
+     */
+    int writePort(uint8_t *t_packet, int t_length) override;
+    /**
+     * start waiting for a status of a known length
+     * @param t_packet_length the length of the status in bytes
+     */
+    void setPacketTimeout(uint16_t t_packet_length) override;
+    /**
+     * start waiting for a fixed time
+     * @param t_msec the time in milliseconds
+     */
+    void setPacketTimeout(double t_msec) override;
+    /**
+     * check if the wait timed out
+     * @return true if timed out otherwise false
+     */
+    bool isPacketTimeout() override;
+    /**
+     * get the amount of writes which did not match the capture
+     * @return the amount of writes
+     */
+    size_t get_divergences();
+    /**
+     * check if every record of the capture was played
+     * @return true if finished otherwise false
+     */
+    bool get_finished();
+
+// private declaration
+private:
+    /**
+     * a record of the capture
+     */
+    struct Dynamixel_Record {
+        double time;
+        uint8_t direction;
+        size_t offset;
+        uint32_t length;
+    };
+    /**
+     * the records of the capture
+     */
+    std::vector<Dynamixel_Record> m_records;
+    /**
+     * the bytes of all records
+     */
+    std::vector<uint8_t> m_data;
+    /**
+     * the name of the replay
+     */
+    char m_port_name[100];
+    /**
+     * true if the capture was loaded
+     */
+    bool m_loaded = false;
+    /**
+     * the baud rate
+     */
+    int m_baud_rate = 1000000;
+    /**
+     * the next record to play
+     */
+    size_t m_next = 0;
+    /**
+     * the bytes of the next record which were already read
+     */
+    size_t m_consumed = 0;
+    /**
+     * the host time of the last write
+     */
+    double m_anchor_host = 0.0;
+    /**
+     * the capture time of the last write
+     */
+    double m_anchor_record = 0.0;
+    /**
+     * the amount of writes which did not match the capture
+     */
+    size_t m_divergences = 0;
+    /**
+     * the host time at which the wait started
+     */
+    double m_start = 0.0;
+    /**
+     * the timeout of the current wait in seconds
+     */
+    double m_timeout = 0.0;
+    /**
+     * check if a received record is due
+     * @param t_index the index of the record
+     * @return true if due otherwise false
+     */
+    bool m_get_due(size_t t_index);
+};
+
+#endif
@@ -0,0 +1,642 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "dynamixel_client.h"
+
+/**
+ * close the connection
+ */
+Dynamixel_Client::~Dynamixel_Client() {
+    set_close();
+}
+/**
+ * connect to the daemon
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Client::set_open() {
+    if (m_socket >= 0) {
+        return true;
+    }
+    sockaddr_un dxl_address = {};
+    dxl_address.sun_family = AF_UNIX;
+    if (strlen(m_socket_path) >= sizeof(dxl_address.sun_path)) {
+        printf("failed: socket path too long\n");
+        return false;
+    }
+    strcpy(dxl_address.sun_path, m_socket_path);
+    m_socket = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (m_socket < 0) {
+        printf("failed: create socket\n");
+        return false;
+    }
+    if (connect(m_socket, (sockaddr*)&dxl_address, sizeof(dxl_address)) != 0) {
+        printf("failed: connect to daemon %s\n", m_socket_path);
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+    return true;
+}
+/**
+ * close the connection to the daemon
+ */
+void Dynamixel_Client::set_close() {
+    if (m_socket < 0) {
+        return;
+    }
+    close(m_socket);
+    m_socket = -1;
+}
+/**
+ * get the torque of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the torque value
+ */
+uint8_t Dynamixel_Client::get_torque(uint8_t t_dxl_id) {
+    uint8_t dxl_torque = m_get_small_register(t_dxl_id, ADDR_TORQUE);
+    return dxl_torque;
+}
+/**
+ * get the led status of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the led status value
+ */
+uint8_t Dynamixel_Client::get_led(uint8_t t_dxl_id) {
+    uint8_t dxl_led = m_get_small_register(t_dxl_id, ADDR_LED);
+    return dxl_led;
+}
+/**
+ * get the current id of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel id
+ */
+uint8_t Dynamixel_Client::get_id(uint8_t t_dxl_id) {
+    uint8_t dxl_mid = m_get_small_register(t_dxl_id, ADDR_ID);
+    return dxl_mid;
+}
+/**
+ * get the current shadow id of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel shadow id
+ */
+uint8_t Dynamixel_Client::get_shadow_id(uint8_t t_dxl_id) {
+    uint8_t dxl_shadow_id = m_get_small_register(t_dxl_id, ADDR_SHADOW_ID);
+    return dxl_shadow_id;
+}
+/**
+ * get the current drive mode of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel drive mode value
+ */
+uint8_t Dynamixel_Client::get_drive_mode(uint8_t t_dxl_id) {
+    uint8_t dxl_drive_mode = m_get_small_register(t_dxl_id, ADDR_DRIVE_MODE);
+    return dxl_drive_mode;
+}
+/**
+ * get the current operating mode of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel operating mode value
+ */
+uint8_t Dynamixel_Client::get_operating_mode(uint8_t t_dxl_id) {
+    uint8_t dxl_operating_mode = m_get_small_register(t_dxl_id, ADDR_OPERATING_MODE);
+    return dxl_operating_mode;
+}
+/**
+ * get the current firmware version of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel firmware version
+ */
+uint8_t Dynamixel_Client::get_firmware_version(uint8_t t_dxl_id) {
+    uint8_t dxl_firmware_version = m_get_small_register(t_dxl_id, ADDR_FIRMWARE_VERSION);
+    return dxl_firmware_version;
+}
+/**
+ * get the current protocol type of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel protocol version
+ */
+uint8_t Dynamixel_Client::get_protocol_type(uint8_t t_dxl_id) {
+    uint8_t dxl_protocol_type = m_get_small_register(t_dxl_id, ADDR_PROTOCOL_TYPE);
+    return dxl_protocol_type;
+}
+/**
+ * get the current present temperature of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel present temperature
+ */
+uint8_t Dynamixel_Client::get_present_temperature(uint8_t t_dxl_id) {
+    uint8_t dxl_temperature = m_get_small_register(t_dxl_id, ADDR_PRESENT_TEMPERATURE);
+    return dxl_temperature;
+}
+/**
+ * get the current velocity P-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel velocity P_GAIN value
+ */
+uint16_t Dynamixel_Client::get_velocity_kp_gain(uint8_t t_dxl_id) {
+    uint16_t dxl_gain = m_get_medium_register(t_dxl_id, ADDR_VELOCITY_P_GAIN);
+    return dxl_gain;
+}
+/**
+ * get the current velocity I-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel velocity I-GAIN value
+ */
+uint16_t Dynamixel_Client::get_velocity_ki_gain(uint8_t t_dxl_id) {
+    uint16_t dxl_gain = m_get_medium_register(t_dxl_id, ADDR_VELOCITY_I_GAIN);
+    return dxl_gain;
+}
+/**
+ * get the current t_position P-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel t_position P-GAIN value
+ */
+uint16_t Dynamixel_Client::get_position_kp_gain(uint8_t t_dxl_id) {
+    uint16_t dxl_gain = m_get_medium_register(t_dxl_id, ADDR_POSITION_P_GAIN);
+    return dxl_gain;
+}
+/**
+ * get the current t_position I-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel t_position I-GAIN value
+ */
+uint16_t Dynamixel_Client::get_position_ki_gain(uint8_t t_dxl_id) {
+    uint16_t dxl_gain = m_get_medium_register(t_dxl_id, ADDR_POSITION_I_GAIN);
+    return dxl_gain;
+}
+/**
+ * get the current t_position D-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel t_position D-GAIN value
+ */
+uint16_t Dynamixel_Client::get_position_kd_gain(uint8_t t_dxl_id) {
+    uint16_t dxl_gain = m_get_medium_register(t_dxl_id, ADDR_POSITION_D_GAIN);
+    return dxl_gain;
+}
+/**
+ * get the current feedforward first-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel feedforward first-GAIN value
+ */
+uint16_t Dynamixel_Client::get_feedforward_first_gain(uint8_t t_dxl_id) {
+    uint16_t dxl_gain = m_get_medium_register(t_dxl_id, ADDR_FEEDFORWARD_1_GAIN);
+    return dxl_gain;
+}
+/**
+ * get the current feedforward second-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel feedforward second-GAIN value
+ */
+uint16_t Dynamixel_Client::get_feedforward_second_gain(uint8_t t_dxl_id) {
+    uint16_t dxl_gain = m_get_medium_register(t_dxl_id, ADDR_FEEDFORWARD_2_GAIN);
+    return dxl_gain;
+}
+/**
+ * get the model number of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel model number
+ */
+uint16_t Dynamixel_Client::get_model_number(uint8_t t_dxl_id) {
+    uint16_t dxl_model_number = m_get_medium_register(t_dxl_id, ADDR_MODEL_NUMBER);
+    return dxl_model_number;
+}
+/**
+ * get the present load of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel present load
+ */
+uint16_t Dynamixel_Client::get_present_load(uint8_t t_dxl_id) {
+    uint16_t dxl_load = m_get_medium_register(t_dxl_id, ADDR_PRESENT_LOAD);
+    return dxl_load;
+}
+/**
+ * get the input voltage of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel input voltage value
+ */
+uint16_t Dynamixel_Client::get_present_input_voltage(uint8_t t_dxl_id) {
+    uint16_t dxl_input_voltage = m_get_medium_register(t_dxl_id, ADDR_PRESENT_INPUT_VOLTAGE);
+    return dxl_input_voltage;
+}
+/**
+ * get the real time tick of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel real time tick
+ */
+uint16_t Dynamixel_Client::get_realtime_tick(uint8_t t_dxl_id) {
+    uint16_t dxl_realtime_tick = m_get_medium_register(t_dxl_id, ADDR_REALTIME_TICK);
+    return dxl_realtime_tick;
+}
+/**
+ * get the present pwm of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel pwm value
+ */
+uint32_t Dynamixel_Client::get_present_pwm(uint8_t t_dxl_id) {
+    uint32_t dxl_pwm = m_get_large_register(t_dxl_id, ADDR_PRESENT_PWM);
+    return dxl_pwm;
+}
+/**
+ * get the present velocity of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel present velocity value
+ */
+uint32_t Dynamixel_Client::get_present_velocity(uint8_t t_dxl_id) {
+    uint32_t dxl_velocity = m_get_large_register(t_dxl_id, ADDR_PRESENT_VELOCITY);
+    return dxl_velocity;
+}
+/**
+ * get the present t_position of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel present t_position value
+ */
+uint32_t Dynamixel_Client::get_present_position(uint8_t t_dxl_id) {
+    uint32_t dxl_position = m_get_large_register(t_dxl_id, ADDR_PRESENT_POSITION);
+    return dxl_position;
+}
+/**
+ * get a time stamped state snapshot of a dynamixel (realtime tick up to present position in one read)
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the state snapshot
+ */
+Dynamixel_State Dynamixel_Client::get_state(uint8_t t_dxl_id) {
+    uint8_t dxl_data[ADDR_STATE_LEN] = {0};
+    bool dxl_result = m_get_register(t_dxl_id, ADDR_REALTIME_TICK, ADDR_STATE_LEN, dxl_data);
+
+    Dynamixel_State dxl_state{};
+    dxl_state.id = t_dxl_id;
+    dxl_state.realtime_tick = DXL_MAKEWORD(dxl_data[0], dxl_data[1]);
+    dxl_state.moving = dxl_data[ADDR_MOVING - ADDR_REALTIME_TICK];
+    dxl_state.moving_status = dxl_data[ADDR_MOVING_STATUS - ADDR_REALTIME_TICK];
+    dxl_state.pwm = (int16_t)DXL_MAKEWORD(dxl_data[4], dxl_data[5]);
+    dxl_state.load = (int16_t)DXL_MAKEWORD(dxl_data[6], dxl_data[7]);
+    dxl_state.velocity = (int32_t)DXL_MAKEDWORD(DXL_MAKEWORD(dxl_data[8], dxl_data[9]), DXL_MAKEWORD(dxl_data[10], dxl_data[11]));
+    dxl_state.position = (int32_t)DXL_MAKEDWORD(DXL_MAKEWORD(dxl_data[12], dxl_data[13]), DXL_MAKEWORD(dxl_data[14], dxl_data[15]));
+    // the clock correlation lives in the daemon, the response time is the best local estimate
+    dxl_state.time = Dynamixel_Clock::get_monotonic_time();
+    if (!dxl_result) {
+        printf("failed: get state of id: %i\n", t_dxl_id);
+    }
+    return dxl_state;
+}
+/**
+ * set the torque of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_torque_state enable or disable
+ */
+void Dynamixel_Client::set_torque(uint8_t t_dxl_id, bool t_torque_state) {
+    m_set_small_register(t_dxl_id, ADDR_TORQUE, t_torque_state);
+}
+/**
+ * set the led of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_led_state enable or disable
+ */
+void Dynamixel_Client::set_led(uint8_t t_dxl_id, bool t_led_state) {
+    m_set_small_register(t_dxl_id, ADDR_LED, t_led_state);
+}
+/**
+ * set the id of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param value id value -> 0-255
+ */
+void Dynamixel_Client::set_id(uint8_t t_dxl_id, uint8_t t_value) {
+    m_set_small_register(t_dxl_id, ADDR_ID, t_value);
+}
+/**
+ * set the shadow id of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param value the id value -> 0-253 | 255 disable's the shadow id
+ */
+void Dynamixel_Client::set_shadow_id(uint8_t t_dxl_id, uint8_t t_value) {
+    m_set_small_register(t_dxl_id, ADDR_SHADOW_ID, t_value);
+}
+/**
+ * set the operating mode of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_control_mode control mode value -> see dynamixel table
+ */
+void Dynamixel_Client::set_operating_mode(uint8_t t_dxl_id, uint8_t t_control_mode) {
+    m_set_small_register(t_dxl_id, ADDR_OPERATING_MODE, t_control_mode);
+}
+/**
+ * set the operating mode of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_drive_mode drive mode value -> see dynamixel table
+ */
+void Dynamixel_Client::set_drive_mode(uint8_t t_dxl_id, uint8_t t_drive_mode) {
+    m_set_small_register(t_dxl_id, ADDR_DRIVE_MODE, t_drive_mode);
+}
+/**
+ * set the velocity P-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param velocity I-GAIN value -> 0 - 16384
+ */
+void Dynamixel_Client::set_velocity_kp_gain(uint8_t t_dxl_id, uint16_t t_gain) {
+    m_set_medium_register(t_dxl_id, ADDR_VELOCITY_P_GAIN, t_gain);
+}
+/**
+ * set the velocity I-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param velocity P-GAIN value -> 0 - 16384
+ */
+void Dynamixel_Client::set_velocity_ki_gain(uint8_t t_dxl_id, uint16_t t_gain) {
+    m_set_medium_register(t_dxl_id, ADDR_VELOCITY_I_GAIN, t_gain);
+}
+/**
+ * set the t_position P-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_position P-GAIN value -> 0 - 16384
+ */
+void Dynamixel_Client::set_position_kp_gain(uint8_t t_dxl_id, uint16_t t_gain) {
+    m_set_medium_register(t_dxl_id, ADDR_POSITION_P_GAIN, t_gain);
+}
+/**
+ * set the t_position I-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_position I-GAIN value -> 0 - 16384
+ */
+void Dynamixel_Client::set_position_ki_gain(uint8_t t_dxl_id, uint16_t t_gain) {
+    m_set_medium_register(t_dxl_id, ADDR_POSITION_I_GAIN, t_gain);
+}
+/**
+ * set the t_position D-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_position D-GAIN value -> 0 - 16384
+ */
+void Dynamixel_Client::set_position_kd_gain(uint8_t t_dxl_id, uint16_t t_gain) {
+    m_set_medium_register(t_dxl_id, ADDR_POSITION_D_GAIN, t_gain);
+}
+/**
+ * set the feedforward first-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param feedforward first-GAIN value -> 0 - 16384
+ */
+void Dynamixel_Client::set_feedforward_first_gain(uint8_t t_dxl_id, uint16_t t_gain) {
+    m_set_medium_register(t_dxl_id, ADDR_FEEDFORWARD_1_GAIN, t_gain);
+}
+/**
+ * set the feedforward second-GAIN of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param feedforward second-GAIN value -> 0 - 16384
+ */
+void Dynamixel_Client::set_feedforward_second_gain(uint8_t t_dxl_id, uint16_t t_gain) {
+    m_set_medium_register(t_dxl_id, ADDR_FEEDFORWARD_2_GAIN, t_gain);
+}
+/**
+ * set the pwm of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param pwm value -> 0-885
+ */
+void Dynamixel_Client::set_goal_pwm(uint8_t t_dxl_id, uint16_t t_pwm) {
+    m_set_medium_register(t_dxl_id, ADDR_GOAL_PWM, t_pwm);
+}
+/**
+ * set the goal velocity of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param goal velocity value -> 0-265
+ */
+void Dynamixel_Client::set_goal_velocity(uint8_t t_dxl_id, uint32_t t_velocity) {
+    m_set_large_register(t_dxl_id, ADDR_GOAL_VELOCITY, t_velocity);
+}
+/**
+ * set the goal t_position of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_position goal t_position value -> 0-4096
+ */
+void Dynamixel_Client::set_goal_position(uint8_t t_dxl_id, uint32_t t_position) {
+    m_set_large_register(t_dxl_id, ADDR_GOAL_POSITION, t_position);
+}
+/**
+ * set the goal velocity of two dynamixel's
+ * @param t_dxl1_id the identifier of the dynamixel
+ * @param t_dxl2_id the identifier of the dynamixel
+ * @param t_dxl1_velocity goal velocity value -> 0-265
+ * @param t_dxl2_velocity goal velocity value -> 0-265
+ */
+void Dynamixel_Client::set_group_goal_velocity(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint32_t t_dxl1_velocity, uint32_t t_dxl2_velocity) {
+    m_set_group_register(t_dxl1_id, t_dxl2_id, ADDR_GOAL_VELOCITY, t_dxl1_velocity, t_dxl2_velocity);
+}
+/**
+ * set the goal t_position of two dynamixel's
+ * @param t_dxl1_id the identifier of the dynamixel
+ * @param t_dxl2_id the identifier of the dynamixel
+ * @param t_dxl1_position goal t_position value -> 0-4096
+ * @param t_dxl2_position goal t_position value -> 0-4096
+ */
+void Dynamixel_Client::set_group_goal_position(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint32_t t_dxl1_position, uint32_t t_dxl2_position) {
+    m_set_group_register(t_dxl1_id, t_dxl2_id, ADDR_GOAL_POSITION, t_dxl1_position, t_dxl2_position);
+}
+
+// MARK: - Private Functions to read/write to dynamixel register through the daemon
+/**
+ * send a request and wait for its response
+ * @param t_message the request, replaced by the response
+ * @return true if the request was served otherwise false
+ */
+bool Dynamixel_Client::m_set_request(Dynamixel_Message &t_message) {
+    if (m_socket < 0) {
+        printf("failed: not connected to the daemon\n");
+        return false;
+    }
+    t_message.sequence = ++m_sequence;
+    t_message.priority = m_priority;
+    t_message.result = 0;
+    if (send(m_socket, &t_message, sizeof(t_message), MSG_NOSIGNAL) != sizeof(t_message)) {
+        printf("failed: send request to daemon\n");
+        return false;
+    }
+    uint32_t dxl_sequence = t_message.sequence;
+    pollfd dxl_poll = {m_socket, POLLIN, 0};
+    // responses of requests which timed out earlier may still arrive, skip them
+    while (poll(&dxl_poll, 1, DXL_CLIENT_TIMEOUT) > 0) {
+        if (recv(m_socket, &t_message, sizeof(t_message), 0) != sizeof(t_message)) {
+            break;
+        }
+        if (t_message.sequence == dxl_sequence) {
+            return t_message.result != 0;
+        }
+    }
+    printf("failed: no response from daemon\n");
+    return false;
+}
+/**
+ * read a register through the daemon
+ * @param t_dxl_id the dynamixel identifier
+ * @param t_address the address to be read from
+ * @param t_length the length of the register -> 1-16
+ * @param t_data the little endian register bytes
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Client::m_get_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length, uint8_t *t_data) {
+    Dynamixel_Message dxl_message = {};
+    dxl_message.kind = DXL_MESSAGE_READ;
+    dxl_message.id = t_dxl_id;
+    dxl_message.address = t_address;
+    dxl_message.length = t_length;
+    if (!m_set_request(dxl_message)) {
+        return false;
+    }
+    memcpy(t_data, dxl_message.data, t_length);
+    return true;
+}
+/**
+ * write a register through the daemon
+ * @param t_dxl_id the dynamixel identifier
+ * @param t_address the address to be written to
+ * @param t_length the length of the register -> 1, 2 or 4
+ * @param t_value the value to be written
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Client::m_set_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length, uint32_t t_value) {
+    Dynamixel_Message dxl_message = {};
+    dxl_message.kind = DXL_MESSAGE_WRITE;
+    dxl_message.id = t_dxl_id;
+    dxl_message.address = t_address;
+    dxl_message.length = t_length;
+    for (int i = 0; i < t_length; i++) {
+        dxl_message.data[i] = (uint8_t)(t_value >> (8 * i));
+    }
+    return m_set_request(dxl_message);
+}
+/**
+ * read from a dynamixel small register
+ * @param t_dxl_id the dynamixel identifier
+ * @param t_address the address to be read from
+ * @return the value which was read
+ */
+uint8_t Dynamixel_Client::m_get_small_register(uint8_t t_dxl_id, uint16_t t_address) {
+    uint8_t dxl_data[1] = {0};
+    if (!m_get_register(t_dxl_id, t_address, 1, dxl_data)) {
+        printf("failed: read address %i of id: %i\n", t_address, t_dxl_id);
+    }
+    return dxl_data[0];
+}
+/**
+ * read from a dynamixel medium register
+ * @param t_dxl_id the dynamixel identifier
+ * @param t_address the address to be read from
+ * @return the value which was read
+ */
+uint16_t Dynamixel_Client::m_get_medium_register(uint8_t t_dxl_id, uint16_t t_address) {
+    uint8_t dxl_data[2] = {0};
+    if (!m_get_register(t_dxl_id, t_address, 2, dxl_data)) {
+        printf("failed: read address %i of id: %i\n", t_address, t_dxl_id);
+    }
+    return DXL_MAKEWORD(dxl_data[0], dxl_data[1]);
+}
+/**
+ * read from a dynamixel large register
+ * @param t_dxl_id the dynamixel identifier
+ * @param t_address the address to be read from
+ * @return the value which was read
+ */
+uint32_t Dynamixel_Client::m_get_large_register(uint8_t t_dxl_id, uint16_t t_address) {
+    uint8_t dxl_data[4] = {0};
+    if (!m_get_register(t_dxl_id, t_address, 4, dxl_data)) {
+        printf("failed: read address %i of id: %i\n", t_address, t_dxl_id);
+    }
+    return DXL_MAKEDWORD(DXL_MAKEWORD(dxl_data[0], dxl_data[1]), DXL_MAKEWORD(dxl_data[2], dxl_data[3]));
+}
+/**
+ * write to a dynamixel small register
+ * @param t_dxl_id the dynamixel identifier
+ * @param t_address the address to be written to
+ * @param t_value the value to be written
+ */
+void Dynamixel_Client::m_set_small_register(uint8_t t_dxl_id, uint16_t t_address, uint8_t t_value) {
+    if (!m_set_register(t_dxl_id, t_address, 1, t_value)) {
+        printf("failed: write address %i of id: %i\n", t_address, t_dxl_id);
+    }
+}
+/**
+ * write to a dynamixel medium register
+ * @param t_dxl_id the dynamixel identifier
+ * @param t_address the address to be written to
+ * @param t_value the value to be written
+ */
+void Dynamixel_Client::m_set_medium_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_value) {
+    if (!m_set_register(t_dxl_id, t_address, 2, t_value)) {
+        printf("failed: write address %i of id: %i\n", t_address, t_dxl_id);
+    }
+}
+/**
+ * write to a dynamixel large register
+ * @param t_dxl_id the dynamixel identifier
+ * @param t_address the address to be written to
+ * @param t_value the value to be written
+ */
+void Dynamixel_Client::m_set_large_register(uint8_t t_dxl_id, uint16_t t_address, uint32_t t_value) {
+    if (!m_set_register(t_dxl_id, t_address, 4, t_value)) {
+        printf("failed: write address %i of id: %i\n", t_address, t_dxl_id);
+    }
+}
+/**
+ * write a large register of two dynamixel's, both writes are served in the same tick
+ * @param t_dxl1_id dynamixel first identifier
+ * @param t_dxl2_id dynamixel second identifier
+ * @param t_address the address to be written to
+ * @param t_dxl1_value the value of the first dynamixel
+ * @param t_dxl2_value the value of the second dynamixel
+ */
+void Dynamixel_Client::m_set_group_register(uint8_t t_dxl1_id, uint8_t t_dxl2_id, uint16_t t_address, uint32_t t_dxl1_value, uint32_t t_dxl2_value) {
+    Dynamixel_Message dxl_messages[2] = {};
+    uint8_t dxl_ids[2] = {t_dxl1_id, t_dxl2_id};
+    uint32_t dxl_values[2] = {t_dxl1_value, t_dxl2_value};
+    for (int i = 0; i < 2; i++) {
+        dxl_messages[i].sequence = ++m_sequence;
+        dxl_messages[i].kind = DXL_MESSAGE_WRITE;
+        dxl_messages[i].priority = m_priority;
+        dxl_messages[i].id = dxl_ids[i];
+        dxl_messages[i].address = t_address;
+        dxl_messages[i].length = 4;
+        for (int j = 0; j < 4; j++) {
+            dxl_messages[i].data[j] = (uint8_t)(dxl_values[i] >> (8 * j));
+        }
+    }
+    // both requests are queued before the daemon's next tick and merged into one sync write
+    if (m_socket < 0 || send(m_socket, &dxl_messages[0], sizeof(Dynamixel_Message), MSG_NOSIGNAL) != sizeof(Dynamixel_Message) || send(m_socket, &dxl_messages[1], sizeof(Dynamixel_Message), MSG_NOSIGNAL) != sizeof(Dynamixel_Message)) {
+        printf("failed: send request to daemon\n");
+        return;
+    }
+    int dxl_answered = 0;
+    Dynamixel_Message dxl_response = {};
+    pollfd dxl_poll = {m_socket, POLLIN, 0};
+    while (dxl_answered < 2 && poll(&dxl_poll, 1, DXL_CLIENT_TIMEOUT) > 0) {
+        if (recv(m_socket, &dxl_response, sizeof(dxl_response), 0) != sizeof(dxl_response)) {
+            break;
+        }
+        if (dxl_response.sequence != dxl_messages[0].sequence && dxl_response.sequence != dxl_messages[1].sequence) {
+            continue;
+        }
+        if (!dxl_response.result) {
+            printf("failed: write address %i of id: %i\n", t_address, dxl_response.id);
+        }
+        dxl_answered++;
+    }
+    if (dxl_answered < 2) {
+        printf("failed: no response from daemon\n");
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cmath>
+#include "dynamixel_clock.h"
+
+#define DXL_TICK_PERIOD 32768
+#define DXL_TICK_SYNC_SAMPLES 4
+
+/**
+ * get the monotonic time of the host
+ * @return the time in seconds
+ */
+double Dynamixel_Clock::get_monotonic_time() {
+    auto dxl_now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(dxl_now).count();
+}
+/**
+ * add a realtime tick sample of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_tick the realtime tick value -> 0-32767
+ * @param t_tx_time host time when the request was sent
+ * @param t_rx_time host time when the status was received
+ */
+void Dynamixel_Clock::set_sample(uint8_t t_dxl_id, uint16_t t_tick, double t_tx_time, double t_rx_time) {
+    Dynamixel_Clock_Fit &dxl_fit = m_fits[t_dxl_id];
+    double dxl_host = 0.5 * (t_tx_time + t_rx_time);
+    t_tick %= DXL_TICK_PERIOD;
+
+    if (dxl_fit.samples == 0) {
+        dxl_fit = Dynamixel_Clock_Fit();
+        dxl_fit.reference_host = dxl_host;
+        dxl_fit.offset = -t_tick * 1.0e-3;
+        dxl_fit.last_unwrapped = t_tick;
+    } else {
+        dxl_fit.last_unwrapped = m_get_unwrapped(dxl_fit, t_tick, dxl_host);
+    }
+    dxl_fit.last_tick = t_tick;
+    dxl_fit.last_host = dxl_host;
+    dxl_fit.samples++;
+
+    // recursive least squares on: host - reference = offset + skew * tick
+    double dxl_x = dxl_fit.last_unwrapped * 1.0e-3;
+    double dxl_y = dxl_host - dxl_fit.reference_host;
+    double dxl_px0 = dxl_fit.p00 + dxl_fit.p01 * dxl_x;
+    double dxl_px1 = dxl_fit.p01 + dxl_fit.p11 * dxl_x;
+    double dxl_gain = m_forgetting + dxl_px0 + dxl_x * dxl_px1;
+    double dxl_k0 = dxl_px0 / dxl_gain;
+    double dxl_k1 = dxl_px1 / dxl_gain;
+    double dxl_error = dxl_y - (dxl_fit.offset + dxl_fit.skew * dxl_x);
+
+    dxl_fit.offset += dxl_k0 * dxl_error;
+    dxl_fit.skew += dxl_k1 * dxl_error;
+    dxl_fit.p00 = (dxl_fit.p00 - dxl_k0 * dxl_px0) / m_forgetting;
+    dxl_fit.p01 = (dxl_fit.p01 - dxl_k0 * dxl_px1) / m_forgetting;
+    dxl_fit.p11 = (dxl_fit.p11 - dxl_k1 * dxl_px1) / m_forgetting;
+}
+/**
+ * reset the correlation of a dynamixel (e.g. after a reboot)
+ * @param t_dxl_id the identifier of the dynamixel
+ */
+void Dynamixel_Clock::set_reset(uint8_t t_dxl_id) {
+    m_fits[t_dxl_id] = Dynamixel_Clock_Fit();
+}
+/**
+ * check if the correlation of a dynamixel is usable
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return true if enough samples were fitted
+ */
+bool Dynamixel_Clock::get_synchronized(uint8_t t_dxl_id) {
+    return m_fits[t_dxl_id].samples >= DXL_TICK_SYNC_SAMPLES;
+}
+/**
+ * get the host time at which a dynamixel took a sample
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_tick the realtime tick of the sample -> 0-32767
+ * @return the host time in seconds
+ */
+double Dynamixel_Clock::get_sample_time(uint8_t t_dxl_id, uint16_t t_tick) {
+    const Dynamixel_Clock_Fit &dxl_fit = m_fits[t_dxl_id];
+    if (dxl_fit.samples == 0) {
+        return get_monotonic_time();
+    }
+    int64_t dxl_unwrapped = m_get_unwrapped(dxl_fit, t_tick % DXL_TICK_PERIOD, dxl_fit.last_host);
+    return dxl_fit.reference_host + dxl_fit.offset + dxl_fit.skew * (dxl_unwrapped * 1.0e-3);
+}
+/**
+ * get the estimated drift of a dynamixel clock
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return host seconds per dynamixel second
+ */
+double Dynamixel_Clock::get_skew(uint8_t t_dxl_id) {
+    return m_fits[t_dxl_id].skew;
+}
+
+// MARK: - Private Functions
+/**
+ * unwrap a realtime tick against the last known one
+ * @param t_fit the fit of the dynamixel
+ * @param t_tick the realtime tick value
+ * @param t_host the host time close to the tick
+ * @return the unwrapped tick in milliseconds
+ */
+int64_t Dynamixel_Clock::m_get_unwrapped(const Dynamixel_Clock_Fit &t_fit, uint16_t t_tick, double t_host) {
+    // the host clock tells how many wraps could have happened since the last sample
+    double dxl_expected = t_fit.last_unwrapped + (t_host - t_fit.last_host) * 1.0e3;
+    double dxl_wraps = std::round((dxl_expected - t_tick) / DXL_TICK_PERIOD);
+    return t_tick + (int64_t)dxl_wraps * DXL_TICK_PERIOD;
+}
@@ -0,0 +1,111 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_CLOCK_H
+#define DYNAMIXEL_DYNAMIXEL_CLOCK_H
+
+#include <cstdint>
+#include <array>
+
+/**
+ * correlates the realtime tick (1 ms, wraps at 32767) of every dynamixel
+ * with the monotonic clock of the host by a recursive least squares fit
+ */
+class Dynamixel_Clock {
+// public declaration
+public:
+    /**
+     * initialize the clock correlation
+     * @param t_forgetting the forgetting factor of the fit | default -> 0.98
+     */
+    explicit Dynamixel_Clock(double t_forgetting = 0.98):
+            m_forgetting(t_forgetting) {
+    };
+    /**
+     * get the monotonic time of the host
+     * @return the time in seconds
+     */
+    static double get_monotonic_time();
+    /**
+     * add a realtime tick sample of a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_tick the realtime tick value -> 0-32767
+     * @param t_tx_time host time when the request was sent
+     * @param t_rx_time host time when the status was received
+     */
+    void set_sample(uint8_t t_dxl_id, uint16_t t_tick, double t_tx_time, double t_rx_time);
+    /**
+     * reset the correlation of a dynamixel (e.g. after a reboot)
+     * @param t_dxl_id the identifier of the dynamixel
+     */
+    void set_reset(uint8_t t_dxl_id);
+    /**
+     * check if the correlation of a dynamixel is usable
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return true if enough samples were fitted
+     */
+    bool get_synchronized(uint8_t t_dxl_id);
+    /**
+     * get the host time at which a dynamixel took a sample
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_tick the realtime tick of the sample -> 0-32767
+     * @return the host time in seconds
+     */
+    double get_sample_time(uint8_t t_dxl_id, uint16_t t_tick);
+    /**
+     * get the estimated drift of a dynamixel clock
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return host seconds per dynamixel second
+     */
+    double get_skew(uint8_t t_dxl_id);
+
+// private declaration
+private:
+    /**
+     * the state of the fit for a single dynamixel
+     */
+    struct Dynamixel_Clock_Fit {
+        uint32_t samples = 0;
+        uint16_t last_tick = 0;
+        int64_t last_unwrapped = 0;
+        double last_host = 0.0;
+        double reference_host = 0.0;
+        double offset = 0.0;
+        double skew = 1.0;
+        double p00 = 1.0e3, p01 = 0.0, p11 = 1.0e3;
+    };
+    /**
+     * the forgetting factor of the fit
+     */
+    double m_forgetting;
+    /**
+     * the fit for every possible identifier
+     */
+    std::array<Dynamixel_Clock_Fit, 256> m_fits{};
+    /**
+     * unwrap a realtime tick against the last known one
+     * @param t_fit the fit of the dynamixel
+     * @param t_tick the realtime tick value
+     * @param t_host the host time close to the tick
+     * @return the unwrapped tick in milliseconds
+     */
+    static int64_t m_get_unwrapped(const Dynamixel_Clock_Fit &t_fit, uint16_t t_tick, double t_host);
+};
+
+#endif
@@ -0,0 +1,234 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include "dynamixel_clock.h"
+#include "dynamixel_compact.h"
+
+/**
+ * initialize the compact reader
+ * @param t_dynamixel the dynamixel bus
+ * @param t_dxl_ids the identifiers of the dynamixel's
+ */
+Dynamixel_Compact::Dynamixel_Compact(Dynamixel &t_dynamixel, const std::vector<uint8_t> &t_dxl_ids):
+        m_dynamixel(t_dynamixel) {
+    for (uint8_t dxl_id : t_dxl_ids) {
+        m_servos.push_back({dxl_id, false, false, false, 0.0, 0.0, 0, {0}});
+    }
+}
+/**
+ * poll a 4 byte register, call before set_open
+ * @param t_address the address -> present/trajectory position or velocity
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Compact::set_register(uint16_t t_address) {
+    if (t_address != ADDR_PRESENT_POSITION && t_address != ADDR_POSITION_TRAJECTORY && t_address != ADDR_PRESENT_VELOCITY && t_address != ADDR_VELOCITY_TRAJECTORY) {
+        printf("failed: address %i has no compact form\n", t_address);
+        return false;
+    }
+    if (m_addresses.size() >= DXL_COMPACT_MAX_REGISTERS) {
+        printf("failed: the indirect data area holds %i registers\n", DXL_COMPACT_MAX_REGISTERS);
+        return false;
+    }
+    m_addresses.push_back(t_address);
+    return true;
+}
+/**
+ * read the operating mode and limits, map the registers into the indirect data area
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Compact::set_open() {
+    if (m_addresses.empty()) {
+        printf("failed: no register to poll\n");
+        return false;
+    }
+    Dynamixel_Builder dxl_builder;
+    std::vector<size_t> dxl_modes, dxl_limits;
+    for (const Dynamixel_Compact_Servo &dxl_servo : m_servos) {
+        dxl_modes.push_back(dxl_builder.set_read(dxl_servo.id, ADDR_OPERATING_MODE, 1));
+        dxl_limits.push_back(dxl_builder.set_read(dxl_servo.id, ADDR_VELOCITY_LIMIT, 4));
+    }
+    Dynamixel_Plan dxl_plan = dxl_builder.get_plan(m_dynamixel);
+    dxl_plan.set_execute();
+
+    bool dxl_result = true;
+    for (size_t i = 0; i < m_servos.size(); i++) {
+        Dynamixel_Compact_Servo &dxl_servo = m_servos[i];
+        if (!dxl_plan.get_valid(dxl_modes[i]) || !dxl_plan.get_valid(dxl_limits[i])) {
+            printf("failed: read limits of id: %i\n", dxl_servo.id);
+            dxl_result = false;
+            continue;
+        }
+        uint32_t dxl_mode = dxl_plan.get_value(dxl_modes[i]);
+        uint32_t dxl_limit = dxl_plan.get_value(dxl_limits[i]);
+        // the velocity limit only clamps the motion in the velocity and position modes, else assume the register range
+        bool dxl_clamped = dxl_mode == ADDR_CONTROL_MODE_VELOCITY || dxl_mode == ADDR_CONTROL_MODE_POSITION || dxl_mode == ADDR_CONTROL_MODE_EXTENDED_POSITION;
+        double dxl_speed = dxl_clamped ? dxl_limit : 1023.0;
+        dxl_servo.allowed = dxl_speed <= DXL_COMPACT_BOUND;
+        dxl_servo.max_speed = dxl_speed * 0.229 / 60.0 * 4096.0;
+        dxl_servo.valid = false;
+    }
+
+    // low bytes of every register first, so the compact read is a prefix of the full read
+    dxl_builder.set_clear();
+    uint16_t dxl_count = (uint16_t)m_addresses.size();
+    for (const Dynamixel_Compact_Servo &dxl_servo : m_servos) {
+        for (uint16_t j = 0; j < 4 * dxl_count; j++) {
+            uint16_t dxl_register = j < 2 * dxl_count ? j / 2 : (j - 2 * dxl_count) / 2;
+            uint16_t dxl_byte = (j < 2 * dxl_count ? 0 : 2) + j % 2;
+            dxl_builder.set_write(dxl_servo.id, ADDR_INDIRECT_ADDRESS_1 + 2 * j, 2, m_addresses[dxl_register] + dxl_byte);
+        }
+    }
+    Dynamixel_Plan dxl_mapping = dxl_builder.get_plan(m_dynamixel);
+    dxl_result = dxl_mapping.set_execute() && dxl_result;
+    m_dirty = true;
+    return dxl_result;
+}
+/**
+ * read all registers of all dynamixel's in one sync/bulk read
+ * @return true if every dynamixel answered otherwise false
+ */
+bool Dynamixel_Compact::set_update() {
+    double dxl_now = Dynamixel_Clock::get_monotonic_time();
+    for (Dynamixel_Compact_Servo &dxl_servo : m_servos) {
+        bool dxl_compact = m_get_width(dxl_servo, dxl_now);
+        if (dxl_compact != dxl_servo.compact) {
+            dxl_servo.compact = dxl_compact;
+            m_dirty = true;
+        }
+    }
+    size_t dxl_count = m_addresses.size();
+    if (m_dirty) {
+        Dynamixel_Builder dxl_builder;
+        for (Dynamixel_Compact_Servo &dxl_servo : m_servos) {
+            dxl_servo.handle = dxl_builder.set_read(dxl_servo.id, ADDR_INDIRECT_DATA_1, (uint16_t)((dxl_servo.compact ? 2 : 4) * dxl_count));
+        }
+        m_plan = dxl_builder.get_plan(m_dynamixel);
+        m_dirty = false;
+    }
+    m_plan.set_execute();
+
+    bool dxl_result = true;
+    m_length = 0;
+    for (Dynamixel_Compact_Servo &dxl_servo : m_servos) {
+        m_length += (dxl_servo.compact ? 2 : 4) * dxl_count;
+        if (!m_plan.get_valid(dxl_servo.handle)) {
+            dxl_result = false;
+            continue;
+        }
+        const uint8_t *dxl_data = m_plan.get_data(dxl_servo.handle);
+        for (size_t i = 0; i < dxl_count; i++) {
+            uint16_t dxl_low = (uint16_t)DXL_MAKEWORD(dxl_data[2 * i], dxl_data[2 * i + 1]);
+            if (!dxl_servo.compact) {
+                uint16_t dxl_high = (uint16_t)DXL_MAKEWORD(dxl_data[2 * (dxl_count + i)], dxl_data[2 * (dxl_count + i) + 1]);
+                dxl_servo.values[i] = (int32_t)DXL_MAKEDWORD(dxl_low, dxl_high);
+            } else if (!m_get_position(m_addresses[i])) {
+                dxl_servo.values[i] = (int16_t)dxl_low;
+            } else {
+                // the position moved less than half the 16 bit range since the last read, in every mode,
+                // a dynamixel backdriven without torque reports multi turn and negative positions
+                dxl_servo.values[i] += (int16_t)(dxl_low - (uint16_t)dxl_servo.values[i]);
+            }
+        }
+        dxl_servo.valid = true;
+        dxl_servo.last_time = dxl_now;
+    }
+    return dxl_result;
+}
+/**
+ * get the reconstructed value of a register
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_address the address of the register
+ * @return the value
+ */
+int32_t Dynamixel_Compact::get_value(uint8_t t_dxl_id, uint16_t t_address) {
+    Dynamixel_Compact_Servo *dxl_servo = m_get_servo(t_dxl_id);
+    if (dxl_servo == nullptr) {
+        return 0;
+    }
+    for (size_t i = 0; i < m_addresses.size(); i++) {
+        if (m_addresses[i] == t_address) {
+            return dxl_servo->values[i];
+        }
+    }
+    return 0;
+}
+/**
+ * check if a dynamixel was read with the reduced width in the last update
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return true if compact otherwise false
+ */
+bool Dynamixel_Compact::get_compact(uint8_t t_dxl_id) {
+    Dynamixel_Compact_Servo *dxl_servo = m_get_servo(t_dxl_id);
+    return dxl_servo != nullptr && dxl_servo->compact;
+}
+/**
+ * get the status payload of the last update
+ * @return the amount of register bytes
+ */
+size_t Dynamixel_Compact::get_length() {
+    return m_length;
+}
+
+// MARK: - Private Functions
+
+/**
+ * check if a register is a position (reconstructed by continuity) or a velocity (sign extended)
+ * @param t_address the address of the register
+ * @return true for a position otherwise false
+ */
+bool Dynamixel_Compact::m_get_position(uint16_t t_address) {
+    return t_address == ADDR_PRESENT_POSITION || t_address == ADDR_POSITION_TRAJECTORY;
+}
+/**
+ * find a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the dynamixel or nullptr if unknown
+ */
+Dynamixel_Compact::Dynamixel_Compact_Servo *Dynamixel_Compact::m_get_servo(uint8_t t_dxl_id) {
+    for (Dynamixel_Compact_Servo &dxl_servo : m_servos) {
+        if (dxl_servo.id == t_dxl_id) {
+            return &dxl_servo;
+        }
+    }
+    return nullptr;
+}
+/**
+ * check if the next read of a dynamixel can be compact
+ * @param t_servo the dynamixel
+ * @param t_now the host time of the read
+ * @return true if compact otherwise false
+ */
+bool Dynamixel_Compact::m_get_width(const Dynamixel_Compact_Servo &t_servo, double t_now) {
+    // without a full value there is nothing to continue from
+    if (!t_servo.allowed || !t_servo.valid) {
+        return false;
+    }
+    for (size_t i = 0; i < m_addresses.size(); i++) {
+        if (!m_get_position(m_addresses[i])) {
+            if (abs(t_servo.values[i]) > DXL_COMPACT_BOUND) {
+                return false;
+            }
+        } else if ((t_now - t_servo.last_time) * t_servo.max_speed >= 32768.0 * DXL_COMPACT_MARGIN) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,142 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_COMPACT_H
+#define DYNAMIXEL_DYNAMIXEL_COMPACT_H
+
+#include <cstdint>
+#include <vector>
+#include "dynamixel.h"
+#include "dynamixel_transaction.h"
+
+#define DXL_COMPACT_MAX_REGISTERS 5
+#define DXL_COMPACT_MARGIN 0.5
+#define DXL_COMPACT_BOUND 30000
+
+/**
+ * polls 4 byte registers through the indirect data area and reads only their low
+ * 2 bytes while the operating mode and limits allow it, the full value is
+ * reconstructed on the host (positions by continuity, velocities by sign extension)
+ * indirect layout: low bytes of every register first, then the high bytes
+ */
+class Dynamixel_Compact {
+// public declaration
+public:
+    /**
+     * initialize the compact reader
+     * @param t_dynamixel the dynamixel bus
+     * @param t_dxl_ids the identifiers of the dynamixel's
+     */
+    Dynamixel_Compact(Dynamixel &t_dynamixel, const std::vector<uint8_t> &t_dxl_ids);
+    /**
+     * poll a 4 byte register, call before set_open
+     * @param t_address the address -> present/trajectory position or velocity
+     * @return true if success otherwise false
+     */
+    bool set_register(uint16_t t_address);
+    /**
+     * read the operating mode and limits, map the registers into the indirect data area
+     * @return true if success otherwise false
+     */
+    bool set_open();
+    /**
+     * read all registers of all dynamixel's in one sync/bulk read
+     * @return true if every dynamixel answered otherwise false
+     */
+    bool set_update();
+    /**
+     * get the reconstructed value of a register
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the address of the register
+     * @return the value
+     */
+    int32_t get_value(uint8_t t_dxl_id, uint16_t t_address);
+    /**
+     * check if a dynamixel was read with the reduced width in the last update
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return true if compact otherwise false
+     */
+    bool get_compact(uint8_t t_dxl_id);
+    /**
+     * get the status payload of the last update
+     * @return the amount of register bytes
+     */
+    size_t get_length();
+
+// private declaration
+private:
+    /**
+     * the polled state of a dynamixel
+     */
+    struct Dynamixel_Compact_Servo {
+        uint8_t id;
+        bool allowed;
+        bool compact;
+        bool valid;
+        double max_speed;
+        double last_time;
+        size_t handle;
+        int32_t values[DXL_COMPACT_MAX_REGISTERS];
+    };
+    /**
+     * the dynamixel bus
+     */
+    Dynamixel &m_dynamixel;
+    /**
+     * the polled dynamixel's
+     */
+    std::vector<Dynamixel_Compact_Servo> m_servos;
+    /**
+     * the addresses of the polled registers
+     */
+    std::vector<uint16_t> m_addresses;
+    /**
+     * the read plan for the current widths
+     */
+    Dynamixel_Plan m_plan;
+    /**
+     * true if the widths changed and the plan has to be compiled again
+     */
+    bool m_dirty = true;
+    /**
+     * the status payload of the last update
+     */
+    size_t m_length = 0;
+    /**
+     * check if a register is a position (reconstructed by continuity) or a velocity (sign extended)
+     * @param t_address the address of the register
+     * @return true for a position otherwise false
+     */
+    static bool m_get_position(uint16_t t_address);
+    /**
+     * find a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return the dynamixel or nullptr if unknown
+     */
+    Dynamixel_Compact_Servo *m_get_servo(uint8_t t_dxl_id);
+    /**
+     * check if the next read of a dynamixel can be compact
+     * @param t_servo the dynamixel
+     * @param t_now the host time of the read
+     * @return true if compact otherwise false
+     */
+    bool m_get_width(const Dynamixel_Compact_Servo &t_servo, double t_now);
+};
+
+#endif
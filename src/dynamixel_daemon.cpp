@@ -0,0 +1,275 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "dynamixel_daemon.h"
+
+/**
+ * close the socket and all clients
+ */
+Dynamixel_Daemon::~Dynamixel_Daemon() {
+    set_close();
+}
+/**
+ * create the unix socket
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Daemon::set_open() {
+    if (m_socket >= 0) {
+        return true;
+    }
+    sockaddr_un dxl_address = {};
+    dxl_address.sun_family = AF_UNIX;
+    if (strlen(m_socket_path) >= sizeof(dxl_address.sun_path)) {
+        printf("failed: socket path too long\n");
+        return false;
+    }
+    strcpy(dxl_address.sun_path, m_socket_path);
+    m_socket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0);
+    if (m_socket < 0) {
+        printf("failed: create socket\n");
+        return false;
+    }
+    // a daemon which crashed leaves its socket file behind
+    unlink(m_socket_path);
+    if (bind(m_socket, (sockaddr*)&dxl_address, sizeof(dxl_address)) != 0 || listen(m_socket, DXL_DAEMON_MAX_CLIENTS) != 0) {
+        printf("failed: bind socket %s\n", m_socket_path);
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+    return true;
+}
+/**
+ * close the socket and all clients, remove the socket file
+ */
+void Dynamixel_Daemon::set_close() {
+    if (m_socket < 0) {
+        return;
+    }
+    for (int dxl_client : m_clients) {
+        close(dxl_client);
+    }
+    m_clients.clear();
+    m_requests.clear();
+    close(m_socket);
+    unlink(m_socket_path);
+    m_socket = -1;
+}
+/**
+ * set the bus model used to fit the requests into a tick
+ * @param t_model the (calibrated) bus model
+ */
+void Dynamixel_Daemon::set_model(const Dynamixel_Bus_Model &t_model) {
+    m_model = t_model;
+}
+/**
+ * accept clients, collect their requests and serve as many as fit into one tick, by priority
+ * @return the amount of served requests
+ */
+uint32_t Dynamixel_Daemon::set_tick() {
+    if (m_socket < 0) {
+        return 0;
+    }
+    m_set_accept();
+    m_set_receive();
+    if (m_requests.empty()) {
+        return 0;
+    }
+
+    // control traffic is always served, lower classes only while the tick has room
+    uint8_t dxl_priority = DXL_PRIORITY_CONTROL;
+    Dynamixel_Plan dxl_plan = m_get_plan(dxl_priority);
+    for (uint8_t i = DXL_PRIORITY_CONTROL + 1; i < DXL_PRIORITY_COUNT; i++) {
+        Dynamixel_Plan dxl_candidate = m_get_plan(i);
+        if (m_model.get_cycle_time(dxl_candidate.get_transactions()) > m_period) {
+            break;
+        }
+        dxl_plan = std::move(dxl_candidate);
+        dxl_priority = i;
+    }
+    // the handles of the served requests belong to the last compiled plan
+    if (dxl_priority != DXL_PRIORITY_COUNT - 1) {
+        dxl_plan = m_get_plan(dxl_priority);
+    }
+    dxl_plan.set_execute();
+
+    uint32_t dxl_served = 0;
+    std::vector<Dynamixel_Daemon_Request> dxl_pending;
+    for (Dynamixel_Daemon_Request &dxl_request : m_requests) {
+        if (dxl_request.message.priority > dxl_priority) {
+            dxl_pending.push_back(dxl_request);
+            continue;
+        }
+        Dynamixel_Message &dxl_message = dxl_request.message;
+        if (dxl_message.kind == DXL_MESSAGE_READ) {
+            dxl_message.result = dxl_plan.get_valid(dxl_request.handle);
+            if (dxl_message.result) {
+                memcpy(dxl_message.data, dxl_plan.get_data(dxl_request.handle), dxl_message.length);
+            }
+        } else {
+            // sync/bulk writes have no status, the result is whether the write packets went out
+            dxl_message.result = dxl_plan.get_written();
+        }
+        m_set_reply(dxl_request.client, dxl_message);
+        dxl_served++;
+    }
+    m_requests.swap(dxl_pending);
+    return dxl_served;
+}
+/**
+ * get the tick period
+ * @return the period in seconds
+ */
+double Dynamixel_Daemon::get_period() {
+    return m_period;
+}
+/**
+ * get the amount of connected clients
+ * @return the amount of clients
+ */
+size_t Dynamixel_Daemon::get_clients() {
+    return m_clients.size();
+}
+/**
+ * get the amount of requests which wait for a later tick
+ * @return the amount of requests
+ */
+size_t Dynamixel_Daemon::get_pending() {
+    return m_requests.size();
+}
+
+// MARK: - Private Functions
+
+/**
+ * accept all waiting clients
+ */
+void Dynamixel_Daemon::m_set_accept() {
+    while (true) {
+        int dxl_client = accept4(m_socket, nullptr, nullptr, SOCK_NONBLOCK);
+        if (dxl_client < 0) {
+            return;
+        }
+        if (m_clients.size() >= DXL_DAEMON_MAX_CLIENTS) {
+            printf("failed: too many clients\n");
+            close(dxl_client);
+            continue;
+        }
+        m_clients.push_back(dxl_client);
+    }
+}
+/**
+ * receive all waiting requests, answer invalid ones and the ones above DXL_DAEMON_MAX_REQUESTS per client right away
+ */
+void Dynamixel_Daemon::m_set_receive() {
+    std::vector<int> dxl_closed;
+    for (int dxl_client : m_clients) {
+        Dynamixel_Message dxl_message = {};
+        // requests which wait for a later tick still count, a flooding client must not grow the queue forever
+        size_t dxl_queued = (size_t)std::count_if(m_requests.begin(), m_requests.end(), [&](const Dynamixel_Daemon_Request &t_request) {
+            return t_request.client == dxl_client;
+        });
+        while (true) {
+            ssize_t dxl_length = recv(dxl_client, &dxl_message, sizeof(dxl_message), 0);
+            if (dxl_length < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    dxl_closed.push_back(dxl_client);
+                }
+                break;
+            }
+            if (dxl_length == 0) {
+                dxl_closed.push_back(dxl_client);
+                break;
+            }
+            bool dxl_valid = dxl_length == sizeof(dxl_message) && dxl_message.priority < DXL_PRIORITY_COUNT && dxl_message.id < BROADCAST_ID;
+            if (dxl_valid && dxl_message.kind == DXL_MESSAGE_READ) {
+                dxl_valid = dxl_message.length >= 1 && dxl_message.length <= DXL_MESSAGE_MAX_LEN;
+            } else if (dxl_valid && dxl_message.kind == DXL_MESSAGE_WRITE) {
+                dxl_valid = dxl_message.length == 1 || dxl_message.length == 2 || dxl_message.length == 4;
+            } else {
+                dxl_valid = false;
+            }
+            if (!dxl_valid || dxl_queued >= DXL_DAEMON_MAX_REQUESTS) {
+                dxl_message.result = 0;
+                m_set_reply(dxl_client, dxl_message);
+                continue;
+            }
+            m_requests.push_back({dxl_client, dxl_message, 0});
+            dxl_queued++;
+        }
+    }
+    for (int dxl_client : dxl_closed) {
+        m_set_disconnect(dxl_client);
+    }
+}
+/**
+ * compile the requests up to a priority class into one plan
+ * @param t_priority the lowest priority class to include
+ * @return the plan
+ */
+Dynamixel_Plan Dynamixel_Daemon::m_get_plan(uint8_t t_priority) {
+    m_builder.set_clear();
+    // writes to the same register are applied in order, so the highest class is added last and wins
+    for (int i = t_priority; i >= DXL_PRIORITY_CONTROL; i--) {
+        for (Dynamixel_Daemon_Request &dxl_request : m_requests) {
+            const Dynamixel_Message &dxl_message = dxl_request.message;
+            if (dxl_message.priority != i) {
+                continue;
+            }
+            if (dxl_message.kind == DXL_MESSAGE_READ) {
+                dxl_request.handle = m_builder.set_read(dxl_message.id, dxl_message.address, dxl_message.length);
+                continue;
+            }
+            uint32_t dxl_value = 0;
+            for (int j = dxl_message.length - 1; j >= 0; j--) {
+                dxl_value = (dxl_value << 8) | dxl_message.data[j];
+            }
+            dxl_request.handle = m_builder.set_write(dxl_message.id, dxl_message.address, dxl_message.length, dxl_value);
+        }
+    }
+    return m_builder.get_plan(m_dynamixel, m_model);
+}
+/**
+ * send a response to a client
+ * @param t_client the socket of the client
+ * @param t_message the response
+ */
+void Dynamixel_Daemon::m_set_reply(int t_client, const Dynamixel_Message &t_message) {
+    if (send(t_client, &t_message, sizeof(t_message), MSG_NOSIGNAL) != sizeof(t_message)) {
+        printf("failed: reply to client %i\n", t_client);
+    }
+}
+/**
+ * close a client and drop its requests
+ * @param t_client the socket of the client
+ */
+void Dynamixel_Daemon::m_set_disconnect(int t_client) {
+    close(t_client);
+    m_clients.erase(std::remove(m_clients.begin(), m_clients.end(), t_client), m_clients.end());
+    m_requests.erase(std::remove_if(m_requests.begin(), m_requests.end(), [&](const Dynamixel_Daemon_Request &t_request) {
+        return t_request.client == t_client;
+    }), m_requests.end());
+}
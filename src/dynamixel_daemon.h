@@ -0,0 +1,159 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_DAEMON_H
+#define DYNAMIXEL_DYNAMIXEL_DAEMON_H
+
+#include <cstdint>
+#include <vector>
+#include "dynamixel.h"
+#include "dynamixel_bus_model.h"
+#include "dynamixel_message.h"
+#include "dynamixel_transaction.h"
+
+#define DXL_DAEMON_MAX_CLIENTS 32
+#define DXL_DAEMON_MAX_REQUESTS 64
+
+/**
+ * owns the port and serves register reads/writes of many local processes,
+ * all requests of a tick are merged into shared sync/bulk packets
+ */
+class Dynamixel_Daemon {
+// public declaration
+public:
+    /**
+     * initialize the daemon
+     * @param t_dynamixel the dynamixel bus, must be open
+     * @param t_socket_path the path of the unix socket | default -> DXL_DAEMON_SOCKET
+     * @param t_rate the tick rate in hz | default -> 100
+     */
+    explicit Dynamixel_Daemon(Dynamixel &t_dynamixel, const char* t_socket_path = DXL_DAEMON_SOCKET, double t_rate = 100.0):
+            m_dynamixel(t_dynamixel),
+            m_socket_path(t_socket_path),
+            m_period(1.0 / t_rate) {
+    };
+    /**
+     * close the socket and all clients
+     */
+    ~Dynamixel_Daemon();
+    /**
+     * create the unix socket
+     * @return true if success otherwise false
+     */
+    bool set_open();
+    /**
+     * close the socket and all clients, remove the socket file
+     */
+    void set_close();
+    /**
+     * set the bus model used to fit the requests into a tick
+     * @param t_model the (calibrated) bus model
+     */
+    void set_model(const Dynamixel_Bus_Model &t_model);
+    /**
+     * accept clients, collect their requests and serve as many as fit into one tick, by priority
+     * @return the amount of served requests
+     */
+    uint32_t set_tick();
+    /**
+     * get the tick period
+     * @return the period in seconds
+     */
+    double get_period();
+    /**
+     * get the amount of connected clients
+     * @return the amount of clients
+     */
+    size_t get_clients();
+    /**
+     * get the amount of requests which wait for a later tick
+     * @return the amount of requests
+     */
+    size_t get_pending();
+
+// private declaration
+private:
+    /**
+     * a request of a client
+     */
+    struct Dynamixel_Daemon_Request {
+        int client;
+        Dynamixel_Message message;
+        size_t handle;
+    };
+    /**
+     * the dynamixel bus
+     */
+    Dynamixel &m_dynamixel;
+    /**
+     * the path of the unix socket
+     */
+    const char* m_socket_path;
+    /**
+     * the tick period in seconds
+     */
+    double m_period;
+    /**
+     * the listening socket
+     */
+    int m_socket = -1;
+    /**
+     * the connected clients
+     */
+    std::vector<int> m_clients;
+    /**
+     * the requests which weren't served yet, in arrival order
+     */
+    std::vector<Dynamixel_Daemon_Request> m_requests;
+    /**
+     * the bus model used to fit the requests into a tick
+     */
+    Dynamixel_Bus_Model m_model = Dynamixel_Bus_Model(m_dynamixel.get_baud_rate());
+    /**
+     * the builder of the tick plan
+     */
+    Dynamixel_Builder m_builder;
+    /**
+     * accept all waiting clients
+     */
+    void m_set_accept();
+    /**
+     * receive all waiting requests, answer invalid ones and the ones above DXL_DAEMON_MAX_REQUESTS per client right away
+     */
+    void m_set_receive();
+    /**
+     * compile the requests up to a priority class into one plan
+     * @param t_priority the lowest priority class to include
+     * @return the plan
+     */
+    Dynamixel_Plan m_get_plan(uint8_t t_priority);
+    /**
+     * send a response to a client
+     * @param t_client the socket of the client
+     * @param t_message the response
+     */
+    void m_set_reply(int t_client, const Dynamixel_Message &t_message);
+    /**
+     * close a client and drop its requests
+     * @param t_client the socket of the client
+     */
+    void m_set_disconnect(int t_client);
+};
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_MESSAGE_H
+#define DYNAMIXEL_DYNAMIXEL_MESSAGE_H
+
+#include <cstdint>
+
+#define DXL_DAEMON_SOCKET "/tmp/dynamixel.sock"
+#define DXL_MESSAGE_MAX_LEN 16
+
+/**
+ * the priority classes of the daemon, control traffic is always served first
+ */
+enum Dynamixel_Priority {
+    DXL_PRIORITY_CONTROL = 0,
+    DXL_PRIORITY_NORMAL = 1,
+    DXL_PRIORITY_BACKGROUND = 2,
+    DXL_PRIORITY_COUNT = 3,
+};
+
+/**
+ * the kind of a daemon request
+ */
+enum Dynamixel_Message_Kind {
+    DXL_MESSAGE_READ = 0,
+    DXL_MESSAGE_WRITE = 1,
+};
+
+/**
+ * a request to the daemon and its response, one datagram on the unix socket
+ */
+struct Dynamixel_Message {
+    /**
+     * chosen by the client, echoed in the response
+     */
+    uint32_t sequence;
+    /**
+     * the kind of the request -> DXL_MESSAGE_READ, DXL_MESSAGE_WRITE
+     */
+    uint8_t kind;
+    /**
+     * the priority class of the request
+     */
+    uint8_t priority;
+    /**
+     * the identifier of the dynamixel
+     */
+    uint8_t id;
+    /**
+     * 1 if the request was served otherwise 0, only set in the response
+     */
+    uint8_t result;
+    /**
+     * the address of the register
+     */
+    uint16_t address;
+    /**
+     * the length of the register -> 1-16 for reads, 1, 2 or 4 for writes
+     */
+    uint16_t length;
+    /**
+     * the little endian register bytes, written by the client or read by the daemon
+     */
+    uint8_t data[DXL_MESSAGE_MAX_LEN];
+};
+
+#endif
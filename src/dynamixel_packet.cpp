@@ -0,0 +1,207 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <cstring>
+#include "dynamixel_clock.h"
+#include "dynamixel_packet.h"
+
+/**
+ * crc-16 (ibm) lookup table with the polynomial 0x8005
+ */
+static constexpr std::array<uint16_t, 256> DXL_CRC_TABLE = [] {
+    std::array<uint16_t, 256> dxl_table{};
+    for (uint16_t i = 0; i < 256; i++) {
+        uint16_t dxl_crc = i << 8;
+        for (int j = 0; j < 8; j++) {
+            dxl_crc = (dxl_crc & 0x8000) ? (dxl_crc << 1) ^ 0x8005 : dxl_crc << 1;
+        }
+        dxl_table[i] = dxl_crc;
+    }
+    return dxl_table;
+}();
+
+/**
+ * update a protocol 2.0 crc
+ * @param t_crc the crc so far | 0 for a new packet
+ * @param t_data the data to add
+ * @param t_length the length of the data
+ * @return the updated crc
+ */
+uint16_t Dynamixel_Packet::get_crc(uint16_t t_crc, const uint8_t *t_data, size_t t_length) {
+    for (size_t i = 0; i < t_length; i++) {
+        t_crc = (t_crc << 8) ^ DXL_CRC_TABLE[((t_crc >> 8) ^ t_data[i]) & 0xFF];
+    }
+    return t_crc;
+}
+/**
+ * count the stuffing bytes needed for the instruction and its parameters
+ * @param t_instruction the instruction
+ * @param t_param the parameters
+ * @param t_param_length the length of the parameters
+ * @return the amount of stuffing bytes
+ */
+size_t Dynamixel_Packet::get_stuffing(uint8_t t_instruction, const uint8_t *t_param, size_t t_param_length) {
+    // 0xFF 0xFF 0xFD inside the packet gets an extra 0xFD, the length field is part of the window
+    size_t dxl_stuffing = 0;
+    uint8_t dxl_previous[2] = {0x00, t_instruction};
+    for (size_t i = 0; i < t_param_length; i++) {
+        if (dxl_previous[0] == 0xFF && dxl_previous[1] == 0xFF && t_param[i] == 0xFD) {
+            dxl_stuffing++;
+            dxl_previous[0] = 0x00;
+            dxl_previous[1] = 0x00;
+            continue;
+        }
+        dxl_previous[0] = dxl_previous[1];
+        dxl_previous[1] = t_param[i];
+    }
+    return dxl_stuffing;
+}
+/**
+ * encode an instruction packet
+ * @param t_buffer the buffer to write the packet to
+ * @param t_capacity the capacity of the buffer
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_instruction the instruction
+ * @param t_param the parameters
+ * @param t_param_length the length of the parameters
+ * @return the length of the packet | 0 if the buffer is too small
+ */
+size_t Dynamixel_Packet::set_instruction(uint8_t *t_buffer, size_t t_capacity, uint8_t t_dxl_id, uint8_t t_instruction, const uint8_t *t_param, size_t t_param_length) {
+    size_t dxl_stuffing = get_stuffing(t_instruction, t_param, t_param_length);
+    size_t dxl_length = DXL_INSTRUCTION_FRAME_LEN + t_param_length + dxl_stuffing;
+    if (dxl_length > t_capacity || dxl_length - 7 > 0xFFFF) {
+        return 0;
+    }
+    t_buffer[0] = 0xFF;
+    t_buffer[1] = 0xFF;
+    t_buffer[2] = 0xFD;
+    t_buffer[3] = 0x00;
+    t_buffer[4] = t_dxl_id;
+    t_buffer[5] = (uint8_t)((dxl_length - 7) & 0xFF);
+    t_buffer[6] = (uint8_t)((dxl_length - 7) >> 8);
+    t_buffer[7] = t_instruction;
+
+    size_t dxl_index = 8;
+    uint8_t dxl_previous[2] = {0x00, t_instruction};
+    for (size_t i = 0; i < t_param_length; i++) {
+        t_buffer[dxl_index++] = t_param[i];
+        if (dxl_previous[0] == 0xFF && dxl_previous[1] == 0xFF && t_param[i] == 0xFD) {
+            t_buffer[dxl_index++] = 0xFD;
+            dxl_previous[0] = 0x00;
+            dxl_previous[1] = 0x00;
+            continue;
+        }
+        dxl_previous[0] = dxl_previous[1];
+        dxl_previous[1] = t_param[i];
+    }
+    uint16_t dxl_crc = get_crc(0, t_buffer, dxl_index);
+    t_buffer[dxl_index++] = (uint8_t)(dxl_crc & 0xFF);
+    t_buffer[dxl_index++] = (uint8_t)(dxl_crc >> 8);
+    return dxl_index;
+}
+/**
+ * write encoded packets to the port with a single write
+ * @param t_port_handler the port handler
+ * @param t_packet the encoded packets
+ * @param t_length the length of the packets
+ * @return the communication result -> COMM_SUCCESS, COMM_PORT_BUSY or COMM_TX_FAIL
+ */
+int Dynamixel_Packet::set_transmit(dynamixel::PortHandler *t_port_handler, uint8_t *t_packet, size_t t_length) {
+    if (t_port_handler->is_using_) {
+        return COMM_PORT_BUSY;
+    }
+    t_port_handler->is_using_ = true;
+    t_port_handler->clearPort();
+    int dxl_written = t_port_handler->writePort(t_packet, (int)t_length);
+    t_port_handler->is_using_ = false;
+    return dxl_written == (int)t_length ? COMM_SUCCESS : COMM_TX_FAIL;
+}
+
+// MARK: - Receiver
+/**
+ * receive the next valid status packet
+ * @param t_port_handler the port handler
+ * @param t_deadline the host time to give up at
+ * @param t_status the decoded status
+ * @return the communication result -> COMM_SUCCESS or COMM_RX_TIMEOUT
+ */
+int Dynamixel_Receiver::get_status(dynamixel::PortHandler *t_port_handler, double t_deadline, Dynamixel_Status &t_status) {
+    while (true) {
+        if (m_filled < m_buffer.size()) {
+            int dxl_read = t_port_handler->readPort(m_buffer.data() + m_filled, (int)(m_buffer.size() - m_filled));
+            m_filled += dxl_read > 0 ? dxl_read : 0;
+        }
+        // align the buffer to the next header, keep a partial header at the end
+        size_t dxl_header = 0;
+        while (dxl_header + 4 <= m_filled && !(m_buffer[dxl_header] == 0xFF && m_buffer[dxl_header + 1] == 0xFF && m_buffer[dxl_header + 2] == 0xFD && m_buffer[dxl_header + 3] == 0x00)) {
+            dxl_header++;
+        }
+        m_set_consumed(dxl_header);
+
+        if (m_filled >= 7) {
+            size_t dxl_length = 7 + DXL_MAKEWORD(m_buffer[5], m_buffer[6]);
+            if (dxl_length < DXL_STATUS_FRAME_LEN || dxl_length > m_buffer.size()) {
+                m_set_consumed(1);
+                continue;
+            }
+            if (m_filled >= dxl_length) {
+                uint16_t dxl_crc = Dynamixel_Packet::get_crc(0, m_buffer.data(), dxl_length - 2);
+                if (m_buffer[7] != DXL_STATUS_INSTRUCTION || dxl_crc != DXL_MAKEWORD(m_buffer[dxl_length - 2], m_buffer[dxl_length - 1])) {
+                    m_set_consumed(1);
+                    continue;
+                }
+                // remove the byte stuffing: 0xFF 0xFF 0xFD 0xFD -> 0xFF 0xFF 0xFD
+                uint16_t dxl_param_length = 0;
+                for (size_t i = 9; i < dxl_length - 2; i++) {
+                    if (i >= 3 && m_buffer[i] == 0xFD && m_buffer[i - 1] == 0xFD && m_buffer[i - 2] == 0xFF && m_buffer[i - 3] == 0xFF) {
+                        continue;
+                    }
+                    m_param[dxl_param_length++] = m_buffer[i];
+                }
+                t_status.id = m_buffer[4];
+                t_status.error = m_buffer[8];
+                t_status.param = m_param.data();
+                t_status.length = dxl_param_length;
+                m_set_consumed(dxl_length);
+                return COMM_SUCCESS;
+            }
+        }
+        if (Dynamixel_Clock::get_monotonic_time() >= t_deadline) {
+            return COMM_RX_TIMEOUT;
+        }
+    }
+}
+/**
+ * drop all buffered bytes
+ */
+void Dynamixel_Receiver::set_clear() {
+    m_filled = 0;
+}
+/**
+ * drop bytes from the front of the buffer
+ * @param t_length the amount of bytes
+ */
+void Dynamixel_Receiver::m_set_consumed(size_t t_length) {
+    if (t_length == 0) {
+        return;
+    }
+    std::memmove(m_buffer.data(), m_buffer.data() + t_length, m_filled - t_length);
+    m_filled -= t_length;
+}
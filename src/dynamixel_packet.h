@@ -0,0 +1,150 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_PACKET_H
+#define DYNAMIXEL_DYNAMIXEL_PACKET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <dynamixel_sdk.h>
+
+/**
+ * protocol 2.0 frame sizes
+ * header (4) + id (1) + length (2) + instruction (1) + crc (2) = 10
+ * a status packet carries an additional error byte = 11
+ */
+#define DXL_INSTRUCTION_FRAME_LEN 10
+#define DXL_STATUS_FRAME_LEN 11
+#define DXL_STATUS_INSTRUCTION 0x55
+
+/**
+ * encodes protocol 2.0 packets into caller provided buffers
+ */
+class Dynamixel_Packet {
+// public declaration
+public:
+    /**
+     * update a protocol 2.0 crc
+     * @param t_crc the crc so far | 0 for a new packet
+     * @param t_data the data to add
+     * @param t_length the length of the data
+     * @return the updated crc
+     */
+    static uint16_t get_crc(uint16_t t_crc, const uint8_t *t_data, size_t t_length);
+    /**
+     * count the stuffing bytes needed for the instruction and its parameters
+     * @param t_instruction the instruction
+     * @param t_param the parameters
+     * @param t_param_length the length of the parameters
+     * @return the amount of stuffing bytes
+     */
+    static size_t get_stuffing(uint8_t t_instruction, const uint8_t *t_param, size_t t_param_length);
+    /**
+     * encode an instruction packet
+     * @param t_buffer the buffer to write the packet to
+     * @param t_capacity the capacity of the buffer
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_instruction the instruction
+     * @param t_param the parameters
+     * @param t_param_length the length of the parameters
+     * @return the length of the packet | 0 if the buffer is too small
+     */
+    static size_t set_instruction(uint8_t *t_buffer, size_t t_capacity, uint8_t t_dxl_id, uint8_t t_instruction, const uint8_t *t_param, size_t t_param_length);
+    /**
+     * write encoded packets to the port with a single write
+     * @param t_port_handler the port handler
+     * @param t_packet the encoded packets
+     * @param t_length the length of the packets
+     * @return the communication result -> COMM_SUCCESS, COMM_PORT_BUSY or COMM_TX_FAIL
+     */
+    static int set_transmit(dynamixel::PortHandler *t_port_handler, uint8_t *t_packet, size_t t_length);
+};
+
+/**
+ * a decoded status packet, the parameters are valid until the next receive
+ */
+struct Dynamixel_Status {
+    /**
+     * the identifier of the dynamixel
+     */
+    uint8_t id;
+    /**
+     * the error field of the status
+     */
+    uint8_t error;
+    /**
+     * the unstuffed parameters
+     */
+    const uint8_t *param;
+    /**
+     * the length of the parameters
+     */
+    uint16_t length;
+};
+
+/**
+ * receives status packets from the port into a buffer sized once at setup
+ */
+class Dynamixel_Receiver {
+// public declaration
+public:
+    /**
+     * initialize the receiver
+     * @param t_capacity the largest expected status packet | default -> 1024
+     */
+    explicit Dynamixel_Receiver(size_t t_capacity = 1024):
+            m_buffer(t_capacity),
+            m_param(t_capacity) {
+    };
+    /**
+     * receive the next valid status packet
+     * @param t_port_handler the port handler
+     * @param t_deadline the host time to give up at
+     * @param t_status the decoded status
+     * @return the communication result -> COMM_SUCCESS or COMM_RX_TIMEOUT
+     */
+    int get_status(dynamixel::PortHandler *t_port_handler, double t_deadline, Dynamixel_Status &t_status);
+    /**
+     * drop all buffered bytes
+     */
+    void set_clear();
+
+// private declaration
+private:
+    /**
+     * the received bytes
+     */
+    std::vector<uint8_t> m_buffer;
+    /**
+     * the unstuffed parameters of the last status
+     */
+    std::vector<uint8_t> m_param;
+    /**
+     * the amount of buffered bytes
+     */
+    size_t m_filled = 0;
+    /**
+     * drop bytes from the front of the buffer
+     * @param t_length the amount of bytes
+     */
+    void m_set_consumed(size_t t_length);
+};
+
+#endif
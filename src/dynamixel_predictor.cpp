@@ -0,0 +1,65 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "dynamixel_predictor.h"
+
+// 0.229 rev/min per velocity unit, 4096 ticks per revolution
+#define DXL_VELOCITY_TO_TICKS (0.229 * 4096.0 / 60.0)
+
+/**
+ * add a time stamped state snapshot
+ * @param t_state the state snapshot of a dynamixel
+ */
+void Dynamixel_Predictor::set_state(const Dynamixel_State &t_state) {
+    Dynamixel_Predictor_History &dxl_history = m_history[t_state.id];
+    double dxl_velocity = t_state.velocity * DXL_VELOCITY_TO_TICKS;
+    double dxl_dt = t_state.time - dxl_history.time;
+
+    if (dxl_history.samples > 0 && dxl_dt <= 0.0) {
+        return;
+    }
+    if (dxl_history.samples > 0 && dxl_dt < m_horizon) {
+        dxl_history.acceleration = (dxl_velocity - dxl_history.velocity) / dxl_dt;
+    } else {
+        dxl_history.acceleration = 0.0;
+    }
+    dxl_history.time = t_state.time;
+    dxl_history.position = t_state.position;
+    dxl_history.velocity = dxl_velocity;
+    dxl_history.samples++;
+}
+/**
+ * get the state of a dynamixel at any moment
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_time the host time in seconds
+ * @return the predicted joint state
+ */
+Dynamixel_Prediction Dynamixel_Predictor::get_state(uint8_t t_dxl_id, double t_time) {
+    const Dynamixel_Predictor_History &dxl_history = m_history[t_dxl_id];
+    double dxl_age = t_time - dxl_history.time;
+    // never extrapolate further than the horizon, the model is only valid for short gaps
+    double dxl_dt = std::clamp(dxl_age, -m_horizon, m_horizon);
+
+    Dynamixel_Prediction dxl_prediction{};
+    dxl_prediction.position = dxl_history.position + dxl_history.velocity * dxl_dt + 0.5 * dxl_history.acceleration * dxl_dt * dxl_dt;
+    dxl_prediction.velocity = dxl_history.velocity + dxl_history.acceleration * dxl_dt;
+    dxl_prediction.age = dxl_age;
+    return dxl_prediction;
+}
@@ -0,0 +1,93 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_PREDICTOR_H
+#define DYNAMIXEL_DYNAMIXEL_PREDICTOR_H
+
+#include <cstdint>
+#include <array>
+#include "dynamixel.h"
+
+/**
+ * the extrapolated joint state of a dynamixel
+ */
+struct Dynamixel_Prediction {
+    /**
+     * the predicted position in ticks
+     */
+    double position;
+    /**
+     * the predicted velocity in ticks per second
+     */
+    double velocity;
+    /**
+     * the age of the newest sample the prediction is based on, in seconds
+     */
+    double age;
+};
+
+/**
+ * extrapolates the joint state of every dynamixel between two reads
+ */
+class Dynamixel_Predictor {
+// public declaration
+public:
+    /**
+     * initialize the predictor
+     * @param t_horizon the longest extrapolation in seconds | default -> 0.05
+     */
+    explicit Dynamixel_Predictor(double t_horizon = 0.05):
+            m_horizon(t_horizon) {
+    };
+    /**
+     * add a time stamped state snapshot
+     * @param t_state the state snapshot of a dynamixel
+     */
+    void set_state(const Dynamixel_State &t_state);
+    /**
+     * get the state of a dynamixel at any moment
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_time the host time in seconds
+     * @return the predicted joint state
+     */
+    Dynamixel_Prediction get_state(uint8_t t_dxl_id, double t_time);
+
+// private declaration
+private:
+    /**
+     * the last two samples of a dynamixel
+     */
+    struct Dynamixel_Predictor_History {
+        uint32_t samples = 0;
+        double time = 0.0;
+        double position = 0.0;
+        double velocity = 0.0;
+        double acceleration = 0.0;
+    };
+    /**
+     * the longest extrapolation in seconds
+     */
+    double m_horizon;
+    /**
+     * the history for every possible identifier
+     */
+    std::array<Dynamixel_Predictor_History, 256> m_history{};
+};
+
+#endif
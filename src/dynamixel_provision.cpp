@@ -0,0 +1,295 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "dynamixel_provision.h"
+
+const Dynamixel_Provision::Dynamixel_Field Dynamixel_Provision::m_fields[] = {
+        {"id", &Dynamixel_Config::new_id, ADDR_ID, 1, 0, 252},
+        {"baud_rate", &Dynamixel_Config::baud_rate, ADDR_BAUD_RATE, 1, 0, 7},
+        {"return_delay_time", &Dynamixel_Config::return_delay_time, ADDR_RETURN_DELAY_TIME, 1, 0, 254},
+        {"drive_mode", &Dynamixel_Config::drive_mode, ADDR_DRIVE_MODE, 1, 0, 13},
+        {"operating_mode", &Dynamixel_Config::operating_mode, ADDR_OPERATING_MODE, 1, 0, 16},
+        {"shadow_id", &Dynamixel_Config::shadow_id, ADDR_SHADOW_ID, 1, 0, 255},
+        {"homing_offset", &Dynamixel_Config::homing_offset, ADDR_HOMING_OFFSET, 4, -1044479, 1044479},
+        {"moving_threshold", &Dynamixel_Config::moving_threshold, ADDR_MOVING_THRESHOLD, 4, 0, 1023},
+        {"temperature_limit", &Dynamixel_Config::temperature_limit, ADDR_TEMPERATURE_LIMIT, 1, 0, 100},
+        {"max_voltage_limit", &Dynamixel_Config::max_voltage_limit, ADDR_MAX_VOLTAGE_LIMIT, 2, 31, 160},
+        {"min_voltage_limit", &Dynamixel_Config::min_voltage_limit, ADDR_MIN_VOLTAGE_LIMIT, 2, 31, 160},
+        {"pwm_limit", &Dynamixel_Config::pwm_limit, ADDR_PWM_LIMIT, 2, 0, 885},
+        {"velocity_limit", &Dynamixel_Config::velocity_limit, ADDR_VELOCITY_LIMIT, 4, 0, 2047},
+        {"max_position_limit", &Dynamixel_Config::max_position_limit, ADDR_MAX_POSITION_LIMIT, 4, 0, 4095},
+        {"min_position_limit", &Dynamixel_Config::min_position_limit, ADDR_MIN_POSITION_LIMIT, 4, 0, 4095},
+        {"shutdown", &Dynamixel_Config::shutdown, ADDR_SHUTDOWN, 1, 0, 63},
+        {nullptr, nullptr, 0, 0, 0, 0}
+};
+
+/**
+ * add or merge the configuration of a dynamixel
+ * @param t_config the configuration
+ */
+void Dynamixel_Provision::set_config(const Dynamixel_Config &t_config) {
+    Dynamixel_Config &dxl_config = m_get_config(t_config.id);
+    for (const Dynamixel_Field *dxl_field = m_fields; dxl_field->name; dxl_field++) {
+        if (t_config.*dxl_field->value) {
+            dxl_config.*dxl_field->value = t_config.*dxl_field->value;
+        }
+    }
+}
+/**
+ * load configurations from a file, one "<id> <field> <value>" per line, # starts a comment
+ * @param t_path the path of the file
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Provision::set_file(const char* t_path) {
+    FILE *dxl_file = fopen(t_path, "r");
+    if (!dxl_file) {
+        printf("failed: open of configuration: %s\n", t_path);
+        return false;
+    }
+    bool dxl_success = true;
+    char dxl_line[256];
+    for (int dxl_number = 1; fgets(dxl_line, sizeof(dxl_line), dxl_file); dxl_number++) {
+        char *dxl_comment = strchr(dxl_line, '#');
+        if (dxl_comment) {
+            *dxl_comment = '\0';
+        }
+        int dxl_id = 0;
+        char dxl_name[64];
+        char dxl_rest = '\0';
+        long dxl_value = 0;
+        int dxl_fields = sscanf(dxl_line, "%d %63s %ld %c", &dxl_id, dxl_name, &dxl_value, &dxl_rest);
+        if (dxl_fields <= 0) {
+            continue;
+        }
+        const Dynamixel_Field *dxl_field = m_fields;
+        while (dxl_field->name && (dxl_fields != 3 || strcmp(dxl_field->name, dxl_name) != 0)) {
+            dxl_field++;
+        }
+        if (!dxl_field->name || dxl_id < 0 || dxl_id >= BROADCAST_ID) {
+            printf("failed: invalid configuration in line: %d\n", dxl_number);
+            dxl_success = false;
+            continue;
+        }
+        if (dxl_value < dxl_field->minimum || dxl_value > dxl_field->maximum) {
+            printf("failed: %s out of range in line: %d\n", dxl_field->name, dxl_number);
+            dxl_success = false;
+            continue;
+        }
+        m_get_config((uint8_t)dxl_id).*dxl_field->value = (int32_t)dxl_value;
+    }
+    fclose(dxl_file);
+    return dxl_success;
+}
+/**
+ * remove all configurations
+ */
+void Dynamixel_Provision::set_clear() {
+    m_configs.clear();
+}
+/**
+ * bring all configured dynamixel's to their configuration
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Provision::set_apply() {
+    m_changed = 0;
+    if (m_configs.empty()) {
+        return true;
+    }
+    for (const Dynamixel_Config &dxl_config : m_configs) {
+        if (!m_get_range(dxl_config)) {
+            return false;
+        }
+    }
+    // identifiers must stay unique after the id changes
+    for (size_t i = 0; i < m_configs.size(); i++) {
+        for (size_t j = 0; j < m_configs.size(); j++) {
+            uint8_t dxl_first = m_configs[i].new_id ? (uint8_t)*m_configs[i].new_id : m_configs[i].id;
+            uint8_t dxl_second = m_configs[j].new_id ? (uint8_t)*m_configs[j].new_id : m_configs[j].id;
+            if (i != j && dxl_first == dxl_second) {
+                printf("failed: duplicate identifier: %d\n", dxl_first);
+                return false;
+            }
+        }
+    }
+
+    // eeprom (0-63) and torque enable (64) of every dynamixel in one read
+    Dynamixel_Builder dxl_builder = Dynamixel_Builder();
+    std::vector<size_t> dxl_reads;
+    for (const Dynamixel_Config &dxl_config : m_configs) {
+        dxl_reads.push_back(dxl_builder.set_read(dxl_config.id, 0, DXL_PROVISION_LEN));
+    }
+    Dynamixel_Plan dxl_plan = dxl_builder.get_plan(m_dynamixel);
+    bool dxl_success = dxl_plan.set_execute();
+
+    Dynamixel_Builder dxl_stages[DXL_STAGES];
+    Dynamixel_Builder dxl_verify = Dynamixel_Builder();
+    size_t dxl_counts[DXL_STAGES] = {};
+    std::vector<std::vector<uint8_t>> dxl_images;
+    std::vector<size_t> dxl_checks;
+    for (size_t i = 0; i < m_configs.size(); i++) {
+        const Dynamixel_Config &dxl_config = m_configs[i];
+        if (!dxl_plan.get_valid(dxl_reads[i])) {
+            printf("failed: read of eeprom: %d\n", dxl_config.id);
+            dxl_success = false;
+            continue;
+        }
+        const uint8_t *dxl_current = dxl_plan.get_data(dxl_reads[i]);
+        std::vector<uint8_t> dxl_image(dxl_current, dxl_current + DXL_PROVISION_LEN);
+        for (const Dynamixel_Field *dxl_field = m_fields; dxl_field->name; dxl_field++) {
+            if (!(dxl_config.*dxl_field->value)) {
+                continue;
+            }
+            for (uint16_t j = 0; j < dxl_field->length; j++) {
+                dxl_image[dxl_field->address + j] = (uint8_t)((uint32_t)*(dxl_config.*dxl_field->value) >> (8 * j));
+            }
+        }
+        bool dxl_new_id = dxl_image[ADDR_ID] != dxl_current[ADDR_ID];
+        bool dxl_new_baud = dxl_image[ADDR_BAUD_RATE] != dxl_current[ADDR_BAUD_RATE];
+        uint8_t dxl_id = dxl_image[ADDR_ID];
+
+        // changed fields, each written as a whole (id and baud rate are applied later)
+        size_t dxl_before = m_changed;
+        for (const Dynamixel_Field *dxl_field = m_fields; dxl_field->name; dxl_field++) {
+            if (dxl_field->address == ADDR_ID || dxl_field->address == ADDR_BAUD_RATE) {
+                continue;
+            }
+            if (memcmp(&dxl_image[dxl_field->address], &dxl_current[dxl_field->address], dxl_field->length) == 0) {
+                continue;
+            }
+            uint32_t dxl_value = 0;
+            for (uint16_t j = 0; j < dxl_field->length; j++) {
+                dxl_value |= (uint32_t)dxl_image[dxl_field->address + j] << (8 * j);
+            }
+            dxl_stages[DXL_STAGE_DIFF].set_write(dxl_config.id, dxl_field->address, dxl_field->length, dxl_value);
+            dxl_counts[DXL_STAGE_DIFF]++;
+            m_changed += dxl_field->length;
+        }
+        if (dxl_new_id) {
+            dxl_stages[DXL_STAGE_ID].set_write(dxl_config.id, ADDR_ID, 1, dxl_id);
+            dxl_counts[DXL_STAGE_ID]++;
+            m_changed++;
+        }
+        if (dxl_new_baud) {
+            dxl_stages[DXL_STAGE_BAUD].set_write(dxl_id, ADDR_BAUD_RATE, 1, dxl_image[ADDR_BAUD_RATE]);
+            dxl_counts[DXL_STAGE_BAUD]++;
+            m_changed++;
+        }
+        if (m_changed == dxl_before) {
+            continue;
+        }
+        // eeprom is locked while torque is enabled
+        if (dxl_current[ADDR_TORQUE]) {
+            dxl_stages[DXL_STAGE_TORQUE_OFF].set_write(dxl_config.id, ADDR_TORQUE, 1, 0);
+            dxl_counts[DXL_STAGE_TORQUE_OFF]++;
+            if (!dxl_new_baud) {
+                dxl_stages[DXL_STAGE_TORQUE_ON].set_write(dxl_id, ADDR_TORQUE, 1, 1);
+                dxl_counts[DXL_STAGE_TORQUE_ON]++;
+            }
+        }
+        if (!dxl_new_baud) {
+            dxl_images.push_back(dxl_image);
+            dxl_checks.push_back(dxl_verify.set_read(dxl_id, 0, ADDR_TORQUE));
+        }
+    }
+
+    // eeprom stages wait until the write is done
+    for (int i = 0; i < DXL_STAGES; i++) {
+        bool dxl_eeprom = i == DXL_STAGE_DIFF || i == DXL_STAGE_ID || i == DXL_STAGE_BAUD;
+        dxl_success &= m_set_plan(m_dynamixel, dxl_stages[i], dxl_counts[i], dxl_eeprom);
+    }
+    if (dxl_checks.empty()) {
+        return dxl_success;
+    }
+
+    // read back what was written, again in one batched read
+    Dynamixel_Plan dxl_check = dxl_verify.get_plan(m_dynamixel);
+    dxl_check.set_execute();
+    for (size_t i = 0; i < dxl_checks.size(); i++) {
+        if (!dxl_check.get_valid(dxl_checks[i]) || memcmp(dxl_check.get_data(dxl_checks[i]), dxl_images[i].data(), ADDR_TORQUE) != 0) {
+            printf("failed: verify of eeprom: %d\n", dxl_images[i][ADDR_ID]);
+            dxl_success = false;
+        }
+    }
+    return dxl_success;
+}
+/**
+ * get the amount of eeprom bytes which were written by the last apply
+ * @return the amount of bytes
+ */
+size_t Dynamixel_Provision::get_changed() {
+    return m_changed;
+}
+
+// MARK: - Private Functions
+/**
+ * get the configuration of a dynamixel, adds an empty one if unknown
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the configuration
+ */
+Dynamixel_Config &Dynamixel_Provision::m_get_config(uint8_t t_dxl_id) {
+    for (Dynamixel_Config &dxl_config : m_configs) {
+        if (dxl_config.id == t_dxl_id) {
+            return dxl_config;
+        }
+    }
+    Dynamixel_Config dxl_config{};
+    dxl_config.id = t_dxl_id;
+    m_configs.push_back(dxl_config);
+    return m_configs.back();
+}
+/**
+ * check the configured values of a dynamixel against the range of their field
+ * @param t_config the configuration
+ * @return true if all values are in range otherwise false
+ */
+bool Dynamixel_Provision::m_get_range(const Dynamixel_Config &t_config) {
+    for (const Dynamixel_Field *dxl_field = m_fields; dxl_field->name; dxl_field++) {
+        std::optional<int32_t> dxl_value = t_config.*dxl_field->value;
+        if (dxl_value && (*dxl_value < dxl_field->minimum || *dxl_value > dxl_field->maximum)) {
+            printf("failed: %s of id: %d out of range: %d\n", dxl_field->name, t_config.id, *dxl_value);
+            return false;
+        }
+    }
+    return true;
+}
+/**
+ * compile and send the writes of a builder
+ * @param t_dynamixel the dynamixel bus
+ * @param t_builder the builder
+ * @param t_count the amount of writes in the builder
+ * @param t_eeprom true to wait until the eeprom write is done
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Provision::m_set_plan(Dynamixel &t_dynamixel, Dynamixel_Builder &t_builder, size_t t_count, bool t_eeprom) {
+    if (t_count == 0) {
+        return true;
+    }
+    Dynamixel_Plan dxl_plan = t_builder.get_plan(t_dynamixel);
+    bool dxl_success = dxl_plan.set_execute();
+    if (!dxl_success) {
+        printf("failed: write of configuration\n");
+    }
+    if (t_eeprom) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(DXL_PROVISION_SETTLE));
+    }
+    return dxl_success;
+}
@@ -0,0 +1,211 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_PROVISION_H
+#define DYNAMIXEL_DYNAMIXEL_PROVISION_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "dynamixel.h"
+#include "dynamixel_transaction.h"
+
+#define DXL_PROVISION_LEN 65
+#define DXL_PROVISION_SETTLE 0.02
+
+/**
+ * the desired eeprom configuration of a dynamixel, unset fields are left as they are
+ */
+struct Dynamixel_Config {
+    /**
+     * the current identifier of the dynamixel
+     */
+    uint8_t id;
+    /**
+     * the new identifier, applied after all other fields
+     */
+    std::optional<int32_t> new_id;
+    /**
+     * the baud rate index, applied last -> the port must be reopened afterwards
+     */
+    std::optional<int32_t> baud_rate;
+    /**
+     * the return delay time in 2 usec units
+     */
+    std::optional<int32_t> return_delay_time;
+    /**
+     * the drive mode
+     */
+    std::optional<int32_t> drive_mode;
+    /**
+     * the operating mode
+     */
+    std::optional<int32_t> operating_mode;
+    /**
+     * the secondary (shadow) identifier
+     */
+    std::optional<int32_t> shadow_id;
+    /**
+     * the homing offset
+     */
+    std::optional<int32_t> homing_offset;
+    /**
+     * the moving threshold
+     */
+    std::optional<int32_t> moving_threshold;
+    /**
+     * the temperature limit
+     */
+    std::optional<int32_t> temperature_limit;
+    /**
+     * the max voltage limit
+     */
+    std::optional<int32_t> max_voltage_limit;
+    /**
+     * the min voltage limit
+     */
+    std::optional<int32_t> min_voltage_limit;
+    /**
+     * the pwm limit
+     */
+    std::optional<int32_t> pwm_limit;
+    /**
+     * the velocity limit
+     */
+    std::optional<int32_t> velocity_limit;
+    /**
+     * the max position limit
+     */
+    std::optional<int32_t> max_position_limit;
+    /**
+     * the min position limit
+     */
+    std::optional<int32_t> min_position_limit;
+    /**
+     * the shutdown conditions
+     */
+    std::optional<int32_t> shutdown;
+};
+
+/**
+ * brings the eeprom of a fleet to a declared configuration, reads all eeprom
+ * blocks in one batched read and writes only the fields which differ
+ * NOTE: dynamixel's whose baud rate changes are left with torque disabled
+ */
+class Dynamixel_Provision {
+// public declaration
+public:
+    /**
+     * initialize the provisioning
+     * @param t_dynamixel the dynamixel bus
+     */
+    explicit Dynamixel_Provision(Dynamixel &t_dynamixel):
+            m_dynamixel(t_dynamixel) {
+    };
+    /**
+     * add or merge the configuration of a dynamixel
+     * @param t_config the configuration
+     */
+    void set_config(const Dynamixel_Config &t_config);
+    /**
+     * load configurations from a file, one "<id> <field> <value>" per line, # starts a comment
+     * NOTE: values are decimal and must be in the range of their field
+     * @param t_path the path of the file
+     * @return true if success otherwise false
+     */
+    bool set_file(const char* t_path);
+    /**
+     * remove all configurations
+     */
+    void set_clear();
+    /**
+     * bring all configured dynamixel's to their configuration
+     * @return true if success otherwise false
+     */
+    bool set_apply();
+    /**
+     * get the amount of eeprom bytes which were written by the last apply
+     * @return the amount of bytes
+     */
+    size_t get_changed();
+
+// private declaration
+private:
+    /**
+     * a configurable eeprom field
+     */
+    struct Dynamixel_Field {
+        const char* name;
+        std::optional<int32_t> Dynamixel_Config::*value;
+        uint16_t address;
+        uint16_t length;
+        int32_t minimum;
+        int32_t maximum;
+    };
+    /**
+     * the stages of an apply, sent one after another
+     */
+    enum Dynamixel_Stage {
+        DXL_STAGE_TORQUE_OFF = 0,
+        DXL_STAGE_DIFF = 1,
+        DXL_STAGE_ID = 2,
+        DXL_STAGE_BAUD = 3,
+        DXL_STAGE_TORQUE_ON = 4,
+        DXL_STAGES = 5
+    };
+    /**
+     * the configurable fields, terminated by an empty name
+     */
+    static const Dynamixel_Field m_fields[];
+    /**
+     * the dynamixel bus
+     */
+    Dynamixel &m_dynamixel;
+    /**
+     * the configurations, one per dynamixel
+     */
+    std::vector<Dynamixel_Config> m_configs;
+    /**
+     * the amount of eeprom bytes which were written by the last apply
+     */
+    size_t m_changed = 0;
+    /**
+     * get the configuration of a dynamixel, adds an empty one if unknown
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return the configuration
+     */
+    Dynamixel_Config &m_get_config(uint8_t t_dxl_id);
+    /**
+     * check the configured values of a dynamixel against the range of their field
+     * @param t_config the configuration
+     * @return true if all values are in range otherwise false
+     */
+    static bool m_get_range(const Dynamixel_Config &t_config);
+    /**
+     * compile and send the writes of a builder
+     * @param t_dynamixel the dynamixel bus
+     * @param t_builder the builder
+     * @param t_count the amount of writes in the builder
+     * @param t_eeprom true to wait until the eeprom write is done
+     * @return true if success otherwise false
+     */
+    static bool m_set_plan(Dynamixel &t_dynamixel, Dynamixel_Builder &t_builder, size_t t_count, bool t_eeprom);
+};
+
+#endif
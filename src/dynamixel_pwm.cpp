@@ -0,0 +1,254 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include "dynamixel_audit.h"
+#include "dynamixel_clock.h"
+#include "dynamixel_provision.h"
+#include "dynamixel_pwm.h"
+#include "dynamixel_transaction.h"
+
+/**
+ * initialize the pwm control
+ * @param t_dynamixel the dynamixel bus
+ * @param t_dxl_ids the identifiers of the dynamixel's, the index in this list is the index of every getter
+ */
+Dynamixel_Pwm_Control::Dynamixel_Pwm_Control(Dynamixel &t_dynamixel, const std::vector<uint8_t> &t_dxl_ids):
+        m_dynamixel(t_dynamixel),
+        m_dxl_ids(t_dxl_ids),
+        m_limits(t_dxl_ids.size(), 0),
+        m_positions(t_dxl_ids.size(), 0),
+        m_velocities(t_dxl_ids.size(), 0),
+        m_loads(t_dxl_ids.size(), 0),
+        m_valid(t_dxl_ids.size(), 0) {
+    // sync write: goal pwm, 2 bytes per dynamixel
+    m_write_param = {DXL_LOBYTE(ADDR_GOAL_PWM), DXL_HIBYTE(ADDR_GOAL_PWM), 2, 0};
+    // sync read: present load, velocity and position in one block
+    m_read_param = {DXL_LOBYTE(ADDR_PRESENT_LOAD), DXL_HIBYTE(ADDR_PRESENT_LOAD), DXL_PWM_READ_LEN, 0};
+    for (uint8_t dxl_id : m_dxl_ids) {
+        m_write_param.insert(m_write_param.end(), {dxl_id, 0, 0});
+        m_read_param.push_back(dxl_id);
+    }
+    // every parameter byte could need stuffing
+    m_tx.resize(2 * DXL_INSTRUCTION_FRAME_LEN + 2 * (m_write_param.size() + m_read_param.size()));
+
+    Dynamixel_Bus_Model dxl_model = Dynamixel_Bus_Model(t_dynamixel.get_baud_rate());
+    uint16_t dxl_count = (uint16_t)m_dxl_ids.size();
+    m_timeout = 2.0 * (dxl_model.get_transaction_time({INST_SYNC_WRITE, dxl_count, (uint16_t)(2 * dxl_count)}) + dxl_model.get_transaction_time({INST_SYNC_READ, dxl_count, (uint16_t)(DXL_PWM_READ_LEN * dxl_count)}));
+}
+/**
+ * read the pwm limits and switch every dynamixel into pwm mode, the torque state is kept
+ * NOTE: a switched dynamixel starts with a goal pwm of 0, one whose switch can't be confirmed stays without torque
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Pwm_Control::set_open() {
+    Dynamixel_Builder dxl_builder;
+    std::vector<size_t> dxl_limits, dxl_modes, dxl_torques;
+    for (uint8_t dxl_id : m_dxl_ids) {
+        dxl_limits.push_back(dxl_builder.set_read(dxl_id, ADDR_PWM_LIMIT, 2));
+        dxl_modes.push_back(dxl_builder.set_read(dxl_id, ADDR_OPERATING_MODE, 1));
+        dxl_torques.push_back(dxl_builder.set_read(dxl_id, ADDR_TORQUE, 1));
+    }
+    Dynamixel_Plan dxl_plan = dxl_builder.get_plan(m_dynamixel);
+    dxl_plan.set_execute();
+
+    bool dxl_result = true;
+    std::vector<size_t> dxl_switched;
+    Dynamixel_Builder dxl_torque_off, dxl_mode;
+    for (size_t i = 0; i < m_dxl_ids.size(); i++) {
+        if (!dxl_plan.get_valid(dxl_limits[i]) || !dxl_plan.get_valid(dxl_modes[i]) || !dxl_plan.get_valid(dxl_torques[i])) {
+            printf("failed: read pwm limit of id: %i\n", m_dxl_ids[i]);
+            dxl_result = false;
+            continue;
+        }
+        m_limits[i] = (int16_t)dxl_plan.get_value(dxl_limits[i]);
+        if (dxl_plan.get_value(dxl_modes[i]) == ADDR_CONTROL_MODE_PWM) {
+            continue;
+        }
+        // the operating mode is in the eeprom area, which is locked while the torque is on
+        dxl_switched.push_back(i);
+        dxl_torque_off.set_write(m_dxl_ids[i], ADDR_TORQUE, 1, 0);
+        dxl_mode.set_write(m_dxl_ids[i], ADDR_OPERATING_MODE, 1, ADDR_CONTROL_MODE_PWM);
+    }
+    if (!dxl_switched.empty()) {
+        dxl_torque_off.get_plan(m_dynamixel).set_execute();
+        dxl_mode.get_plan(m_dynamixel).set_execute();
+        std::this_thread::sleep_for(std::chrono::duration<double>(DXL_PROVISION_SETTLE));
+
+        // confirm the switch and zero the goal pwm, a stale goal would drive the motor as soon as the torque is on
+        Dynamixel_Builder dxl_confirm, dxl_zero, dxl_torque_on;
+        std::vector<size_t> dxl_confirms;
+        for (size_t i : dxl_switched) {
+            dxl_confirms.push_back(dxl_confirm.set_read(m_dxl_ids[i], ADDR_OPERATING_MODE, 1));
+        }
+        Dynamixel_Plan dxl_check = dxl_confirm.get_plan(m_dynamixel);
+        dxl_check.set_execute();
+        for (size_t j = 0; j < dxl_switched.size(); j++) {
+            size_t i = dxl_switched[j];
+            if (!dxl_check.get_valid(dxl_confirms[j]) || dxl_check.get_value(dxl_confirms[j]) != ADDR_CONTROL_MODE_PWM) {
+                printf("failed: switch of id: %i into pwm mode\n", m_dxl_ids[i]);
+                dxl_result = false;
+                continue;
+            }
+            dxl_zero.set_write(m_dxl_ids[i], ADDR_GOAL_PWM, 2, 0);
+            if (dxl_plan.get_value(dxl_torques[i])) {
+                dxl_torque_on.set_write(m_dxl_ids[i], ADDR_TORQUE, 1, 1);
+            }
+        }
+        dxl_zero.get_plan(m_dynamixel).set_execute();
+        dxl_torque_on.get_plan(m_dynamixel).set_execute();
+    }
+    m_last_start = 0.0;
+    m_rate = 0.0;
+    return dxl_result;
+}
+/**
+ * set the goal pwm of a dynamixel for the next cycle, clamped to its pwm limit
+ * @param t_index the index of the dynamixel
+ * @param t_pwm the goal pwm -> -pwm limit to pwm limit
+ */
+void Dynamixel_Pwm_Control::set_pwm(size_t t_index, int16_t t_pwm) {
+    int16_t dxl_limit = m_limits[t_index];
+    if (t_pwm > dxl_limit || t_pwm < -dxl_limit) {
+        t_pwm = t_pwm > 0 ? dxl_limit : (int16_t)(-dxl_limit);
+        m_clamped++;
+    }
+    m_write_param[4 + 3 * t_index + 1] = DXL_LOBYTE(t_pwm);
+    m_write_param[4 + 3 * t_index + 2] = DXL_HIBYTE(t_pwm);
+}
+/**
+ * send all goals and read back the state of all dynamixel's
+ * @return true if every dynamixel answered otherwise false
+ */
+bool Dynamixel_Pwm_Control::set_cycle() {
+    Dynamixel_Tick_Guard dxl_guard("Dynamixel_Pwm_Control::set_cycle");
+    double dxl_start = Dynamixel_Clock::get_monotonic_time();
+    if (m_last_start > 0.0 && dxl_start > m_last_start) {
+        double dxl_rate = 1.0 / (dxl_start - m_last_start);
+        m_rate = m_rate == 0.0 ? dxl_rate : m_rate + DXL_PWM_RATE_SMOOTHING * (dxl_rate - m_rate);
+    }
+    m_last_start = dxl_start;
+
+    // the sync read follows the sync write without a gap, one port write for both
+    size_t dxl_length = Dynamixel_Packet::set_instruction(m_tx.data(), m_tx.size(), BROADCAST_ID, INST_SYNC_WRITE, m_write_param.data(), m_write_param.size());
+    dxl_length += Dynamixel_Packet::set_instruction(m_tx.data() + dxl_length, m_tx.size() - dxl_length, BROADCAST_ID, INST_SYNC_READ, m_read_param.data(), m_read_param.size());
+    std::fill(m_valid.begin(), m_valid.end(), 0);
+    if (Dynamixel_Packet::set_transmit(m_dynamixel.get_port_handler(), m_tx.data(), dxl_length) != COMM_SUCCESS) {
+        m_cycle_time = Dynamixel_Clock::get_monotonic_time() - dxl_start;
+        return false;
+    }
+
+    m_receiver.set_clear();
+    double dxl_deadline = dxl_start + m_timeout;
+    size_t dxl_received = 0;
+    while (dxl_received < m_dxl_ids.size()) {
+        Dynamixel_Status dxl_status{};
+        if (m_receiver.get_status(m_dynamixel.get_port_handler(), dxl_deadline, dxl_status) != COMM_SUCCESS) {
+            break;
+        }
+        size_t dxl_index = get_index(dxl_status.id);
+        if (dxl_index == m_dxl_ids.size() || m_valid[dxl_index] || dxl_status.length < DXL_PWM_READ_LEN) {
+            continue;
+        }
+        const uint8_t *dxl_data = dxl_status.param;
+        m_loads[dxl_index] = (int16_t)DXL_MAKEWORD(dxl_data[0], dxl_data[1]);
+        m_velocities[dxl_index] = (int32_t)DXL_MAKEDWORD(DXL_MAKEWORD(dxl_data[2], dxl_data[3]), DXL_MAKEWORD(dxl_data[4], dxl_data[5]));
+        m_positions[dxl_index] = (int32_t)DXL_MAKEDWORD(DXL_MAKEWORD(dxl_data[6], dxl_data[7]), DXL_MAKEWORD(dxl_data[8], dxl_data[9]));
+        m_valid[dxl_index] = 1;
+        dxl_received++;
+    }
+    m_cycle_time = Dynamixel_Clock::get_monotonic_time() - dxl_start;
+    return dxl_received == m_dxl_ids.size();
+}
+/**
+ * get the index of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the index or the amount of dynamixel's if unknown
+ */
+size_t Dynamixel_Pwm_Control::get_index(uint8_t t_dxl_id) {
+    for (size_t i = 0; i < m_dxl_ids.size(); i++) {
+        if (m_dxl_ids[i] == t_dxl_id) {
+            return i;
+        }
+    }
+    return m_dxl_ids.size();
+}
+/**
+ * get the pwm limit of a dynamixel
+ * @param t_index the index of the dynamixel
+ * @return the pwm limit
+ */
+int16_t Dynamixel_Pwm_Control::get_limit(size_t t_index) {
+    return m_limits[t_index];
+}
+/**
+ * get the present position from the last cycle
+ * @param t_index the index of the dynamixel
+ * @return the present position
+ */
+int32_t Dynamixel_Pwm_Control::get_position(size_t t_index) {
+    return m_positions[t_index];
+}
+/**
+ * get the present velocity from the last cycle
+ * @param t_index the index of the dynamixel
+ * @return the present velocity
+ */
+int32_t Dynamixel_Pwm_Control::get_velocity(size_t t_index) {
+    return m_velocities[t_index];
+}
+/**
+ * get the present load from the last cycle
+ * @param t_index the index of the dynamixel
+ * @return the present load
+ */
+int16_t Dynamixel_Pwm_Control::get_load(size_t t_index) {
+    return m_loads[t_index];
+}
+/**
+ * check if a dynamixel answered in the last cycle
+ * @param t_index the index of the dynamixel
+ * @return true if valid otherwise false
+ */
+bool Dynamixel_Pwm_Control::get_valid(size_t t_index) {
+    return m_valid[t_index];
+}
+/**
+ * get the achieved loop rate, smoothed over the last cycles
+ * @return the rate in hz
+ */
+double Dynamixel_Pwm_Control::get_rate() {
+    return m_rate;
+}
+/**
+ * get the bus time of the last cycle
+ * @return the time in seconds
+ */
+double Dynamixel_Pwm_Control::get_cycle_time() {
+    return m_cycle_time;
+}
+/**
+ * get the amount of goals which were clamped to the pwm limit
+ * @return the amount of goals
+ */
+uint64_t Dynamixel_Pwm_Control::get_clamped() {
+    return m_clamped;
+}
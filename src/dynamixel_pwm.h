@@ -0,0 +1,183 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_PWM_H
+#define DYNAMIXEL_DYNAMIXEL_PWM_H
+
+#include <cstdint>
+#include <vector>
+#include "dynamixel.h"
+#include "dynamixel_bus_model.h"
+#include "dynamixel_packet.h"
+
+#define DXL_PWM_READ_LEN 10
+#define DXL_PWM_RATE_SMOOTHING 0.05
+
+/**
+ * host side pwm (torque) control of many dynamixel's: every cycle sends the goal pwm
+ * of all dynamixel's and reads back load, velocity and position as one sync write
+ * and one sync read in a single port write
+ */
+class Dynamixel_Pwm_Control {
+// public declaration
+public:
+    /**
+     * initialize the pwm control
+     * @param t_dynamixel the dynamixel bus
+     * @param t_dxl_ids the identifiers of the dynamixel's, the index in this list is the index of every getter
+     */
+    Dynamixel_Pwm_Control(Dynamixel &t_dynamixel, const std::vector<uint8_t> &t_dxl_ids);
+    /**
+     * read the pwm limits and switch every dynamixel into pwm mode, the torque state is kept
+     * NOTE: a switched dynamixel starts with a goal pwm of 0, one whose switch can't be confirmed stays without torque
+     * @return true if success otherwise false
+     */
+    bool set_open();
+    /**
+     * set the goal pwm of a dynamixel for the next cycle, clamped to its pwm limit
+     * @param t_index the index of the dynamixel
+     * @param t_pwm the goal pwm -> -pwm limit to pwm limit
+     */
+    void set_pwm(size_t t_index, int16_t t_pwm);
+    /**
+     * send all goals and read back the state of all dynamixel's
+     * @return true if every dynamixel answered otherwise false
+     */
+    bool set_cycle();
+    /**
+     * get the index of a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return the index or the amount of dynamixel's if unknown
+     */
+    size_t get_index(uint8_t t_dxl_id);
+    /**
+     * get the pwm limit of a dynamixel
+     * @param t_index the index of the dynamixel
+     * @return the pwm limit
+     */
+    int16_t get_limit(size_t t_index);
+    /**
+     * get the present position from the last cycle
+     * @param t_index the index of the dynamixel
+     * @return the present position
+     */
+    int32_t get_position(size_t t_index);
+    /**
+     * get the present velocity from the last cycle
+     * @param t_index the index of the dynamixel
+     * @return the present velocity
+     */
+    int32_t get_velocity(size_t t_index);
+    /**
+     * get the present load from the last cycle
+     * @param t_index the index of the dynamixel
+     * @return the present load
+     */
+    int16_t get_load(size_t t_index);
+    /**
+     * check if a dynamixel answered in the last cycle
+     * @param t_index the index of the dynamixel
+     * @return true if valid otherwise false
+     */
+    bool get_valid(size_t t_index);
+    /**
+     * get the achieved loop rate, smoothed over the last cycles
+     * @return the rate in hz
+     */
+    double get_rate();
+    /**
+     * get the bus time of the last cycle
+     * @return the time in seconds
+     */
+    double get_cycle_time();
+    /**
+     * get the amount of goals which were clamped to the pwm limit
+     * @return the amount of goals
+     */
+    uint64_t get_clamped();
+
+// private declaration
+private:
+    /**
+     * the dynamixel bus
+     */
+    Dynamixel &m_dynamixel;
+    /**
+     * the identifiers of the dynamixel's
+     */
+    std::vector<uint8_t> m_dxl_ids;
+    /**
+     * the pwm limits
+     */
+    std::vector<int16_t> m_limits;
+    /**
+     * the present positions of the last cycle
+     */
+    std::vector<int32_t> m_positions;
+    /**
+     * the present velocities of the last cycle
+     */
+    std::vector<int32_t> m_velocities;
+    /**
+     * the present loads of the last cycle
+     */
+    std::vector<int16_t> m_loads;
+    /**
+     * true for every dynamixel which answered in the last cycle
+     */
+    std::vector<uint8_t> m_valid;
+    /**
+     * the parameters of the sync write, the goals are updated in place
+     */
+    std::vector<uint8_t> m_write_param;
+    /**
+     * the parameters of the sync read
+     */
+    std::vector<uint8_t> m_read_param;
+    /**
+     * the encoded packet pair
+     */
+    std::vector<uint8_t> m_tx;
+    /**
+     * the receiver of the status packets
+     */
+    Dynamixel_Receiver m_receiver = Dynamixel_Receiver(64);
+    /**
+     * the time to wait for all status packets
+     */
+    double m_timeout = 0.0;
+    /**
+     * the host time at which the last cycle started
+     */
+    double m_last_start = 0.0;
+    /**
+     * the smoothed loop rate
+     */
+    double m_rate = 0.0;
+    /**
+     * the bus time of the last cycle
+     */
+    double m_cycle_time = 0.0;
+    /**
+     * the amount of clamped goals
+     */
+    uint64_t m_clamped = 0;
+};
+
+#endif
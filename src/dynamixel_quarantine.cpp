@@ -0,0 +1,96 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include "dynamixel_clock.h"
+#include "dynamixel_quarantine.h"
+
+/**
+ * record the result of a group read for a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_received true if the status was received
+ */
+void Dynamixel_Quarantine::set_result(uint8_t t_dxl_id, bool t_received) {
+    if (m_quarantined[t_dxl_id]) {
+        return;
+    }
+    if (t_received) {
+        m_misses[t_dxl_id] = 0;
+        return;
+    }
+    if (++m_misses[t_dxl_id] < m_max_misses) {
+        return;
+    }
+    printf("failed: quarantined id: %i\n", t_dxl_id);
+    m_quarantined[t_dxl_id] = true;
+    m_recoveries[t_dxl_id] = 0;
+    m_next_ping[t_dxl_id] = Dynamixel_Clock::get_monotonic_time() + m_period;
+    m_count++;
+}
+/**
+ * ping at most one quarantined dynamixel which is due, re-admits it when it answered often enough
+ * @param t_port_handler the port handler
+ * @param t_timeout the timeout of the ping in seconds
+ * @return true if a dynamixel was re-admitted
+ */
+bool Dynamixel_Quarantine::set_recovery(dynamixel::PortHandler *t_port_handler, double t_timeout) {
+    if (m_count == 0) {
+        return false;
+    }
+    double dxl_now = Dynamixel_Clock::get_monotonic_time();
+    // round robin, so one dead dynamixel can't starve the recovery of the others
+    for (int i = 0; i < 256; i++) {
+        uint8_t dxl_id = m_cursor++;
+        if (!m_quarantined[dxl_id] || m_next_ping[dxl_id] > dxl_now) {
+            continue;
+        }
+        m_next_ping[dxl_id] = dxl_now + m_period;
+        size_t dxl_length = Dynamixel_Packet::set_instruction(m_packet.data(), m_packet.size(), dxl_id, INST_PING, nullptr, 0);
+        if (Dynamixel_Packet::set_transmit(t_port_handler, m_packet.data(), dxl_length) != COMM_SUCCESS) {
+            return false;
+        }
+        m_receiver.set_clear();
+        Dynamixel_Status dxl_status{};
+        bool dxl_answered = m_receiver.get_status(t_port_handler, dxl_now + t_timeout, dxl_status) == COMM_SUCCESS && dxl_status.id == dxl_id;
+        m_recoveries[dxl_id] = dxl_answered ? m_recoveries[dxl_id] + 1 : 0;
+        if (m_recoveries[dxl_id] < m_max_recoveries) {
+            return false;
+        }
+        m_quarantined[dxl_id] = false;
+        m_misses[dxl_id] = 0;
+        m_count--;
+        return true;
+    }
+    return false;
+}
+/**
+ * check if a dynamixel takes part in group reads
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return false if the dynamixel is quarantined
+ */
+bool Dynamixel_Quarantine::get_admitted(uint8_t t_dxl_id) {
+    return !m_quarantined[t_dxl_id];
+}
+/**
+ * get the amount of quarantined dynamixel's
+ * @return the amount of dynamixel's
+ */
+size_t Dynamixel_Quarantine::get_count() {
+    return m_count;
+}
@@ -0,0 +1,123 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_QUARANTINE_H
+#define DYNAMIXEL_DYNAMIXEL_QUARANTINE_H
+
+#include <cstdint>
+#include <array>
+#include "dynamixel_packet.h"
+
+#define DXL_QUARANTINE_MISSES 3
+#define DXL_QUARANTINE_PERIOD 0.25
+#define DXL_QUARANTINE_RECOVERIES 3
+
+/**
+ * tracks the replies of every dynamixel to group reads, repeat offenders are moved
+ * out of the group reads and pinged at a slow rate until they answer reliably again
+ */
+class Dynamixel_Quarantine {
+// public declaration
+public:
+    /**
+     * initialize the quarantine
+     * @param t_misses the amount of consecutive misses until a dynamixel is quarantined
+     * @param t_period the period of the recovery ping in seconds
+     * @param t_recoveries the amount of consecutive answered pings until a dynamixel is re-admitted
+     */
+    explicit Dynamixel_Quarantine(uint8_t t_misses = DXL_QUARANTINE_MISSES, double t_period = DXL_QUARANTINE_PERIOD, uint8_t t_recoveries = DXL_QUARANTINE_RECOVERIES):
+            m_max_misses(t_misses),
+            m_period(t_period),
+            m_max_recoveries(t_recoveries),
+            m_receiver(Dynamixel_Receiver(64)) {
+    };
+    /**
+     * record the result of a group read for a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_received true if the status was received
+     */
+    void set_result(uint8_t t_dxl_id, bool t_received);
+    /**
+     * ping at most one quarantined dynamixel which is due, re-admits it when it answered often enough
+     * @param t_port_handler the port handler
+     * @param t_timeout the timeout of the ping in seconds
+     * @return true if a dynamixel was re-admitted
+     */
+    bool set_recovery(dynamixel::PortHandler *t_port_handler, double t_timeout);
+    /**
+     * check if a dynamixel takes part in group reads
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return false if the dynamixel is quarantined
+     */
+    bool get_admitted(uint8_t t_dxl_id);
+    /**
+     * get the amount of quarantined dynamixel's
+     * @return the amount of dynamixel's
+     */
+    size_t get_count();
+
+// private declaration
+private:
+    /**
+     * the amount of consecutive misses until a dynamixel is quarantined
+     */
+    uint8_t m_max_misses;
+    /**
+     * the period of the recovery ping in seconds
+     */
+    double m_period;
+    /**
+     * the amount of consecutive answered pings until a dynamixel is re-admitted
+     */
+    uint8_t m_max_recoveries;
+    /**
+     * the consecutive misses of every dynamixel
+     */
+    std::array<uint8_t, 256> m_misses{};
+    /**
+     * the consecutive answered pings of every quarantined dynamixel
+     */
+    std::array<uint8_t, 256> m_recoveries{};
+    /**
+     * true for every quarantined dynamixel
+     */
+    std::array<bool, 256> m_quarantined{};
+    /**
+     * the host time of the next recovery ping of every quarantined dynamixel
+     */
+    std::array<double, 256> m_next_ping{};
+    /**
+     * the encoded ping packet
+     */
+    std::array<uint8_t, DXL_INSTRUCTION_FRAME_LEN + 4> m_packet{};
+    /**
+     * the amount of quarantined dynamixel's
+     */
+    size_t m_count = 0;
+    /**
+     * the next identifier to look at for a recovery ping
+     */
+    uint8_t m_cursor = 0;
+    /**
+     * the receiver of the ping status
+     */
+    Dynamixel_Receiver m_receiver;
+};
+
+#endif
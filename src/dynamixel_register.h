@@ -0,0 +1,54 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_REGISTER_H
+#define DYNAMIXEL_DYNAMIXEL_REGISTER_H
+
+#include <cstdint>
+#include "dynamixel.h"
+
+/**
+ * compile time description of a control table register
+ * @tparam t_address the address of the register
+ * @tparam t_length the length of the register
+ */
+template<uint16_t t_address, uint16_t t_length>
+struct Dynamixel_Register {
+    static constexpr uint16_t address = t_address;
+    static constexpr uint16_t length = t_length;
+};
+
+/**
+ * the registers commonly used at runtime
+ */
+using Dynamixel_Torque = Dynamixel_Register<ADDR_TORQUE, 1>;
+using Dynamixel_Led = Dynamixel_Register<ADDR_LED, 1>;
+using Dynamixel_Hardware_Error_Status = Dynamixel_Register<ADDR_HARDWARE_ERROR_STATUS, 1>;
+using Dynamixel_Goal_Pwm = Dynamixel_Register<ADDR_GOAL_PWM, 2>;
+using Dynamixel_Goal_Velocity = Dynamixel_Register<ADDR_GOAL_VELOCITY, 4>;
+using Dynamixel_Goal_Position = Dynamixel_Register<ADDR_GOAL_POSITION, 4>;
+using Dynamixel_Realtime_Tick = Dynamixel_Register<ADDR_REALTIME_TICK, 2>;
+using Dynamixel_Present_Pwm = Dynamixel_Register<ADDR_PRESENT_PWM, 2>;
+using Dynamixel_Present_Load = Dynamixel_Register<ADDR_PRESENT_LOAD, 2>;
+using Dynamixel_Present_Velocity = Dynamixel_Register<ADDR_PRESENT_VELOCITY, 4>;
+using Dynamixel_Present_Position = Dynamixel_Register<ADDR_PRESENT_POSITION, 4>;
+using Dynamixel_Present_Input_Voltage = Dynamixel_Register<ADDR_PRESENT_INPUT_VOLTAGE, 2>;
+using Dynamixel_Present_Temperature = Dynamixel_Register<ADDR_PRESENT_TEMPERATURE, 1>;
+
+#endif
@@ -0,0 +1,297 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "dynamixel_audit.h"
+#include "dynamixel_scheduler.h"
+
+// golden ratio conjugate, spreads the first read of every register group over its period
+#define DXL_SCHEDULER_PHASE 0.6180339887498949
+
+/**
+ * poll a register group of a dynamixel at a target rate
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_address the first address of the register group
+ * @param t_length the length of the register group -> 1-64
+ * @param t_rate the target rate in hz
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Scheduler::set_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length, double t_rate) {
+    if (t_length == 0 || t_length > DXL_SCHEDULER_MAX_LEN || t_rate <= 0.0) {
+        printf("failed: invalid register group for id: %i\n", t_dxl_id);
+        return false;
+    }
+    set_remove(t_dxl_id, t_address);
+
+    Dynamixel_Schedule_Item dxl_item{};
+    dxl_item.id = t_dxl_id;
+    dxl_item.address = t_address;
+    dxl_item.length = t_length;
+    dxl_item.period = 1.0 / t_rate;
+    double dxl_phase = std::fmod(m_registrations++ * DXL_SCHEDULER_PHASE, 1.0);
+    dxl_item.next_due = Dynamixel_Clock::get_monotonic_time() + dxl_phase * dxl_item.period;
+    m_items.push_back(dxl_item);
+    m_set_reserve();
+    return true;
+}
+/**
+ * stop polling a register group of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_address the first address of the register group
+ */
+void Dynamixel_Scheduler::set_remove(uint8_t t_dxl_id, uint16_t t_address) {
+    m_items.erase(std::remove_if(m_items.begin(), m_items.end(), [&](const Dynamixel_Schedule_Item &t_item) {
+        return t_item.id == t_dxl_id && t_item.address == t_address;
+    }), m_items.end());
+}
+/**
+ * set the bus model used to estimate the cost of a read
+ * @param t_model the (calibrated) bus model
+ */
+void Dynamixel_Scheduler::set_model(const Dynamixel_Bus_Model &t_model) {
+    m_model = t_model;
+}
+/**
+ * read the due register groups which fit into the given time
+ * @param t_budget the spare time of this tick in seconds
+ * @return the amount of register groups which were read
+ */
+uint32_t Dynamixel_Scheduler::set_tick(double t_budget) {
+    Dynamixel_Tick_Guard dxl_guard("Dynamixel_Scheduler::set_tick");
+    double dxl_now = Dynamixel_Clock::get_monotonic_time();
+    m_due.clear();
+    for (size_t i = 0; i < m_items.size(); i++) {
+        if (m_items[i].next_due <= dxl_now && m_quarantine.get_admitted(m_items[i].id)) {
+            m_due.push_back(i);
+        }
+    }
+    // the most overdue register group (relative to its own period) goes first
+    std::sort(m_due.begin(), m_due.end(), [&](size_t t_lhs, size_t t_rhs) {
+        return (dxl_now - m_items[t_lhs].next_due) / m_items[t_lhs].period > (dxl_now - m_items[t_rhs].next_due) / m_items[t_rhs].period;
+    });
+
+    m_cost = 0.0;
+    uint32_t dxl_read = 0;
+    m_singles.clear();
+    std::fill(m_taken.begin(), m_taken.end(), 0);
+    for (size_t dxl_first = 0; dxl_first < m_due.size(); dxl_first++) {
+        if (m_taken[dxl_first]) {
+            continue;
+        }
+        // the group holds every due item with the same address range, in the order of the due list
+        const Dynamixel_Schedule_Item &dxl_item = m_items[m_due[dxl_first]];
+        m_group.clear();
+        for (size_t i = dxl_first; i < m_due.size(); i++) {
+            if (!m_taken[i] && m_items[m_due[i]].address == dxl_item.address && m_items[m_due[i]].length == dxl_item.length) {
+                m_taken[i] = 1;
+                m_group.push_back(m_due[i]);
+            }
+        }
+        if (m_group.size() < 2) {
+            m_singles.push_back(m_group.front());
+            continue;
+        }
+        m_packed.clear();
+        uint32_t dxl_length = dxl_item.length;
+        for (size_t dxl_index : m_group) {
+            uint32_t dxl_count = m_packed.size() + 1;
+            if (m_cost + m_get_cost(INST_SYNC_READ, dxl_count, dxl_count * dxl_length) > t_budget) {
+                break;
+            }
+            m_packed.push_back(dxl_index);
+        }
+        if (!m_packed.empty()) {
+            m_cost += m_get_cost(INST_SYNC_READ, m_packed.size(), m_packed.size() * dxl_length);
+            dxl_read += m_set_sync_read(m_packed, dxl_now);
+        }
+    }
+
+    // a bulk read can only hold one register group per dynamixel
+    m_packed.clear();
+    uint32_t dxl_data_length = 0;
+    for (size_t dxl_index : m_singles) {
+        bool dxl_duplicate = std::any_of(m_packed.begin(), m_packed.end(), [&](size_t t_index) {
+            return m_items[t_index].id == m_items[dxl_index].id;
+        });
+        uint32_t dxl_count = m_packed.size() + 1;
+        if (dxl_duplicate || m_cost + m_get_cost(INST_BULK_READ, dxl_count, dxl_data_length + m_items[dxl_index].length) > t_budget) {
+            continue;
+        }
+        m_packed.push_back(dxl_index);
+        dxl_data_length += m_items[dxl_index].length;
+    }
+    if (!m_packed.empty()) {
+        m_cost += m_get_cost(INST_BULK_READ, m_packed.size(), dxl_data_length);
+        dxl_read += m_set_bulk_read(m_packed, dxl_now);
+    }
+
+    // quarantined dynamixel's are pinged in the spare time, one per tick at most
+    double dxl_ping = m_get_cost(INST_PING, 1, 3);
+    if (m_quarantine.get_count() > 0 && m_cost + dxl_ping <= t_budget) {
+        m_cost += dxl_ping;
+        m_quarantine.set_recovery(m_dynamixel.get_port_handler(), 2.0 * dxl_ping);
+    }
+    return dxl_read;
+}
+/**
+ * get the latest value of a polled register
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_address the address of the register
+ * @param t_length the length of the register -> 1, 2 or 4
+ * @return the latest value and its age
+ */
+Dynamixel_Sample Dynamixel_Scheduler::get_value(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length) {
+    Dynamixel_Sample dxl_sample{0, 0.0, false};
+    for (const Dynamixel_Schedule_Item &dxl_item : m_items) {
+        if (dxl_item.id != t_dxl_id || t_address < dxl_item.address || t_address + t_length > dxl_item.address + dxl_item.length) {
+            continue;
+        }
+        const uint8_t *dxl_data = dxl_item.data.data() + (t_address - dxl_item.address);
+        for (uint16_t i = 0; i < t_length && i < 4; i++) {
+            dxl_sample.value |= (uint32_t)dxl_data[i] << (8 * i);
+        }
+        dxl_sample.age = Dynamixel_Clock::get_monotonic_time() - dxl_item.last_time;
+        dxl_sample.valid = dxl_item.valid;
+        break;
+    }
+    return dxl_sample;
+}
+/**
+ * get the estimated bus time of the last tick
+ * @return the bus time in seconds
+ */
+double Dynamixel_Scheduler::get_cost() {
+    return m_cost;
+}
+/**
+ * get the quarantine, dynamixel's which missed too many reads are only pinged until they recover
+ * @return the quarantine
+ */
+Dynamixel_Quarantine &Dynamixel_Scheduler::get_quarantine() {
+    return m_quarantine;
+}
+
+// MARK: - Private Functions
+/**
+ * estimate the bus time of a sync/bulk read
+ * @param t_instruction the instruction -> INST_SYNC_READ or INST_BULK_READ
+ * @param t_count the amount of dynamixel's
+ * @param t_data_length the sum of the read lengths
+ * @return the bus time in seconds
+ */
+double Dynamixel_Scheduler::m_get_cost(uint8_t t_instruction, uint32_t t_count, uint32_t t_data_length) {
+    return m_model.get_transaction_time({t_instruction, (uint16_t)t_count, (uint16_t)t_data_length});
+}
+/**
+ * read a set of register groups with the same address and length
+ * @param t_items the indices of the register groups
+ * @param t_now the host time of the tick
+ * @return the amount of register groups which were read
+ */
+uint32_t Dynamixel_Scheduler::m_set_sync_read(const std::vector<size_t> &t_items, double t_now) {
+    const Dynamixel_Schedule_Item &dxl_first = m_items[t_items.front()];
+    m_param.assign({DXL_LOBYTE(dxl_first.address), DXL_HIBYTE(dxl_first.address), DXL_LOBYTE(dxl_first.length), DXL_HIBYTE(dxl_first.length)});
+    for (size_t dxl_index : t_items) {
+        m_param.push_back(m_items[dxl_index].id);
+    }
+    return m_set_read(INST_SYNC_READ, m_param, t_items, t_now);
+}
+/**
+ * read a set of register groups of different dynamixel's
+ * @param t_items the indices of the register groups
+ * @param t_now the host time of the tick
+ * @return the amount of register groups which were read
+ */
+uint32_t Dynamixel_Scheduler::m_set_bulk_read(const std::vector<size_t> &t_items, double t_now) {
+    m_param.clear();
+    for (size_t dxl_index : t_items) {
+        const Dynamixel_Schedule_Item &dxl_item = m_items[dxl_index];
+        m_param.insert(m_param.end(), {dxl_item.id, DXL_LOBYTE(dxl_item.address), DXL_HIBYTE(dxl_item.address), DXL_LOBYTE(dxl_item.length), DXL_HIBYTE(dxl_item.length)});
+    }
+    return m_set_read(INST_BULK_READ, m_param, t_items, t_now);
+}
+/**
+ * send a sync/bulk read and store every status which arrives
+ * @param t_instruction the instruction -> INST_SYNC_READ or INST_BULK_READ
+ * @param t_param the parameters of the read
+ * @param t_items the indices of the register groups, at most one per dynamixel
+ * @param t_now the host time of the tick
+ * @return the amount of register groups which were read
+ */
+uint32_t Dynamixel_Scheduler::m_set_read(uint8_t t_instruction, const std::vector<uint8_t> &t_param, const std::vector<size_t> &t_items, double t_now) {
+    dynamixel::PortHandler *dxl_port = m_dynamixel.get_port_handler();
+    m_packet.resize(DXL_INSTRUCTION_FRAME_LEN + t_param.size() + t_param.size() / 3);
+    size_t dxl_packet_length = Dynamixel_Packet::set_instruction(m_packet.data(), m_packet.size(), BROADCAST_ID, t_instruction, t_param.data(), t_param.size());
+    int t_dxl_result = Dynamixel_Packet::set_transmit(dxl_port, m_packet.data(), dxl_packet_length);
+    if (t_dxl_result != COMM_SUCCESS) {
+        printf("%s", m_dynamixel.get_packet_handler()->getTxRxResult(t_dxl_result));
+        return 0;
+    }
+    uint32_t dxl_data_length = 0;
+    for (size_t dxl_index : t_items) {
+        dxl_data_length += m_items[dxl_index].length;
+    }
+    double dxl_deadline = Dynamixel_Clock::get_monotonic_time() + 2.0 * m_get_cost(t_instruction, t_items.size(), dxl_data_length);
+
+    // the statuses which arrived are kept, even if one in between is missing
+    uint32_t dxl_read = 0;
+    m_receiver.set_clear();
+    for (size_t i = 0; i < t_items.size(); i++) {
+        Dynamixel_Status dxl_status{};
+        if (m_receiver.get_status(dxl_port, dxl_deadline, dxl_status) != COMM_SUCCESS) {
+            break;
+        }
+        for (size_t dxl_index : t_items) {
+            Dynamixel_Schedule_Item &dxl_item = m_items[dxl_index];
+            if (dxl_item.id != dxl_status.id || dxl_item.last_time >= t_now) {
+                continue;
+            }
+            std::memcpy(dxl_item.data.data(), dxl_status.param, std::min<size_t>(dxl_status.length, dxl_item.length));
+            dxl_item.last_time = Dynamixel_Clock::get_monotonic_time();
+            dxl_item.valid = true;
+            // keep the phase of the register group, but never try to catch up missed periods in a burst
+            dxl_item.next_due = std::max(dxl_item.next_due + dxl_item.period, t_now + 0.5 * dxl_item.period);
+            dxl_read++;
+            break;
+        }
+    }
+    for (size_t dxl_index : t_items) {
+        const Dynamixel_Schedule_Item &dxl_item = m_items[dxl_index];
+        if (dxl_item.last_time < t_now) {
+            printf("failed: no status for id: %i\n", dxl_item.id);
+        }
+        m_quarantine.set_result(dxl_item.id, dxl_item.last_time >= t_now);
+    }
+    return dxl_read;
+}
+/**
+ * size the scratch buffers of a tick for the registered groups, a tick only reuses them
+ */
+void Dynamixel_Scheduler::m_set_reserve() {
+    size_t dxl_count = m_items.size();
+    m_due.reserve(dxl_count);
+    m_taken.resize(dxl_count);
+    m_group.reserve(dxl_count);
+    m_singles.reserve(dxl_count);
+    m_packed.reserve(dxl_count);
+    m_param.reserve(4 + 5 * dxl_count);
+    m_packet.reserve(DXL_INSTRUCTION_FRAME_LEN + m_param.capacity() + m_param.capacity() / 3);
+}
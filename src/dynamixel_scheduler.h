@@ -0,0 +1,218 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_SCHEDULER_H
+#define DYNAMIXEL_DYNAMIXEL_SCHEDULER_H
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include "dynamixel.h"
+#include "dynamixel_bus_model.h"
+#include "dynamixel_packet.h"
+#include "dynamixel_quarantine.h"
+
+#define DXL_SCHEDULER_MAX_LEN 64
+
+/**
+ * the latest polled value of a register
+ */
+struct Dynamixel_Sample {
+    /**
+     * the value which was read
+     */
+    uint32_t value;
+    /**
+     * the age of the value in seconds
+     */
+    double age;
+    /**
+     * false if the register was never read
+     */
+    bool valid;
+};
+
+/**
+ * polls every (dynamixel, register group) at its own rate and packs the due
+ * reads into sync/bulk reads which fit into the spare time of a control tick
+ */
+class Dynamixel_Scheduler {
+// public declaration
+public:
+    /**
+     * initialize the scheduler
+     * @param t_dynamixel the dynamixel bus to poll
+     */
+    explicit Dynamixel_Scheduler(Dynamixel &t_dynamixel):
+            m_dynamixel(t_dynamixel) {
+    };
+    /**
+     * poll a register group of a dynamixel at a target rate
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the first address of the register group
+     * @param t_length the length of the register group -> 1-64
+     * @param t_rate the target rate in hz
+     * @return true if success otherwise false
+     */
+    bool set_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length, double t_rate);
+    /**
+     * stop polling a register group of a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the first address of the register group
+     */
+    void set_remove(uint8_t t_dxl_id, uint16_t t_address);
+    /**
+     * set the bus model used to estimate the cost of a read
+     * @param t_model the (calibrated) bus model
+     */
+    void set_model(const Dynamixel_Bus_Model &t_model);
+    /**
+     * read the due register groups which fit into the given time
+     * @param t_budget the spare time of this tick in seconds
+     * @return the amount of register groups which were read
+     */
+    uint32_t set_tick(double t_budget);
+    /**
+     * get the latest value of a polled register
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the address of the register
+     * @param t_length the length of the register -> 1, 2 or 4
+     * @return the latest value and its age
+     */
+    Dynamixel_Sample get_value(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length);
+    /**
+     * get the estimated bus time of the last tick
+     * @return the bus time in seconds
+     */
+    double get_cost();
+    /**
+     * get the quarantine, dynamixel's which missed too many reads are only pinged until they recover
+     * @return the quarantine
+     */
+    Dynamixel_Quarantine &get_quarantine();
+
+// private declaration
+private:
+    /**
+     * a polled register group
+     */
+    struct Dynamixel_Schedule_Item {
+        uint8_t id;
+        uint16_t address;
+        uint16_t length;
+        double period;
+        double next_due;
+        double last_time;
+        bool valid;
+        std::array<uint8_t, DXL_SCHEDULER_MAX_LEN> data;
+    };
+    /**
+     * the dynamixel bus to poll
+     */
+    Dynamixel &m_dynamixel;
+    /**
+     * the polled register groups
+     */
+    std::vector<Dynamixel_Schedule_Item> m_items;
+    /**
+     * the bus model used to estimate the cost of a read
+     */
+    Dynamixel_Bus_Model m_model = Dynamixel_Bus_Model(m_dynamixel.get_baud_rate());
+    /**
+     * the estimated bus time of the last tick
+     */
+    double m_cost = 0.0;
+    /**
+     * the amount of registrations used to spread the first reads
+     */
+    uint32_t m_registrations = 0;
+    /**
+     * the indices of the due register groups of a tick, reused every tick
+     */
+    std::vector<size_t> m_due;
+    /**
+     * true for every due register group which is already grouped, reused every tick
+     */
+    std::vector<uint8_t> m_taken;
+    /**
+     * the indices of a group with the same address range, reused every tick
+     */
+    std::vector<size_t> m_group;
+    /**
+     * the indices of the register groups which are left for a bulk read, reused every tick
+     */
+    std::vector<size_t> m_singles;
+    /**
+     * the indices of the register groups of a read packet, reused every tick
+     */
+    std::vector<size_t> m_packed;
+    /**
+     * the parameters of a read packet, reused every tick
+     */
+    std::vector<uint8_t> m_param;
+    /**
+     * the encoded read packet, reused every tick
+     */
+    std::vector<uint8_t> m_packet;
+    /**
+     * the receiver of the status packets
+     */
+    Dynamixel_Receiver m_receiver;
+    /**
+     * the dynamixel's which are left out of the reads
+     */
+    Dynamixel_Quarantine m_quarantine;
+    /**
+     * estimate the bus time of a sync/bulk read
+     * @param t_instruction the instruction -> INST_SYNC_READ or INST_BULK_READ
+     * @param t_count the amount of dynamixel's
+     * @param t_data_length the sum of the read lengths
+     * @return the bus time in seconds
+     */
+    double m_get_cost(uint8_t t_instruction, uint32_t t_count, uint32_t t_data_length);
+    /**
+     * read a set of register groups with the same address and length
+     * @param t_items the indices of the register groups
+     * @param t_now the host time of the tick
+     * @return the amount of register groups which were read
+     */
+    uint32_t m_set_sync_read(const std::vector<size_t> &t_items, double t_now);
+    /**
+     * read a set of register groups of different dynamixel's
+     * @param t_items the indices of the register groups
+     * @param t_now the host time of the tick
+     * @return the amount of register groups which were read
+     */
+    uint32_t m_set_bulk_read(const std::vector<size_t> &t_items, double t_now);
+    /**
+     * send a sync/bulk read and store every status which arrives
+     * @param t_instruction the instruction -> INST_SYNC_READ or INST_BULK_READ
+     * @param t_param the parameters of the read
+     * @param t_items the indices of the register groups, at most one per dynamixel
+     * @param t_now the host time of the tick
+     * @return the amount of register groups which were read
+     */
+    uint32_t m_set_read(uint8_t t_instruction, const std::vector<uint8_t> &t_param, const std::vector<size_t> &t_items, double t_now);
+    /**
+     * size the scratch buffers of a tick for the registered groups, a tick only reuses them
+     */
+    void m_set_reserve();
+};
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "dynamixel_audit.h"
+#include "dynamixel_clock.h"
+#include "dynamixel_shared_state.h"
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock needs a lock free 64 bit atomic");
+
+/**
+ * initialize the publisher
+ * @param t_name the name of the segment, e.g. "/dynamixel_state"
+ * @param t_dxl_ids the identifiers of the dynamixel's, same order as in the state store
+ */
+Dynamixel_State_Publisher::Dynamixel_State_Publisher(const char* t_name, const std::vector<uint8_t> &t_dxl_ids):
+        m_name(t_name),
+        m_dxl_ids(t_dxl_ids),
+        m_stride((uint32_t)((t_dxl_ids.size() + DXL_SHARED_LANES - 1) / DXL_SHARED_LANES * DXL_SHARED_LANES)),
+        m_size(sizeof(Dynamixel_Shared_Header) + m_stride * sizeof(float) * (1 + DXL_QUANTITY_COUNT)) {
+}
+/**
+ * close the segment
+ */
+Dynamixel_State_Publisher::~Dynamixel_State_Publisher() {
+    set_close();
+}
+/**
+ * create and map the segment
+ * @return true if success otherwise false
+ */
+bool Dynamixel_State_Publisher::set_open() {
+    if (m_header != nullptr) {
+        return true;
+    }
+    int dxl_fd = shm_open(m_name, O_CREAT | O_RDWR, 0644);
+    if (dxl_fd < 0) {
+        printf("failed: create shared memory %s\n", m_name);
+        return false;
+    }
+    if (ftruncate(dxl_fd, (off_t)m_size) != 0) {
+        printf("failed: resize shared memory %s\n", m_name);
+        close(dxl_fd);
+        return false;
+    }
+    void *dxl_memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, dxl_fd, 0);
+    close(dxl_fd);
+    if (dxl_memory == MAP_FAILED) {
+        printf("failed: map shared memory %s\n", m_name);
+        return false;
+    }
+    m_header = (Dynamixel_Shared_Header*)dxl_memory;
+    // readers only accept the segment once the magic is set
+    m_header->magic.store(0, std::memory_order_relaxed);
+    m_header->count = (uint32_t)m_dxl_ids.size();
+    m_header->stride = m_stride;
+    m_header->sequence.store(0, std::memory_order_relaxed);
+    m_header->tick = 0;
+    m_header->time = 0.0;
+    uint8_t *dxl_data = (uint8_t*)(m_header + 1);
+    memset(dxl_data, 0, m_size - sizeof(Dynamixel_Shared_Header));
+    memcpy(dxl_data, m_dxl_ids.data(), m_dxl_ids.size());
+    m_header->magic.store(DXL_SHARED_MAGIC, std::memory_order_release);
+    return true;
+}
+/**
+ * mark the segment as closed, unmap and remove it
+ */
+void Dynamixel_State_Publisher::set_close() {
+    if (m_header == nullptr) {
+        return;
+    }
+    m_header->magic.store(0, std::memory_order_release);
+    munmap(m_header, m_size);
+    shm_unlink(m_name);
+    m_header = nullptr;
+}
+/**
+ * publish a snapshot of the state store, doesn't make a syscall
+ * @param t_store the state store, same dynamixel's as the publisher
+ * @return true if success otherwise false
+ */
+bool Dynamixel_State_Publisher::set_publish(Dynamixel_State_Store &t_store) {
+    Dynamixel_Tick_Guard dxl_guard("Dynamixel_State_Publisher::set_publish");
+    if (m_header == nullptr) {
+        printf("failed: shared memory %s not open\n", m_name);
+        return false;
+    }
+    if (t_store.get_count() != m_dxl_ids.size()) {
+        printf("failed: state store doesn't match the publisher\n");
+        return false;
+    }
+    uint64_t dxl_sequence = m_header->sequence.load(std::memory_order_relaxed);
+    m_header->sequence.store(dxl_sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->tick = ++m_tick;
+    m_header->time = Dynamixel_Clock::get_monotonic_time();
+    float *dxl_arrays = (float*)((uint8_t*)(m_header + 1) + m_stride * sizeof(float));
+    for (int i = 0; i < DXL_QUANTITY_COUNT; i++) {
+        memcpy(dxl_arrays + i * m_stride, t_store.get_si((Dynamixel_Quantity)i), m_dxl_ids.size() * sizeof(float));
+    }
+    m_header->sequence.store(dxl_sequence + 2, std::memory_order_release);
+    return true;
+}
+/**
+ * get the amount of published snapshots
+ * @return the amount of snapshots
+ */
+uint64_t Dynamixel_State_Publisher::get_tick() {
+    return m_tick;
+}
+
+/**
+ * unmap the segment
+ */
+Dynamixel_State_Reader::~Dynamixel_State_Reader() {
+    set_close();
+}
+/**
+ * map the segment of a running publisher
+ * @return true if success otherwise false
+ */
+bool Dynamixel_State_Reader::set_open() {
+    if (m_header != nullptr) {
+        return true;
+    }
+    int dxl_fd = shm_open(m_name, O_RDONLY, 0);
+    if (dxl_fd < 0) {
+        printf("failed: open shared memory %s\n", m_name);
+        return false;
+    }
+    struct stat dxl_stat = {};
+    if (fstat(dxl_fd, &dxl_stat) != 0 || (size_t)dxl_stat.st_size < sizeof(Dynamixel_Shared_Header)) {
+        printf("failed: shared memory %s is not initialized\n", m_name);
+        close(dxl_fd);
+        return false;
+    }
+    m_size = (size_t)dxl_stat.st_size;
+    void *dxl_memory = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, dxl_fd, 0);
+    close(dxl_fd);
+    if (dxl_memory == MAP_FAILED) {
+        printf("failed: map shared memory %s\n", m_name);
+        return false;
+    }
+    m_header = (const Dynamixel_Shared_Header*)dxl_memory;
+    if (m_header->magic.load(std::memory_order_acquire) != DXL_SHARED_MAGIC || sizeof(Dynamixel_Shared_Header) + m_header->stride * sizeof(float) * (1 + DXL_QUANTITY_COUNT) > m_size) {
+        printf("failed: shared memory %s is not initialized\n", m_name);
+        set_close();
+        return false;
+    }
+    m_stride = m_header->stride;
+    const uint8_t *dxl_ids = (const uint8_t*)(m_header + 1);
+    m_dxl_ids.assign(dxl_ids, dxl_ids + m_header->count);
+    m_si.assign((size_t)m_stride * DXL_QUANTITY_COUNT, 0.0f);
+    m_tick = 0;
+    return true;
+}
+/**
+ * unmap the segment
+ */
+void Dynamixel_State_Reader::set_close() {
+    if (m_header == nullptr) {
+        return;
+    }
+    munmap((Dynamixel_Shared_Header*)m_header, m_size);
+    m_header = nullptr;
+}
+/**
+ * copy the latest consistent snapshot, gives up after DXL_SHARED_TIMEOUT seconds of torn attempts
+ * (e.g. a publisher which died while writing)
+ * @return true if a new snapshot was copied otherwise false
+ */
+bool Dynamixel_State_Reader::set_update() {
+    if (m_header == nullptr || m_header->magic.load(std::memory_order_acquire) != DXL_SHARED_MAGIC) {
+        return false;
+    }
+    const float *dxl_arrays = (const float*)((const uint8_t*)(m_header + 1) + m_stride * sizeof(float));
+    double dxl_deadline = Dynamixel_Clock::get_monotonic_time() + DXL_SHARED_TIMEOUT;
+    while (Dynamixel_Clock::get_monotonic_time() < dxl_deadline) {
+        uint64_t dxl_sequence = m_header->sequence.load(std::memory_order_acquire);
+        if (dxl_sequence & 1) {
+            continue;
+        }
+        uint64_t dxl_tick = m_header->tick;
+        if (dxl_tick == m_tick) {
+            return false;
+        }
+        double dxl_time = m_header->time;
+        memcpy(m_si.data(), dxl_arrays, m_si.size() * sizeof(float));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // the publisher wrote in between, the copy may be torn
+        if (m_header->sequence.load(std::memory_order_relaxed) != dxl_sequence) {
+            continue;
+        }
+        m_tick = dxl_tick;
+        m_time = dxl_time;
+        return true;
+    }
+    printf("failed: no consistent snapshot within %f s\n", DXL_SHARED_TIMEOUT);
+    return false;
+}
+/**
+ * get the amount of dynamixel's
+ * @return the amount
+ */
+size_t Dynamixel_State_Reader::get_count() {
+    return m_dxl_ids.size();
+}
+/**
+ * get the index of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the index or get_count() if unknown
+ */
+size_t Dynamixel_State_Reader::get_index(uint8_t t_dxl_id) {
+    for (size_t i = 0; i < m_dxl_ids.size(); i++) {
+        if (m_dxl_ids[i] == t_dxl_id) {
+            return i;
+        }
+    }
+    return m_dxl_ids.size();
+}
+/**
+ * get the si array of a quantity from the last snapshot
+ * @param t_quantity the quantity
+ * @return the array
+ */
+const float *Dynamixel_State_Reader::get_si(Dynamixel_Quantity t_quantity) {
+    return m_si.data() + (size_t)t_quantity * m_stride;
+}
+/**
+ * get the tick of the last snapshot
+ * @return the tick
+ */
+uint64_t Dynamixel_State_Reader::get_tick() {
+    return m_tick;
+}
+/**
+ * get the monotonic host time of the last snapshot
+ * @return the time in seconds
+ */
+double Dynamixel_State_Reader::get_time() {
+    return m_time;
+}
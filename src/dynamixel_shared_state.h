@@ -0,0 +1,228 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_SHARED_STATE_H
+#define DYNAMIXEL_DYNAMIXEL_SHARED_STATE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
+#include "dynamixel_state_store.h"
+
+#define DXL_SHARED_MAGIC 0x31304D48534C5844ULL
+#define DXL_SHARED_LANES 16
+#define DXL_SHARED_TIMEOUT 0.01
+
+/**
+ * the header of a shared state segment, followed by the identifiers and one si array per quantity,
+ * each padded to stride floats
+ * sequence is a seqlock: odd while the publisher writes, readers retry until it is even and unchanged
+ */
+struct Dynamixel_Shared_Header {
+    /**
+     * DXL_SHARED_MAGIC once the segment is initialized, 0 after the publisher closed it
+     */
+    std::atomic<uint64_t> magic;
+    /**
+     * the amount of dynamixel's
+     */
+    uint32_t count;
+    /**
+     * the stride of the arrays in values (count padded to a cache line)
+     */
+    uint32_t stride;
+    /**
+     * the seqlock counter, on its own cache line
+     */
+    alignas(DXL_STORE_ALIGNMENT) std::atomic<uint64_t> sequence;
+    /**
+     * the tick of the snapshot
+     */
+    uint64_t tick;
+    /**
+     * the monotonic host time of the snapshot in seconds
+     */
+    double time;
+};
+
+/**
+ * publishes the si state of every tick into a posix shared memory segment,
+ * any number of local processes can read it with Dynamixel_State_Reader
+ */
+class Dynamixel_State_Publisher {
+// public declaration
+public:
+    /**
+     * initialize the publisher
+     * @param t_name the name of the segment, e.g. "/dynamixel_state"
+     * @param t_dxl_ids the identifiers of the dynamixel's, same order as in the state store
+     */
+    Dynamixel_State_Publisher(const char* t_name, const std::vector<uint8_t> &t_dxl_ids);
+    /**
+     * close the segment
+     */
+    ~Dynamixel_State_Publisher();
+    /**
+     * create and map the segment
+     * @return true if success otherwise false
+     */
+    bool set_open();
+    /**
+     * mark the segment as closed, unmap and remove it
+     */
+    void set_close();
+    /**
+     * publish a snapshot of the state store, doesn't make a syscall
+     * @param t_store the state store, same dynamixel's as the publisher
+     * @return true if success otherwise false
+     */
+    bool set_publish(Dynamixel_State_Store &t_store);
+    /**
+     * get the amount of published snapshots
+     * @return the amount of snapshots
+     */
+    uint64_t get_tick();
+
+// private declaration
+private:
+    /**
+     * the name of the segment
+     */
+    const char* m_name;
+    /**
+     * the identifiers of the dynamixel's
+     */
+    std::vector<uint8_t> m_dxl_ids;
+    /**
+     * the stride of the arrays in values
+     */
+    uint32_t m_stride;
+    /**
+     * the size of the segment in bytes
+     */
+    size_t m_size;
+    /**
+     * the mapped segment
+     */
+    Dynamixel_Shared_Header *m_header = nullptr;
+    /**
+     * the amount of published snapshots
+     */
+    uint64_t m_tick = 0;
+};
+
+/**
+ * reads consistent snapshots from a segment of a Dynamixel_State_Publisher
+ * without syscalls and without bus traffic
+ */
+class Dynamixel_State_Reader {
+// public declaration
+public:
+    /**
+     * initialize the reader
+     * @param t_name the name of the segment, e.g. "/dynamixel_state"
+     */
+    explicit Dynamixel_State_Reader(const char* t_name):
+            m_name(t_name) {
+    };
+    /**
+     * unmap the segment
+     */
+    ~Dynamixel_State_Reader();
+    /**
+     * map the segment of a running publisher
+     * @return true if success otherwise false
+     */
+    bool set_open();
+    /**
+     * unmap the segment
+     */
+    void set_close();
+    /**
+     * copy the latest consistent snapshot, gives up after DXL_SHARED_TIMEOUT seconds of torn attempts
+     * (e.g. a publisher which died while writing)
+     * @return true if a new snapshot was copied otherwise false
+     */
+    bool set_update();
+    /**
+     * get the amount of dynamixel's
+     * @return the amount
+     */
+    size_t get_count();
+    /**
+     * get the index of a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return the index or get_count() if unknown
+     */
+    size_t get_index(uint8_t t_dxl_id);
+    /**
+     * get the si array of a quantity from the last snapshot
+     * @param t_quantity the quantity
+     * @return the array
+     */
+    const float *get_si(Dynamixel_Quantity t_quantity);
+    /**
+     * get the tick of the last snapshot
+     * @return the tick
+     */
+    uint64_t get_tick();
+    /**
+     * get the monotonic host time of the last snapshot
+     * @return the time in seconds
+     */
+    double get_time();
+
+// private declaration
+private:
+    /**
+     * the name of the segment
+     */
+    const char* m_name;
+    /**
+     * the size of the segment in bytes
+     */
+    size_t m_size = 0;
+    /**
+     * the mapped segment
+     */
+    const Dynamixel_Shared_Header *m_header = nullptr;
+    /**
+     * the identifiers of the dynamixel's
+     */
+    std::vector<uint8_t> m_dxl_ids;
+    /**
+     * the si arrays of the last snapshot, one stride per quantity
+     */
+    std::vector<float> m_si;
+    /**
+     * the stride of the arrays in values
+     */
+    uint32_t m_stride = 0;
+    /**
+     * the tick of the last snapshot
+     */
+    uint64_t m_tick = 0;
+    /**
+     * the monotonic host time of the last snapshot
+     */
+    double m_time = 0.0;
+};
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "dynamixel_audit.h"
+#include "dynamixel_state_store.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// 4096 ticks per revolution, 0.229 rev/min per velocity unit, 0.1 % per load unit
+#define DXL_POSITION_CENTER 2048
+#define DXL_POSITION_SCALE (2.0f * (float)M_PI / 4096.0f)
+#define DXL_VELOCITY_SCALE (0.229f * 2.0f * (float)M_PI / 60.0f)
+#define DXL_LOAD_SCALE 0.1f
+
+/**
+ * initialize the state store
+ * @param t_dxl_ids the identifiers of the dynamixel's, the index in this list is the index in every array
+ */
+Dynamixel_State_Store::Dynamixel_State_Store(const std::vector<uint8_t> &t_dxl_ids):
+        m_dxl_ids(t_dxl_ids) {
+    // pad to full simd lanes so the kernels never need a masked tail
+    size_t dxl_capacity = (t_dxl_ids.size() + DXL_STORE_LANES - 1) / DXL_STORE_LANES * DXL_STORE_LANES;
+    for (int i = 0; i < DXL_QUANTITY_COUNT; i++) {
+        m_raw[i].assign(dxl_capacity, 0);
+        m_si[i].assign(dxl_capacity, 0.0f);
+    }
+    for (size_t i = 0; i < dxl_capacity; i++) {
+        m_raw[DXL_QUANTITY_POSITION][i] = DXL_POSITION_CENTER;
+        m_raw[DXL_QUANTITY_GOAL_POSITION][i] = DXL_POSITION_CENTER;
+    }
+}
+/**
+ * get the amount of dynamixel's
+ * @return the amount
+ */
+size_t Dynamixel_State_Store::get_count() {
+    return m_dxl_ids.size();
+}
+/**
+ * get the index of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the index or get_count() if unknown
+ */
+size_t Dynamixel_State_Store::get_index(uint8_t t_dxl_id) {
+    return std::find(m_dxl_ids.begin(), m_dxl_ids.end(), t_dxl_id) - m_dxl_ids.begin();
+}
+/**
+ * read a quantity straight from the read buffer of a plan
+ * @param t_plan the plan, must outlive the store
+ * @param t_quantity the quantity -> position, velocity or load
+ * @param t_index the index of the dynamixel
+ * @param t_read the read handle of the plan
+ */
+void Dynamixel_State_Store::set_source(Dynamixel_Plan &t_plan, Dynamixel_Quantity t_quantity, size_t t_index, size_t t_read) {
+    if (t_quantity > DXL_QUANTITY_LOAD || t_index >= m_dxl_ids.size()) {
+        printf("failed: invalid source for index: %zu\n", t_index);
+        return;
+    }
+    m_bindings[t_quantity].push_back({&t_plan, t_index, t_read});
+}
+/**
+ * write a goal straight into the write buffer of a plan
+ * @param t_plan the plan, must outlive the store
+ * @param t_quantity the quantity -> goal position or goal velocity
+ * @param t_index the index of the dynamixel
+ * @param t_write the write handle of the plan
+ */
+void Dynamixel_State_Store::set_target(Dynamixel_Plan &t_plan, Dynamixel_Quantity t_quantity, size_t t_index, size_t t_write) {
+    if (t_quantity < DXL_QUANTITY_GOAL_POSITION || t_quantity >= DXL_QUANTITY_COUNT || t_index >= m_dxl_ids.size()) {
+        printf("failed: invalid target for index: %zu\n", t_index);
+        return;
+    }
+    m_bindings[t_quantity].push_back({&t_plan, t_index, t_write});
+}
+/**
+ * decode the sources into the raw arrays and convert them to si units
+ */
+void Dynamixel_State_Store::set_update() {
+    Dynamixel_Tick_Guard dxl_guard("Dynamixel_State_Store::set_update");
+    for (int dxl_quantity = DXL_QUANTITY_POSITION; dxl_quantity <= DXL_QUANTITY_LOAD; dxl_quantity++) {
+        int32_t *dxl_raw = m_raw[dxl_quantity].data();
+        for (const Dynamixel_Binding &dxl_binding : m_bindings[dxl_quantity]) {
+            if (!dxl_binding.plan->get_valid(dxl_binding.handle)) {
+                continue;
+            }
+            const uint8_t *dxl_data = dxl_binding.plan->get_data(dxl_binding.handle);
+            if (dxl_quantity == DXL_QUANTITY_LOAD) {
+                dxl_raw[dxl_binding.index] = (int16_t)DXL_MAKEWORD(dxl_data[0], dxl_data[1]);
+            } else {
+                dxl_raw[dxl_binding.index] = (int32_t)DXL_MAKEDWORD(DXL_MAKEWORD(dxl_data[0], dxl_data[1]), DXL_MAKEWORD(dxl_data[2], dxl_data[3]));
+            }
+        }
+    }
+    size_t dxl_count = m_raw[0].size();
+    m_set_si(m_raw[DXL_QUANTITY_POSITION].data(), m_si[DXL_QUANTITY_POSITION].data(), dxl_count, DXL_POSITION_CENTER, DXL_POSITION_SCALE);
+    m_set_si(m_raw[DXL_QUANTITY_VELOCITY].data(), m_si[DXL_QUANTITY_VELOCITY].data(), dxl_count, 0, DXL_VELOCITY_SCALE);
+    m_set_si(m_raw[DXL_QUANTITY_LOAD].data(), m_si[DXL_QUANTITY_LOAD].data(), dxl_count, 0, DXL_LOAD_SCALE);
+}
+/**
+ * convert the si goals to raw and write them into the targets
+ */
+void Dynamixel_State_Store::set_commit() {
+    Dynamixel_Tick_Guard dxl_guard("Dynamixel_State_Store::set_commit");
+    size_t dxl_count = m_raw[0].size();
+    m_set_raw(m_si[DXL_QUANTITY_GOAL_POSITION].data(), m_raw[DXL_QUANTITY_GOAL_POSITION].data(), dxl_count, 1.0f / DXL_POSITION_SCALE, DXL_POSITION_CENTER);
+    m_set_raw(m_si[DXL_QUANTITY_GOAL_VELOCITY].data(), m_raw[DXL_QUANTITY_GOAL_VELOCITY].data(), dxl_count, 1.0f / DXL_VELOCITY_SCALE, 0);
+    for (int dxl_quantity = DXL_QUANTITY_GOAL_POSITION; dxl_quantity < DXL_QUANTITY_COUNT; dxl_quantity++) {
+        const int32_t *dxl_raw = m_raw[dxl_quantity].data();
+        for (const Dynamixel_Binding &dxl_binding : m_bindings[dxl_quantity]) {
+            dxl_binding.plan->set_value(dxl_binding.handle, (uint32_t)dxl_raw[dxl_binding.index]);
+        }
+    }
+}
+/**
+ * get the si array of a quantity
+ * @param t_quantity the quantity
+ * @return the cache line aligned array
+ */
+float *Dynamixel_State_Store::get_si(Dynamixel_Quantity t_quantity) {
+    return m_si[t_quantity].data();
+}
+/**
+ * get the raw array of a quantity
+ * @param t_quantity the quantity
+ * @return the cache line aligned array
+ */
+int32_t *Dynamixel_State_Store::get_raw(Dynamixel_Quantity t_quantity) {
+    return m_raw[t_quantity].data();
+}
+
+// MARK: - Private Functions
+/**
+ * convert raw values to si units: out = (in - offset) * scale
+ * @param t_in the raw values
+ * @param t_out the si values
+ * @param t_count the amount of values
+ * @param t_offset the raw offset
+ * @param t_scale the scale
+ */
+void Dynamixel_State_Store::m_set_si(const int32_t *t_in, float *t_out, size_t t_count, int32_t t_offset, float t_scale) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i dxl_offset = _mm256_set1_epi32(t_offset);
+    __m256 dxl_scale = _mm256_set1_ps(t_scale);
+    for (; i + 8 <= t_count; i += 8) {
+        __m256i dxl_raw = _mm256_sub_epi32(_mm256_load_si256((const __m256i*)(t_in + i)), dxl_offset);
+        _mm256_store_ps(t_out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(dxl_raw), dxl_scale));
+    }
+#elif defined(__SSE2__)
+    __m128i dxl_offset = _mm_set1_epi32(t_offset);
+    __m128 dxl_scale = _mm_set1_ps(t_scale);
+    for (; i + 4 <= t_count; i += 4) {
+        __m128i dxl_raw = _mm_sub_epi32(_mm_load_si128((const __m128i*)(t_in + i)), dxl_offset);
+        _mm_store_ps(t_out + i, _mm_mul_ps(_mm_cvtepi32_ps(dxl_raw), dxl_scale));
+    }
+#elif defined(__ARM_NEON)
+    int32x4_t dxl_offset = vdupq_n_s32(t_offset);
+    for (; i + 4 <= t_count; i += 4) {
+        int32x4_t dxl_raw = vsubq_s32(vld1q_s32(t_in + i), dxl_offset);
+        vst1q_f32(t_out + i, vmulq_n_f32(vcvtq_f32_s32(dxl_raw), t_scale));
+    }
+#endif
+    for (; i < t_count; i++) {
+        t_out[i] = (float)(t_in[i] - t_offset) * t_scale;
+    }
+}
+/**
+ * convert si units to raw values: out = round(in * scale) + offset
+ * @param t_in the si values
+ * @param t_out the raw values
+ * @param t_count the amount of values
+ * @param t_scale the scale
+ * @param t_offset the raw offset
+ */
+void Dynamixel_State_Store::m_set_raw(const float *t_in, int32_t *t_out, size_t t_count, float t_scale, int32_t t_offset) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i dxl_offset = _mm256_set1_epi32(t_offset);
+    __m256 dxl_scale = _mm256_set1_ps(t_scale);
+    for (; i + 8 <= t_count; i += 8) {
+        __m256i dxl_raw = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_load_ps(t_in + i), dxl_scale));
+        _mm256_store_si256((__m256i*)(t_out + i), _mm256_add_epi32(dxl_raw, dxl_offset));
+    }
+#elif defined(__SSE2__)
+    __m128i dxl_offset = _mm_set1_epi32(t_offset);
+    __m128 dxl_scale = _mm_set1_ps(t_scale);
+    for (; i + 4 <= t_count; i += 4) {
+        __m128i dxl_raw = _mm_cvtps_epi32(_mm_mul_ps(_mm_load_ps(t_in + i), dxl_scale));
+        _mm_store_si128((__m128i*)(t_out + i), _mm_add_epi32(dxl_raw, dxl_offset));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    int32x4_t dxl_offset = vdupq_n_s32(t_offset);
+    for (; i + 4 <= t_count; i += 4) {
+        int32x4_t dxl_raw = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(t_in + i), t_scale));
+        vst1q_s32(t_out + i, vaddq_s32(dxl_raw, dxl_offset));
+    }
+#endif
+    for (; i < t_count; i++) {
+        t_out[i] = (int32_t)std::lrintf(t_in[i] * t_scale) + t_offset;
+    }
+}
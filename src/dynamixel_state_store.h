@@ -0,0 +1,175 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_STATE_STORE_H
+#define DYNAMIXEL_DYNAMIXEL_STATE_STORE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include "dynamixel_transaction.h"
+
+#define DXL_STORE_ALIGNMENT 64
+#define DXL_STORE_LANES 8
+
+/**
+ * allocates cache line aligned storage for the state arrays
+ */
+template<typename T>
+struct Dynamixel_Aligned_Allocator {
+    using value_type = T;
+    Dynamixel_Aligned_Allocator() = default;
+    template<typename U>
+    Dynamixel_Aligned_Allocator(const Dynamixel_Aligned_Allocator<U> &) noexcept {
+    };
+    T *allocate(size_t t_count) {
+        return (T*)::operator new(t_count * sizeof(T), std::align_val_t(DXL_STORE_ALIGNMENT));
+    };
+    void deallocate(T *t_pointer, size_t) noexcept {
+        ::operator delete(t_pointer, std::align_val_t(DXL_STORE_ALIGNMENT));
+    };
+    template<typename U>
+    bool operator==(const Dynamixel_Aligned_Allocator<U> &) const noexcept {
+        return true;
+    };
+};
+
+/**
+ * the quantities kept by the state store
+ */
+enum Dynamixel_Quantity {
+    DXL_QUANTITY_POSITION = 0,
+    DXL_QUANTITY_VELOCITY = 1,
+    DXL_QUANTITY_LOAD = 2,
+    DXL_QUANTITY_GOAL_POSITION = 3,
+    DXL_QUANTITY_GOAL_VELOCITY = 4,
+    DXL_QUANTITY_COUNT = 5,
+};
+
+/**
+ * structure of arrays for the state of a whole fleet, filled straight from the
+ * read buffers of a plan and converted between raw and signed si units in one pass
+ * position -> rad (0 at 2048), velocity -> rad/s, load -> %
+ */
+class Dynamixel_State_Store {
+// public declaration
+public:
+    using Dynamixel_Raw_Array = std::vector<int32_t, Dynamixel_Aligned_Allocator<int32_t>>;
+    using Dynamixel_Si_Array = std::vector<float, Dynamixel_Aligned_Allocator<float>>;
+    /**
+     * initialize the state store
+     * @param t_dxl_ids the identifiers of the dynamixel's, the index in this list is the index in every array
+     */
+    explicit Dynamixel_State_Store(const std::vector<uint8_t> &t_dxl_ids);
+    /**
+     * get the amount of dynamixel's
+     * @return the amount
+     */
+    size_t get_count();
+    /**
+     * get the index of a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return the index or get_count() if unknown
+     */
+    size_t get_index(uint8_t t_dxl_id);
+    /**
+     * read a quantity straight from the read buffer of a plan
+     * @param t_plan the plan, must outlive the store
+     * @param t_quantity the quantity -> position, velocity or load
+     * @param t_index the index of the dynamixel
+     * @param t_read the read handle of the plan
+     */
+    void set_source(Dynamixel_Plan &t_plan, Dynamixel_Quantity t_quantity, size_t t_index, size_t t_read);
+    /**
+     * write a goal straight into the write buffer of a plan
+     * @param t_plan the plan, must outlive the store
+     * @param t_quantity the quantity -> goal position or goal velocity
+     * @param t_index the index of the dynamixel
+     * @param t_write the write handle of the plan
+     */
+    void set_target(Dynamixel_Plan &t_plan, Dynamixel_Quantity t_quantity, size_t t_index, size_t t_write);
+    /**
+     * decode the sources into the raw arrays and convert them to si units
+     */
+    void set_update();
+    /**
+     * convert the si goals to raw and write them into the targets
+     */
+    void set_commit();
+    /**
+     * get the si array of a quantity
+     * @param t_quantity the quantity
+     * @return the cache line aligned array
+     */
+    float *get_si(Dynamixel_Quantity t_quantity);
+    /**
+     * get the raw array of a quantity
+     * @param t_quantity the quantity
+     * @return the cache line aligned array
+     */
+    int32_t *get_raw(Dynamixel_Quantity t_quantity);
+
+// private declaration
+private:
+    /**
+     * a plan buffer bound to an array element
+     */
+    struct Dynamixel_Binding {
+        Dynamixel_Plan *plan;
+        size_t index;
+        size_t handle;
+    };
+    /**
+     * the identifiers of the dynamixel's
+     */
+    std::vector<uint8_t> m_dxl_ids;
+    /**
+     * the raw arrays, one per quantity
+     */
+    Dynamixel_Raw_Array m_raw[DXL_QUANTITY_COUNT];
+    /**
+     * the si arrays, one per quantity
+     */
+    Dynamixel_Si_Array m_si[DXL_QUANTITY_COUNT];
+    /**
+     * the sources and targets, one list per quantity
+     */
+    std::vector<Dynamixel_Binding> m_bindings[DXL_QUANTITY_COUNT];
+    /**
+     * convert raw values to si units: out = (in - offset) * scale
+     * @param t_in the raw values
+     * @param t_out the si values
+     * @param t_count the amount of values
+     * @param t_offset the raw offset
+     * @param t_scale the scale
+     */
+    static void m_set_si(const int32_t *t_in, float *t_out, size_t t_count, int32_t t_offset, float t_scale);
+    /**
+     * convert si units to raw values: out = round(in * scale) + offset
+     * @param t_in the si values
+     * @param t_out the raw values
+     * @param t_count the amount of values
+     * @param t_scale the scale
+     * @param t_offset the raw offset
+     */
+    static void m_set_raw(const float *t_in, int32_t *t_out, size_t t_count, float t_scale, int32_t t_offset);
+};
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "dynamixel_clock.h"
+#include "dynamixel_packet.h"
+#include "dynamixel_timeout.h"
+
+/**
+ * initialize the timeout port
+ * @param t_port_handler the wrapped port handler
+ * @param t_baud_rate the baud rate
+ */
+Dynamixel_Timeout_Port::Dynamixel_Timeout_Port(dynamixel::PortHandler *t_port_handler, int t_baud_rate):
+        m_port_handler(t_port_handler),
+        m_byte_time(10.0 / t_baud_rate) {
+    is_using_ = false;
+}
+/**
+ * open the wrapped port
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Timeout_Port::openPort() {
+    return m_port_handler->openPort();
+}
+/**
+ * close the wrapped port
+ */
+void Dynamixel_Timeout_Port::closePort() {
+    m_port_handler->closePort();
+}
+/**
+ * clear the wrapped port
+ */
+void Dynamixel_Timeout_Port::clearPort() {
+    m_port_handler->clearPort();
+}
+/**
+ * set the name of the wrapped port
+ * @param t_port_name the name of the port
+ */
+void Dynamixel_Timeout_Port::setPortName(const char *t_port_name) {
+    m_port_handler->setPortName(t_port_name);
+}
+/**
+ * get the name of the wrapped port
+ * @return the name of the port
+ */
+char *Dynamixel_Timeout_Port::getPortName() {
+    return m_port_handler->getPortName();
+}
+/**
+ * set the baud rate of the wrapped port, resets the latency statistics
+ * @param t_baud_rate the baud rate
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Timeout_Port::setBaudRate(const int t_baud_rate) {
+    m_byte_time = 10.0 / t_baud_rate;
+    m_samples = 0;
+    return m_port_handler->setBaudRate(t_baud_rate);
+}
+/**
+ * get the baud rate of the wrapped port
+ * @return the baud rate
+ */
+int Dynamixel_Timeout_Port::getBaudRate() {
+    return m_port_handler->getBaudRate();
+}
+/**
+ * get the amount of received bytes
+ * @return the amount of bytes
+ */
+int Dynamixel_Timeout_Port::getBytesAvailable() {
+    return m_port_handler->getBytesAvailable();
+}
+/**
+ * read from the wrapped port, measures the latency of an awaited status
+ * @param t_packet the buffer
+ * @param t_length the length of the buffer
+ * @return the amount of bytes which were read
+ */
+int Dynamixel_Timeout_Port::readPort(uint8_t *t_packet, int t_length) {
+    int dxl_length = m_port_handler->readPort(t_packet, t_length);
+    if (m_pending && dxl_length > 0) {
+        m_received += dxl_length;
+        if (m_received >= m_expected) {
+            m_pending = false;
+            m_misses = 0;
+            m_set_sample(Dynamixel_Clock::get_monotonic_time() - m_start - (double)m_statuses * m_return_delay - m_byte_time * m_expected);
+        }
+    }
+    return dxl_length;
+}
+/**
+ * write to the wrapped port, notes how many statuses the instruction is answered with
+ * @param t_packet the packet
+ * @param t_length the length of the packet
+ * @return the amount of bytes which were written
+ */
+int Dynamixel_Timeout_Port::writePort(uint8_t *t_packet, int t_length) {
+    m_statuses = 1;
+    if (t_length >= DXL_INSTRUCTION_FRAME_LEN) {
+        // the parameters of a sync read hold address, length and one id per status, a bulk read 5 bytes per status
+        size_t dxl_params = DXL_MAKEWORD(t_packet[5], t_packet[6]) - 3;
+        if (t_packet[7] == INST_SYNC_READ && dxl_params > 4) {
+            m_statuses = dxl_params - 4;
+        }
+        if (t_packet[7] == INST_BULK_READ && dxl_params >= 5) {
+            m_statuses = dxl_params / 5;
+        }
+    }
+    return m_port_handler->writePort(t_packet, t_length);
+}
+/**
+ * start waiting for a status of a known length
+ * @param t_packet_length the length of the status in bytes
+ */
+void Dynamixel_Timeout_Port::setPacketTimeout(uint16_t t_packet_length) {
+    m_start = Dynamixel_Clock::get_monotonic_time();
+    m_timeout = get_timeout(t_packet_length, m_statuses);
+    m_expected = t_packet_length;
+    m_received = 0;
+    m_pending = true;
+}
+/**
+ * start waiting for a fixed time
+ * @param t_msec the time in milliseconds
+ */
+void Dynamixel_Timeout_Port::setPacketTimeout(double t_msec) {
+    m_start = Dynamixel_Clock::get_monotonic_time();
+    m_timeout = t_msec / 1000.0;
+    m_pending = false;
+}
+/**
+ * check if the wait timed out
+ * @return true if timed out otherwise false
+ */
+bool Dynamixel_Timeout_Port::isPacketTimeout() {
+    if (Dynamixel_Clock::get_monotonic_time() - m_start <= m_timeout) {
+        return false;
+    }
+    if (m_pending) {
+        m_pending = false;
+        m_timeouts++;
+        // repeated misses mean the link got slower, fall back to the generic timeout and relearn
+        if (++m_misses >= DXL_TIMEOUT_BACKOFF) {
+            m_samples = 0;
+            m_misses = 0;
+        }
+    }
+    return true;
+}
+/**
+ * set the return delay time of the dynamixel's
+ * @param t_return_delay_time the return delay time register value (2 usec units)
+ */
+void Dynamixel_Timeout_Port::set_return_delay(uint8_t t_return_delay_time) {
+    m_return_delay = t_return_delay_time * 2.0e-6;
+}
+/**
+ * get the timeout for one or more statuses
+ * @param t_packet_length the length of all statuses in bytes
+ * @param t_statuses the amount of statuses | default -> 1
+ * @return the timeout in seconds
+ */
+double Dynamixel_Timeout_Port::get_timeout(uint16_t t_packet_length, size_t t_statuses) {
+    // the generic timeout of the sdk, used until the latency is known and as upper bound
+    double dxl_generic = m_byte_time * t_packet_length + (DXL_TIMEOUT_LATENCY_TIMER * 2.0 + 2.0) / 1000.0;
+    if (m_samples < DXL_TIMEOUT_WARMUP) {
+        return dxl_generic;
+    }
+    double dxl_latency = std::max(m_latency + DXL_TIMEOUT_SIGMA * std::sqrt(m_variance), 0.0) + DXL_TIMEOUT_FLOOR;
+    return std::min((double)t_statuses * m_return_delay + m_byte_time * t_packet_length + dxl_latency, dxl_generic);
+}
+/**
+ * get the worst case time of a call including all retries
+ * @param t_tx_length the length of the instruction in bytes
+ * @param t_rx_length the length of the status in bytes, 0 if no status is awaited
+ * @param t_retries the amount of retries
+ * @return the worst case time in seconds
+ */
+double Dynamixel_Timeout_Port::get_worst_case(uint16_t t_tx_length, uint16_t t_rx_length, int t_retries) {
+    double dxl_attempt = m_byte_time * t_tx_length + (t_rx_length > 0 ? get_timeout(t_rx_length) : 0.0);
+    return (1 + std::max(t_retries, 0)) * dxl_attempt;
+}
+/**
+ * get the mean latency of the link (host and adapter, without wire time)
+ * @return the latency in seconds
+ */
+double Dynamixel_Timeout_Port::get_latency() {
+    return m_latency;
+}
+/**
+ * get the standard deviation of the latency
+ * @return the jitter in seconds
+ */
+double Dynamixel_Timeout_Port::get_jitter() {
+    return std::sqrt(m_variance);
+}
+/**
+ * get the amount of timeouts since start
+ * @return the amount of timeouts
+ */
+size_t Dynamixel_Timeout_Port::get_timeouts() {
+    return m_timeouts;
+}
+/**
+ * get the wrapped port handler
+ * @return the port handler
+ */
+dynamixel::PortHandler *Dynamixel_Timeout_Port::get_port_handler() {
+    return m_port_handler;
+}
+
+// MARK: - Private Functions
+/**
+ * add a latency sample, running mean/variance which forgets slowly after the warm up
+ * @param t_latency the latency in seconds
+ */
+void Dynamixel_Timeout_Port::m_set_sample(double t_latency) {
+    if (m_samples == 0) {
+        m_latency = t_latency;
+        m_variance = 0.0;
+    }
+    m_samples++;
+    double dxl_alpha = 1.0 / (double)std::min<size_t>(m_samples, DXL_TIMEOUT_WARMUP);
+    double dxl_difference = t_latency - m_latency;
+    m_latency += dxl_alpha * dxl_difference;
+    m_variance = (1.0 - dxl_alpha) * (m_variance + dxl_alpha * dxl_difference * dxl_difference);
+}
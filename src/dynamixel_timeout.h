@@ -0,0 +1,221 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_TIMEOUT_H
+#define DYNAMIXEL_DYNAMIXEL_TIMEOUT_H
+
+#include <cstdint>
+#include <dynamixel_sdk.h>
+
+#define DXL_TIMEOUT_WARMUP 32
+#define DXL_TIMEOUT_BACKOFF 3
+#define DXL_TIMEOUT_SIGMA 4.0
+#define DXL_TIMEOUT_FLOOR 0.0005
+#define DXL_TIMEOUT_LATENCY_TIMER 16
+
+/**
+ * wraps a port handler and replaces the generic packet timeout of the sdk with one
+ * computed from the baud rate, the status length, the return delay time and the
+ * observed latency of the link (mean + 4 sigma once enough replies were seen)
+ * NOTE: sync and bulk reads wait one return delay time per awaited status
+ */
+class Dynamixel_Timeout_Port : public dynamixel::PortHandler {
+// public declaration
+public:
+    /**
+     * initialize the timeout port
+     * @param t_port_handler the wrapped port handler
+     * @param t_baud_rate the baud rate
+     */
+    Dynamixel_Timeout_Port(dynamixel::PortHandler *t_port_handler, int t_baud_rate);
+    /**
+     * open the wrapped port
+     * @return true if success otherwise false
+     */
+    bool openPort() override;
+    /**
+     * close the wrapped port
+     */
+    void closePort() override;
+    /**
+     * clear the wrapped port
+     */
+    void clearPort() override;
+    /**
+     * set the name of the wrapped port
+     * @param t_port_name the name of the port
+     */
+    void setPortName(const char *t_port_name) override;
+    /**
+     * get the name of the wrapped port
+     * @return the name of the port
+     */
+    char *getPortName() override;
+    /**
+     * set the baud rate of the wrapped port, resets the latency statistics
+     * @param t_baud_rate the baud rate
+     * @return true if success otherwise false
+     */
+    bool setBaudRate(const int t_baud_rate) override;
+    /**
+     * get the baud rate of the wrapped port
+     * @return the baud rate
+     */
+    int getBaudRate() override;
+    /**
+     * get the amount of received bytes
+     * @return the amount of bytes
+     */
+    int getBytesAvailable() override;
+    /**
+     * read from the wrapped port, measures the latency of an awaited status
+     * @param t_packet the buffer
+     * @param t_length the length of the buffer
+     * @return the amount of bytes which were read
+     */
+    int readPort(uint8_t *t_packet, int t_length) override;
+    /**
+     * write to the wrapped port, notes how many statuses the instruction is answered with
+     * @param t_packet the packet
+     * @param t_length the length of the packet
+     * @return the amount of bytes which were written
+     */
+    int writePort(uint8_t *t_packet, int t_length) override;
+    /**
+     * start waiting for a status of a known length
+     * @param t_packet_length the length of the status in bytes
+     */
+    void setPacketTimeout(uint16_t t_packet_length) override;
+    /**
+     * start waiting for a fixed time
+     * @param t_msec the time in milliseconds
+     */
+    void setPacketTimeout(double t_msec) override;
+    /**
+     * check if the wait timed out
+     * @return true if timed out otherwise false
+     */
+    bool isPacketTimeout() override;
+    /**
+     * set the return delay time of the dynamixel's
+     * @param t_return_delay_time the return delay time register value (2 usec units)
+     */
+    void set_return_delay(uint8_t t_return_delay_time);
+    /**
+     * get the timeout for one or more statuses
+     * @param t_packet_length the length of all statuses in bytes
+     * @param t_statuses the amount of statuses | default -> 1
+     * @return the timeout in seconds
+     */
+    double get_timeout(uint16_t t_packet_length, size_t t_statuses = 1);
+    /**
+     * get the worst case time of a call including all retries
+     * @param t_tx_length the length of the instruction in bytes
+     * @param t_rx_length the length of the status in bytes, 0 if no status is awaited
+     * @param t_retries the amount of retries
+     * @return the worst case time in seconds
+     */
+    double get_worst_case(uint16_t t_tx_length, uint16_t t_rx_length, int t_retries);
+    /**
+     * get the mean latency of the link (host and adapter, without wire time)
+     * @return the latency in seconds
+     */
+    double get_latency();
+    /**
+     * get the standard deviation of the latency
+     * @return the jitter in seconds
+     */
+    double get_jitter();
+    /**
+     * get the amount of timeouts since start
+     * @return the amount of timeouts
+     */
+    size_t get_timeouts();
+    /**
+     * get the wrapped port handler
+     * @return the port handler
+     */
+    dynamixel::PortHandler *get_port_handler();
+
+// private declaration
+private:
+    /**
+     * the wrapped port handler
+     */
+    dynamixel::PortHandler *m_port_handler;
+    /**
+     * the time per byte in seconds
+     */
+    double m_byte_time;
+    /**
+     * the return delay time of the dynamixel's in seconds, factory default until set
+     */
+    double m_return_delay = 250 * 2.0e-6;
+    /**
+     * the mean latency in seconds
+     */
+    double m_latency = 0.0;
+    /**
+     * the variance of the latency
+     */
+    double m_variance = 0.0;
+    /**
+     * the amount of latency samples since the last reset
+     */
+    size_t m_samples = 0;
+    /**
+     * the consecutive timeouts
+     */
+    size_t m_misses = 0;
+    /**
+     * the amount of timeouts since start
+     */
+    size_t m_timeouts = 0;
+    /**
+     * the host time at which the wait started
+     */
+    double m_start = 0.0;
+    /**
+     * the timeout of the current wait in seconds
+     */
+    double m_timeout = 0.0;
+    /**
+     * the length of the awaited status
+     */
+    uint16_t m_expected = 0;
+    /**
+     * the amount of statuses the last written instruction is answered with
+     */
+    size_t m_statuses = 1;
+    /**
+     * the bytes received of the awaited status
+     */
+    uint16_t m_received = 0;
+    /**
+     * true while a status of known length is awaited
+     */
+    bool m_pending = false;
+    /**
+     * add a latency sample, running mean/variance which forgets slowly after the warm up
+     * @param t_latency the latency in seconds
+     */
+    void m_set_sample(double t_latency);
+};
+
+#endif
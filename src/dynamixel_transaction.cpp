@@ -0,0 +1,463 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "dynamixel_audit.h"
+#include "dynamixel_transaction.h"
+
+// MARK: - Plan
+/**
+ * update the value of a planned write
+ * @param t_write the handle returned by Dynamixel_Builder::set_write
+ * @param t_value the value to be written
+ */
+void Dynamixel_Plan::set_value(size_t t_write, uint32_t t_value) {
+    const Dynamixel_Plan_Slot &dxl_slot = m_writes[t_write];
+    for (uint16_t i = 0; i < dxl_slot.length && i < 4; i++) {
+        m_param[dxl_slot.offset + i] = (uint8_t)(t_value >> (8 * i));
+    }
+}
+/**
+ * send all writes (in a single port write) and then all reads of the plan
+ * @return true if every packet was sent and every status received
+ */
+bool Dynamixel_Plan::set_execute() {
+    Dynamixel_Tick_Guard dxl_guard("Dynamixel_Plan::set_execute");
+    bool dxl_success = true;
+    size_t dxl_packet = 0;
+    size_t dxl_tx_length = 0;
+    for (; dxl_packet < m_packets.size(); dxl_packet++) {
+        const Dynamixel_Plan_Packet &dxl_write = m_packets[dxl_packet];
+        if (dxl_write.instruction != INST_SYNC_WRITE && dxl_write.instruction != INST_BULK_WRITE) {
+            break;
+        }
+        dxl_tx_length += Dynamixel_Packet::set_instruction(m_tx.data() + dxl_tx_length, m_tx.size() - dxl_tx_length, BROADCAST_ID, dxl_write.instruction, m_param.data() + dxl_write.param_offset, dxl_write.param_length);
+    }
+    m_written = true;
+    if (dxl_tx_length > 0) {
+        m_written = Dynamixel_Packet::set_transmit(m_port_handler, m_tx.data(), dxl_tx_length) == COMM_SUCCESS;
+        dxl_success = m_written;
+    }
+
+    std::fill(m_received.begin(), m_received.end(), 0);
+    for (; dxl_packet < m_packets.size(); dxl_packet++) {
+        const Dynamixel_Plan_Packet &dxl_read = m_packets[dxl_packet];
+        // quarantined dynamixel's are left out, a dead one must not time out the whole read
+        size_t dxl_count = dxl_read.status_count;
+        const uint8_t *dxl_param = m_param.data() + dxl_read.param_offset;
+        size_t dxl_param_length = dxl_read.param_length;
+        if (m_quarantine.get_count() > 0) {
+            dxl_param = m_filtered.data();
+            dxl_param_length = m_get_filtered(dxl_read, dxl_count);
+            dxl_success &= dxl_count == dxl_read.status_count;
+        }
+        if (dxl_count == 0) {
+            dxl_success = false;
+            continue;
+        }
+        dxl_tx_length = Dynamixel_Packet::set_instruction(m_tx.data(), m_tx.size(), BROADCAST_ID, dxl_read.instruction, dxl_param, dxl_param_length);
+        if (Dynamixel_Packet::set_transmit(m_port_handler, m_tx.data(), dxl_tx_length) != COMM_SUCCESS) {
+            dxl_success = false;
+            continue;
+        }
+        m_receiver.set_clear();
+        double dxl_deadline = Dynamixel_Clock::get_monotonic_time() + dxl_read.timeout;
+        for (size_t i = 0; i < dxl_count; i++) {
+            Dynamixel_Status dxl_status{};
+            if (m_receiver.get_status(m_port_handler, dxl_deadline, dxl_status) != COMM_SUCCESS) {
+                dxl_success = false;
+                break;
+            }
+            for (size_t j = dxl_read.status_offset; j < dxl_read.status_offset + dxl_read.status_count; j++) {
+                if (m_statuses[j].id != dxl_status.id || m_received[j]) {
+                    continue;
+                }
+                std::memcpy(m_data.data() + m_statuses[j].data_offset, dxl_status.param, std::min<size_t>(dxl_status.length, m_statuses[j].length));
+                m_received[j] = 1;
+                break;
+            }
+        }
+        // replies which did arrive are kept, the missing ones count towards the quarantine
+        for (size_t j = dxl_read.status_offset; j < dxl_read.status_offset + dxl_read.status_count; j++) {
+            m_quarantine.set_result(m_statuses[j].id, m_received[j]);
+        }
+    }
+    m_quarantine.set_recovery(m_port_handler, m_ping_timeout);
+    return dxl_success;
+}
+/**
+ * check if the writes of the plan were sent in the last execution
+ * @return true if the write packets went out or there were none
+ */
+bool Dynamixel_Plan::get_written() {
+    return m_written;
+}
+/**
+ * get the value of a planned read from the last execution
+ * @param t_read the handle returned by Dynamixel_Builder::set_read
+ * @return the value which was read
+ */
+uint32_t Dynamixel_Plan::get_value(size_t t_read) {
+    const Dynamixel_Plan_Slot &dxl_slot = m_reads[t_read];
+    uint32_t dxl_value = 0;
+    for (uint16_t i = 0; i < dxl_slot.length && i < 4; i++) {
+        dxl_value |= (uint32_t)m_data[dxl_slot.offset + i] << (8 * i);
+    }
+    return dxl_value;
+}
+/**
+ * check if a planned read was answered in the last execution
+ * @param t_read the handle returned by Dynamixel_Builder::set_read
+ * @return true if the value is valid
+ */
+bool Dynamixel_Plan::get_valid(size_t t_read) {
+    return m_received[m_reads[t_read].status] != 0;
+}
+/**
+ * get the raw data of a planned read from the last execution
+ * @param t_read the handle returned by Dynamixel_Builder::set_read
+ * @return the little endian register bytes
+ */
+const uint8_t *Dynamixel_Plan::get_data(size_t t_read) {
+    return m_data.data() + m_reads[t_read].offset;
+}
+/**
+ * get the packets of the plan, e.g. for a bus model admission check
+ * @return one transaction per packet
+ */
+const std::vector<Dynamixel_Transaction> &Dynamixel_Plan::get_transactions() {
+    return m_transactions;
+}
+/**
+ * get the quarantine of the plan, quarantined dynamixel's are left out of the reads
+ * @return the quarantine
+ */
+Dynamixel_Quarantine &Dynamixel_Plan::get_quarantine() {
+    return m_quarantine;
+}
+/**
+ * copy the parameters of a read packet without the quarantined dynamixel's
+ * @param t_packet the read packet
+ * @param t_count the amount of expected status packets
+ * @return the length of the parameters
+ */
+size_t Dynamixel_Plan::m_get_filtered(const Dynamixel_Plan_Packet &t_packet, size_t &t_count) {
+    // sync read: address, length, then one id per dynamixel | bulk read: id, address, length per dynamixel
+    const uint8_t *dxl_param = m_param.data() + t_packet.param_offset;
+    size_t dxl_header = t_packet.instruction == INST_SYNC_READ ? 4 : 0;
+    size_t dxl_stride = t_packet.instruction == INST_SYNC_READ ? 1 : 5;
+    size_t dxl_length = dxl_header;
+    std::memcpy(m_filtered.data(), dxl_param, dxl_header);
+    t_count = 0;
+    for (size_t i = dxl_header; i + dxl_stride <= t_packet.param_length; i += dxl_stride) {
+        if (!m_quarantine.get_admitted(dxl_param[i])) {
+            continue;
+        }
+        std::memcpy(m_filtered.data() + dxl_length, dxl_param + i, dxl_stride);
+        dxl_length += dxl_stride;
+        t_count++;
+    }
+    return dxl_length;
+}
+
+// MARK: - Builder
+/**
+ * add a register read
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_address the address of the register
+ * @param t_length the length of the register
+ * @return the handle of the read
+ */
+size_t Dynamixel_Builder::set_read(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length) {
+    m_reads.push_back({t_dxl_id, t_address, t_length, 0, m_reads.size()});
+    return m_reads.back().handle;
+}
+/**
+ * add a register write
+ * @param t_dxl_id the identifier of the dynamixel
+ * @param t_address the address of the register
+ * @param t_length the length of the register -> 1, 2 or 4
+ * @param t_value the initial value to be written
+ * @return the handle of the write
+ */
+size_t Dynamixel_Builder::set_write(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length, uint32_t t_value) {
+    m_writes.push_back({t_dxl_id, t_address, t_length, t_value, m_writes.size()});
+    return m_writes.back().handle;
+}
+/**
+ * remove all reads and writes
+ */
+void Dynamixel_Builder::set_clear() {
+    m_reads.clear();
+    m_writes.clear();
+}
+/**
+ * compile the reads and writes into packets
+ * @param t_dynamixel the dynamixel bus
+ * @param t_model the bus model used to choose between packet types
+ * @return the compiled plan
+ */
+Dynamixel_Plan Dynamixel_Builder::get_plan(Dynamixel &t_dynamixel, Dynamixel_Bus_Model t_model) {
+    Dynamixel_Plan dxl_plan;
+    dxl_plan.m_port_handler = t_dynamixel.get_port_handler();
+    dxl_plan.m_writes.resize(m_writes.size());
+    dxl_plan.m_reads.resize(m_reads.size());
+
+    // reading a few unused bytes is cheaper than another status packet
+    double dxl_overhead = t_model.get_transaction_time({INST_BULK_READ, 1, 0}) - t_model.get_transaction_time({INST_BULK_READ, 0, 0});
+    uint16_t dxl_gap = (uint16_t)std::min(dxl_overhead / t_model.get_byte_time(), 255.0);
+
+    for (bool dxl_write : {true, false}) {
+        std::vector<std::vector<Dynamixel_Builder_Span>> dxl_spans = m_get_spans(dxl_write ? m_writes : m_reads, dxl_write ? 0 : dxl_gap);
+        size_t dxl_rounds = 0;
+        for (const std::vector<Dynamixel_Builder_Span> &dxl_id_spans : dxl_spans) {
+            dxl_rounds = std::max(dxl_rounds, dxl_id_spans.size());
+        }
+        // a sync/bulk packet addresses every dynamixel only once, further spans go into further rounds
+        for (size_t i = 0; i < dxl_rounds; i++) {
+            std::vector<Dynamixel_Builder_Span> dxl_round;
+            for (const std::vector<Dynamixel_Builder_Span> &dxl_id_spans : dxl_spans) {
+                if (i < dxl_id_spans.size()) {
+                    dxl_round.push_back(dxl_id_spans[i]);
+                }
+            }
+            for (const std::vector<Dynamixel_Builder_Span> &dxl_group : m_get_groups(dxl_round, dxl_write, t_model)) {
+                m_set_packet(dxl_plan, dxl_group, dxl_write, t_model);
+            }
+        }
+    }
+
+    size_t dxl_tx_writes = 0;
+    size_t dxl_tx_reads = 0;
+    size_t dxl_rx_reads = 0;
+    for (const Dynamixel_Plan::Dynamixel_Plan_Packet &dxl_packet : dxl_plan.m_packets) {
+        size_t dxl_tx = DXL_INSTRUCTION_FRAME_LEN + dxl_packet.param_length + dxl_packet.param_length / 3;
+        if (dxl_packet.instruction == INST_SYNC_WRITE || dxl_packet.instruction == INST_BULK_WRITE) {
+            dxl_tx_writes += dxl_tx;
+            continue;
+        }
+        dxl_tx_reads = std::max(dxl_tx_reads, dxl_tx);
+        size_t dxl_rx = 0;
+        for (size_t i = dxl_packet.status_offset; i < dxl_packet.status_offset + dxl_packet.status_count; i++) {
+            dxl_rx += DXL_STATUS_FRAME_LEN + dxl_plan.m_statuses[i].length + dxl_plan.m_statuses[i].length / 3;
+        }
+        dxl_rx_reads = std::max(dxl_rx_reads, dxl_rx);
+    }
+    dxl_plan.m_tx.resize(std::max(dxl_tx_writes, dxl_tx_reads));
+    dxl_plan.m_received.resize(dxl_plan.m_statuses.size());
+    dxl_plan.m_filtered.resize(dxl_plan.m_param.size());
+    dxl_plan.m_ping_timeout = 2.0 * t_model.get_transaction_time({INST_PING, 1, 3});
+    dxl_plan.m_receiver = Dynamixel_Receiver(std::max<size_t>(dxl_rx_reads, 64));
+    return dxl_plan;
+}
+/**
+ * compile the reads and writes into packets with the default bus model
+ * @param t_dynamixel the dynamixel bus
+ * @return the compiled plan
+ */
+Dynamixel_Plan Dynamixel_Builder::get_plan(Dynamixel &t_dynamixel) {
+    return get_plan(t_dynamixel, Dynamixel_Bus_Model(t_dynamixel.get_baud_rate()));
+}
+
+// MARK: - Private Functions
+/**
+ * merge the entries of every dynamixel into contiguous spans
+ * @param t_entries the entries
+ * @param t_gap the largest gap which is merged (reads only)
+ * @return the spans of every dynamixel, in address order
+ */
+std::vector<std::vector<Dynamixel_Builder::Dynamixel_Builder_Span>> Dynamixel_Builder::m_get_spans(const std::vector<Dynamixel_Builder_Entry> &t_entries, uint16_t t_gap) {
+    std::vector<Dynamixel_Builder_Entry> dxl_entries(t_entries);
+    std::stable_sort(dxl_entries.begin(), dxl_entries.end(), [](const Dynamixel_Builder_Entry &t_lhs, const Dynamixel_Builder_Entry &t_rhs) {
+        return t_lhs.id != t_rhs.id ? t_lhs.id < t_rhs.id : t_lhs.address < t_rhs.address;
+    });
+    std::vector<std::vector<Dynamixel_Builder_Span>> dxl_spans;
+    for (const Dynamixel_Builder_Entry &dxl_entry : dxl_entries) {
+        if (dxl_spans.empty() || dxl_spans.back().front().id != dxl_entry.id) {
+            dxl_spans.emplace_back();
+        }
+        std::vector<Dynamixel_Builder_Span> &dxl_id_spans = dxl_spans.back();
+        if (!dxl_id_spans.empty() && dxl_entry.address <= dxl_id_spans.back().address + dxl_id_spans.back().length + t_gap) {
+            Dynamixel_Builder_Span &dxl_span = dxl_id_spans.back();
+            uint16_t dxl_end = std::max<uint16_t>(dxl_span.address + dxl_span.length, dxl_entry.address + dxl_entry.length);
+            dxl_span.length = dxl_end - dxl_span.address;
+            dxl_span.entries.push_back(dxl_entry);
+            continue;
+        }
+        dxl_id_spans.push_back({dxl_entry.id, dxl_entry.address, dxl_entry.length, {dxl_entry}});
+    }
+    return dxl_spans;
+}
+/**
+ * split the spans of a round (one span per dynamixel) into sync and bulk groups by cost
+ * @param t_spans the spans of the round
+ * @param t_write true for writes, false for reads
+ * @param t_model the bus model
+ * @return the groups, the last one is a bulk group if it isn't uniform
+ */
+std::vector<std::vector<Dynamixel_Builder::Dynamixel_Builder_Span>> Dynamixel_Builder::m_get_groups(std::vector<Dynamixel_Builder_Span> t_spans, bool t_write, Dynamixel_Bus_Model &t_model) {
+    std::vector<std::vector<Dynamixel_Builder_Span>> dxl_uniform;
+    for (const Dynamixel_Builder_Span &dxl_span : t_spans) {
+        auto dxl_group = std::find_if(dxl_uniform.begin(), dxl_uniform.end(), [&](const std::vector<Dynamixel_Builder_Span> &t_group) {
+            return t_group.front().address == dxl_span.address && t_group.front().length == dxl_span.length;
+        });
+        if (dxl_group == dxl_uniform.end()) {
+            dxl_uniform.push_back({dxl_span});
+        } else {
+            dxl_group->push_back(dxl_span);
+        }
+    }
+    std::stable_sort(dxl_uniform.begin(), dxl_uniform.end(), [](const std::vector<Dynamixel_Builder_Span> &t_lhs, const std::vector<Dynamixel_Builder_Span> &t_rhs) {
+        return t_lhs.size() > t_rhs.size();
+    });
+
+    // pull a uniform group out of the bulk packet whenever a separate sync packet is cheaper
+    std::vector<std::vector<Dynamixel_Builder_Span>> dxl_groups;
+    std::vector<Dynamixel_Builder_Span> dxl_remaining(t_spans);
+    for (const std::vector<Dynamixel_Builder_Span> &dxl_group : dxl_uniform) {
+        if (dxl_group.size() == dxl_remaining.size()) {
+            break;
+        }
+        std::vector<Dynamixel_Builder_Span> dxl_rest;
+        for (const Dynamixel_Builder_Span &dxl_span : dxl_remaining) {
+            if (dxl_span.address != dxl_group.front().address || dxl_span.length != dxl_group.front().length) {
+                dxl_rest.push_back(dxl_span);
+            }
+        }
+        if (m_get_cost(dxl_group, t_write, t_model) + m_get_cost(dxl_rest, t_write, t_model) < m_get_cost(dxl_remaining, t_write, t_model)) {
+            dxl_groups.push_back(dxl_group);
+            dxl_remaining = dxl_rest;
+        }
+    }
+    if (!dxl_remaining.empty()) {
+        dxl_groups.push_back(dxl_remaining);
+    }
+    if (t_write || (dxl_groups.size() == 1 && m_get_uniform(dxl_groups.front()))) {
+        return dxl_groups;
+    }
+
+    // reads may widen every span to the common range, which allows a single sync read
+    uint16_t dxl_begin = 0xFFFF;
+    uint16_t dxl_end = 0;
+    double dxl_cost = 0.0;
+    for (const std::vector<Dynamixel_Builder_Span> &dxl_group : dxl_groups) {
+        dxl_cost += m_get_cost(dxl_group, t_write, t_model);
+    }
+    for (const Dynamixel_Builder_Span &dxl_span : t_spans) {
+        dxl_begin = std::min(dxl_begin, dxl_span.address);
+        dxl_end = std::max<uint16_t>(dxl_end, dxl_span.address + dxl_span.length);
+    }
+    std::vector<Dynamixel_Builder_Span> dxl_widened(t_spans);
+    for (Dynamixel_Builder_Span &dxl_span : dxl_widened) {
+        dxl_span.address = dxl_begin;
+        dxl_span.length = dxl_end - dxl_begin;
+    }
+    if (m_get_cost(dxl_widened, t_write, t_model) < dxl_cost) {
+        return {dxl_widened};
+    }
+    return dxl_groups;
+}
+/**
+ * get the cost of sending a group of spans in one packet
+ * @param t_spans the spans
+ * @param t_write true for writes, false for reads
+ * @param t_model the bus model
+ * @return the time in seconds
+ */
+double Dynamixel_Builder::m_get_cost(const std::vector<Dynamixel_Builder_Span> &t_spans, bool t_write, Dynamixel_Bus_Model &t_model) {
+    if (t_spans.empty()) {
+        return 0.0;
+    }
+    uint16_t dxl_data_length = 0;
+    for (const Dynamixel_Builder_Span &dxl_span : t_spans) {
+        dxl_data_length += dxl_span.length;
+    }
+    uint8_t dxl_instruction;
+    if (m_get_uniform(t_spans)) {
+        dxl_instruction = t_write ? INST_SYNC_WRITE : INST_SYNC_READ;
+    } else {
+        dxl_instruction = t_write ? INST_BULK_WRITE : INST_BULK_READ;
+    }
+    return t_model.get_transaction_time({dxl_instruction, (uint16_t)t_spans.size(), dxl_data_length});
+}
+/**
+ * check if all spans of a group have the same address range
+ * @param t_spans the spans
+ * @return true if a sync packet can be used
+ */
+bool Dynamixel_Builder::m_get_uniform(const std::vector<Dynamixel_Builder_Span> &t_spans) {
+    return std::all_of(t_spans.begin(), t_spans.end(), [&](const Dynamixel_Builder_Span &t_span) {
+        return t_span.address == t_spans.front().address && t_span.length == t_spans.front().length;
+    });
+}
+/**
+ * append a group as a compiled packet to the plan
+ * @param t_plan the plan
+ * @param t_spans the spans of the packet
+ * @param t_write true for writes, false for reads
+ * @param t_model the bus model
+ */
+void Dynamixel_Builder::m_set_packet(Dynamixel_Plan &t_plan, const std::vector<Dynamixel_Builder_Span> &t_spans, bool t_write, Dynamixel_Bus_Model &t_model) {
+    bool dxl_uniform = m_get_uniform(t_spans);
+    Dynamixel_Plan::Dynamixel_Plan_Packet dxl_packet{};
+    if (dxl_uniform) {
+        dxl_packet.instruction = t_write ? INST_SYNC_WRITE : INST_SYNC_READ;
+    } else {
+        dxl_packet.instruction = t_write ? INST_BULK_WRITE : INST_BULK_READ;
+    }
+    dxl_packet.param_offset = t_plan.m_param.size();
+    dxl_packet.status_offset = t_plan.m_statuses.size();
+    std::vector<uint8_t> &dxl_param = t_plan.m_param;
+    if (dxl_uniform) {
+        const Dynamixel_Builder_Span &dxl_first = t_spans.front();
+        dxl_param.insert(dxl_param.end(), {DXL_LOBYTE(dxl_first.address), DXL_HIBYTE(dxl_first.address), DXL_LOBYTE(dxl_first.length), DXL_HIBYTE(dxl_first.length)});
+    }
+
+    uint16_t dxl_data_length = 0;
+    for (const Dynamixel_Builder_Span &dxl_span : t_spans) {
+        dxl_param.push_back(dxl_span.id);
+        if (!dxl_uniform) {
+            dxl_param.insert(dxl_param.end(), {DXL_LOBYTE(dxl_span.address), DXL_HIBYTE(dxl_span.address), DXL_LOBYTE(dxl_span.length), DXL_HIBYTE(dxl_span.length)});
+        }
+        dxl_data_length += dxl_span.length;
+        if (t_write) {
+            size_t dxl_offset = dxl_param.size();
+            dxl_param.resize(dxl_offset + dxl_span.length, 0);
+            for (const Dynamixel_Builder_Entry &dxl_entry : dxl_span.entries) {
+                t_plan.m_writes[dxl_entry.handle] = {dxl_offset + (dxl_entry.address - dxl_span.address), dxl_entry.length, 0};
+                t_plan.set_value(dxl_entry.handle, dxl_entry.value);
+            }
+            continue;
+        }
+        size_t dxl_offset = t_plan.m_data.size();
+        t_plan.m_data.resize(dxl_offset + dxl_span.length, 0);
+        for (const Dynamixel_Builder_Entry &dxl_entry : dxl_span.entries) {
+            t_plan.m_reads[dxl_entry.handle] = {dxl_offset + (dxl_entry.address - dxl_span.address), dxl_entry.length, t_plan.m_statuses.size()};
+        }
+        t_plan.m_statuses.push_back({dxl_span.id, dxl_span.length, dxl_offset});
+    }
+    dxl_packet.param_length = dxl_param.size() - dxl_packet.param_offset;
+    dxl_packet.status_count = t_plan.m_statuses.size() - dxl_packet.status_offset;
+
+    Dynamixel_Transaction dxl_transaction{dxl_packet.instruction, (uint16_t)t_spans.size(), dxl_data_length};
+    dxl_packet.timeout = 2.0 * t_model.get_transaction_time(dxl_transaction);
+    t_plan.m_packets.push_back(dxl_packet);
+    t_plan.m_transactions.push_back(dxl_transaction);
+}
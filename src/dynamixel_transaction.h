@@ -0,0 +1,290 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_TRANSACTION_H
+#define DYNAMIXEL_DYNAMIXEL_TRANSACTION_H
+
+#include <cstdint>
+#include <vector>
+#include "dynamixel.h"
+#include "dynamixel_bus_model.h"
+#include "dynamixel_packet.h"
+#include "dynamixel_quarantine.h"
+
+/**
+ * a compiled set of reads and writes, executing it doesn't plan or allocate
+ */
+class Dynamixel_Plan {
+// public declaration
+public:
+    /**
+     * update the value of a planned write
+     * @param t_write the handle returned by Dynamixel_Builder::set_write
+     * @param t_value the value to be written
+     */
+    void set_value(size_t t_write, uint32_t t_value);
+    /**
+     * send all writes (in a single port write) and then all reads of the plan
+     * @return true if every packet was sent and every status received
+     */
+    bool set_execute();
+    /**
+     * check if the writes of the plan were sent in the last execution
+     * @return true if the write packets went out or there were none
+     */
+    bool get_written();
+    /**
+     * get the value of a planned read from the last execution
+     * @param t_read the handle returned by Dynamixel_Builder::set_read
+     * @return the value which was read
+     */
+    uint32_t get_value(size_t t_read);
+    /**
+     * check if a planned read was answered in the last execution
+     * @param t_read the handle returned by Dynamixel_Builder::set_read
+     * @return true if the value is valid
+     */
+    bool get_valid(size_t t_read);
+    /**
+     * get the raw data of a planned read from the last execution
+     * @param t_read the handle returned by Dynamixel_Builder::set_read
+     * @return the little endian register bytes
+     */
+    const uint8_t *get_data(size_t t_read);
+    /**
+     * get the packets of the plan, e.g. for a bus model admission check
+     * @return one transaction per packet
+     */
+    const std::vector<Dynamixel_Transaction> &get_transactions();
+    /**
+     * get the quarantine of the plan, quarantined dynamixel's are left out of the reads
+     * @return the quarantine
+     */
+    Dynamixel_Quarantine &get_quarantine();
+
+// private declaration
+private:
+    friend class Dynamixel_Builder;
+    /**
+     * an expected status packet of a read packet
+     */
+    struct Dynamixel_Plan_Status {
+        uint8_t id;
+        uint16_t length;
+        size_t data_offset;
+    };
+    /**
+     * a compiled packet
+     */
+    struct Dynamixel_Plan_Packet {
+        uint8_t instruction;
+        size_t param_offset;
+        size_t param_length;
+        size_t status_offset;
+        size_t status_count;
+        double timeout;
+    };
+    /**
+     * where the value of a handle lives
+     */
+    struct Dynamixel_Plan_Slot {
+        size_t offset;
+        uint16_t length;
+        size_t status;
+    };
+    /**
+     * the port handler to use
+     */
+    dynamixel::PortHandler *m_port_handler = nullptr;
+    /**
+     * the packets, writes first
+     */
+    std::vector<Dynamixel_Plan_Packet> m_packets;
+    /**
+     * the transactions of the packets
+     */
+    std::vector<Dynamixel_Transaction> m_transactions;
+    /**
+     * the parameters of all packets
+     */
+    std::vector<uint8_t> m_param;
+    /**
+     * the encoded packets
+     */
+    std::vector<uint8_t> m_tx;
+    /**
+     * the expected status packets of all read packets
+     */
+    std::vector<Dynamixel_Plan_Status> m_statuses;
+    /**
+     * true for every received status of the last execution
+     */
+    std::vector<uint8_t> m_received;
+    /**
+     * the data of all read packets
+     */
+    std::vector<uint8_t> m_data;
+    /**
+     * the write handles, pointing into the parameters
+     */
+    std::vector<Dynamixel_Plan_Slot> m_writes;
+    /**
+     * the read handles, pointing into the data
+     */
+    std::vector<Dynamixel_Plan_Slot> m_reads;
+    /**
+     * the receiver of the status packets
+     */
+    Dynamixel_Receiver m_receiver;
+    /**
+     * the parameters of a read packet without the quarantined dynamixel's
+     */
+    std::vector<uint8_t> m_filtered;
+    /**
+     * the dynamixel's which are left out of the reads
+     */
+    Dynamixel_Quarantine m_quarantine;
+    /**
+     * the timeout of a recovery ping in seconds
+     */
+    double m_ping_timeout = 0.0;
+    /**
+     * true if the write packets of the last execution went out
+     */
+    bool m_written = false;
+    /**
+     * copy the parameters of a read packet without the quarantined dynamixel's
+     * @param t_packet the read packet
+     * @param t_count the amount of expected status packets
+     * @return the length of the parameters
+     */
+    size_t m_get_filtered(const Dynamixel_Plan_Packet &t_packet, size_t &t_count);
+};
+
+/**
+ * collects arbitrary (id, register, value) reads and writes and compiles them
+ * into the fewest sync write, bulk write, sync read and bulk read packets
+ */
+class Dynamixel_Builder {
+// public declaration
+public:
+    /**
+     * add a register read
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the address of the register
+     * @param t_length the length of the register
+     * @return the handle of the read
+     */
+    size_t set_read(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length);
+    /**
+     * add a register write
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the address of the register
+     * @param t_length the length of the register -> 1, 2 or 4
+     * @param t_value the initial value to be written
+     * @return the handle of the write
+     */
+    size_t set_write(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length, uint32_t t_value);
+    /**
+     * remove all reads and writes
+     */
+    void set_clear();
+    /**
+     * compile the reads and writes into packets
+     * @param t_dynamixel the dynamixel bus
+     * @param t_model the bus model used to choose between packet types
+     * @return the compiled plan
+     */
+    Dynamixel_Plan get_plan(Dynamixel &t_dynamixel, Dynamixel_Bus_Model t_model);
+    /**
+     * compile the reads and writes into packets with the default bus model
+     * @param t_dynamixel the dynamixel bus
+     * @return the compiled plan
+     */
+    Dynamixel_Plan get_plan(Dynamixel &t_dynamixel);
+
+// private declaration
+private:
+    /**
+     * a requested read or write
+     */
+    struct Dynamixel_Builder_Entry {
+        uint8_t id;
+        uint16_t address;
+        uint16_t length;
+        uint32_t value;
+        size_t handle;
+    };
+    /**
+     * a contiguous address range of one dynamixel
+     */
+    struct Dynamixel_Builder_Span {
+        uint8_t id;
+        uint16_t address;
+        uint16_t length;
+        std::vector<Dynamixel_Builder_Entry> entries;
+    };
+    /**
+     * the requested reads
+     */
+    std::vector<Dynamixel_Builder_Entry> m_reads;
+    /**
+     * the requested writes
+     */
+    std::vector<Dynamixel_Builder_Entry> m_writes;
+    /**
+     * merge the entries of every dynamixel into contiguous spans
+     * @param t_entries the entries
+     * @param t_gap the largest gap which is merged (reads only)
+     * @return the spans of every dynamixel, in address order
+     */
+    static std::vector<std::vector<Dynamixel_Builder_Span>> m_get_spans(const std::vector<Dynamixel_Builder_Entry> &t_entries, uint16_t t_gap);
+    /**
+     * split the spans of a round (one span per dynamixel) into sync and bulk groups by cost
+     * @param t_spans the spans of the round
+     * @param t_write true for writes, false for reads
+     * @param t_model the bus model
+     * @return the groups, the last one is a bulk group if it isn't uniform
+     */
+    static std::vector<std::vector<Dynamixel_Builder_Span>> m_get_groups(std::vector<Dynamixel_Builder_Span> t_spans, bool t_write, Dynamixel_Bus_Model &t_model);
+    /**
+     * get the cost of sending a group of spans in one packet
+     * @param t_spans the spans
+     * @param t_write true for writes, false for reads
+     * @param t_model the bus model
+     * @return the time in seconds
+     */
+    static double m_get_cost(const std::vector<Dynamixel_Builder_Span> &t_spans, bool t_write, Dynamixel_Bus_Model &t_model);
+    /**
+     * check if all spans of a group have the same address range
+     * @param t_spans the spans
+     * @return true if a sync packet can be used
+     */
+    static bool m_get_uniform(const std::vector<Dynamixel_Builder_Span> &t_spans);
+    /**
+     * append a group as a compiled packet to the plan
+     * @param t_plan the plan
+     * @param t_spans the spans of the packet
+     * @param t_write true for writes, false for reads
+     * @param t_model the bus model
+     */
+    static void m_set_packet(Dynamixel_Plan &t_plan, const std::vector<Dynamixel_Builder_Span> &t_spans, bool t_write, Dynamixel_Bus_Model &t_model);
+};
+
+#endif
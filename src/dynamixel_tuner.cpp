@@ -0,0 +1,386 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include "dynamixel_tuner.h"
+
+// the chirp sweeps from 0.5 hz up to min(5 hz, rate / 20)
+#define DXL_TUNER_CHIRP_START 0.5
+#define DXL_TUNER_CHIRP_END 5.0
+
+// the register of every gain, in the order of Dynamixel_Gain
+static const uint16_t DXL_TUNER_ADDRESSES[DXL_TUNER_GAINS] = {ADDR_POSITION_P_GAIN, ADDR_POSITION_D_GAIN, ADDR_POSITION_I_GAIN, ADDR_FEEDFORWARD_1_GAIN, ADDR_FEEDFORWARD_2_GAIN, ADDR_VELOCITY_P_GAIN, ADDR_VELOCITY_I_GAIN};
+
+/**
+ * initialize the tuner, reads the current gains as starting point
+ * @param t_dynamixel the dynamixel bus
+ * @param t_dxl_ids the identifiers of the dynamixel's to tune
+ */
+Dynamixel_Tuner::Dynamixel_Tuner(Dynamixel &t_dynamixel, const std::vector<uint8_t> &t_dxl_ids):
+        m_dynamixel(t_dynamixel) {
+    Dynamixel_Builder dxl_builder = Dynamixel_Builder();
+    Dynamixel_Builder dxl_gain_builder = Dynamixel_Builder();
+    for (uint8_t dxl_id : t_dxl_ids) {
+        Dynamixel_Search dxl_search{};
+        dxl_search.id = dxl_id;
+        dxl_search.best.kp = m_dynamixel.get_position_kp_gain(dxl_id);
+        dxl_search.best.ki = m_dynamixel.get_position_ki_gain(dxl_id);
+        dxl_search.best.kd = m_dynamixel.get_position_kd_gain(dxl_id);
+        dxl_search.best.ff1 = m_dynamixel.get_feedforward_first_gain(dxl_id);
+        dxl_search.best.ff2 = m_dynamixel.get_feedforward_second_gain(dxl_id);
+        dxl_search.best.vp = m_dynamixel.get_velocity_kp_gain(dxl_id);
+        dxl_search.best.vi = m_dynamixel.get_velocity_ki_gain(dxl_id);
+        dxl_search.candidate = dxl_search.best;
+        dxl_search.response.cost = HUGE_VAL;
+        dxl_search.factor = 2.0;
+        dxl_search.direction = 1;
+        dxl_search.origin = (int32_t)m_dynamixel.get_present_position(dxl_id);
+
+        // the velocity and position gains are contiguous, the feedforward gains follow after a gap
+        for (int i = 0; i < DXL_TUNER_GAINS; i++) {
+            dxl_search.gains[i] = dxl_gain_builder.set_write(dxl_id, DXL_TUNER_ADDRESSES[i], 2, m_get_gain(dxl_search.best, i));
+        }
+        dxl_search.goal = dxl_builder.set_write(dxl_id, ADDR_GOAL_POSITION, 4, dxl_search.origin);
+        dxl_search.position = dxl_builder.set_read(dxl_id, ADDR_PRESENT_POSITION, 4);
+        m_searches.push_back(dxl_search);
+    }
+    m_gain_plan = dxl_gain_builder.get_plan(m_dynamixel);
+    m_plan = dxl_builder.get_plan(m_dynamixel);
+    set_experiment(m_amplitude, m_duration, m_rate);
+}
+/**
+ * set the experiment
+ * @param t_amplitude the step and chirp amplitude in ticks
+ * @param t_duration the duration of a step and of the chirp in seconds
+ * @param t_rate the sample rate in hz
+ */
+void Dynamixel_Tuner::set_experiment(uint16_t t_amplitude, double t_duration, double t_rate) {
+    m_amplitude = std::max<uint16_t>(t_amplitude, 1);
+    m_duration = t_duration;
+    m_rate = t_rate;
+    m_samples = std::max<size_t>((size_t)(t_duration * t_rate), 1);
+    m_goals.assign(3 * m_samples, 0);
+    m_positions.assign(3 * m_samples * m_searches.size(), 0);
+
+    // windowed chirp around the origin (starts and ends at rest), step up, step down
+    double dxl_end = std::min(DXL_TUNER_CHIRP_END, m_rate / 20.0);
+    for (size_t i = 0; i < m_samples; i++) {
+        double dxl_time = (double)i / m_rate;
+        double dxl_phase = 2.0 * M_PI * (DXL_TUNER_CHIRP_START * dxl_time + (dxl_end - DXL_TUNER_CHIRP_START) * dxl_time * dxl_time / (2.0 * m_duration));
+        m_goals[i] = (int32_t)std::lround(m_amplitude * std::sin(M_PI * dxl_time / m_duration) * std::sin(dxl_phase));
+        m_goals[m_samples + i] = m_amplitude;
+        m_goals[2 * m_samples + i] = 0;
+    }
+}
+/**
+ * set the limits of the response
+ * @param t_overshoot the max overshoot relative to the amplitude -> 0.05 = 5%
+ * @param t_settling_band the settling band relative to the amplitude
+ */
+void Dynamixel_Tuner::set_limits(double t_overshoot, double t_settling_band) {
+    m_overshoot = t_overshoot;
+    m_settling_band = t_settling_band;
+}
+/**
+ * add the velocity pi gains to the search, the position modes of the x series don't
+ * use the velocity loop, so this only pays off on models which cascade it | default -> false
+ * @param t_velocity true to search the velocity gains as well
+ */
+void Dynamixel_Tuner::set_velocity_search(bool t_velocity) {
+    m_velocity = t_velocity;
+}
+/**
+ * run the search, every iteration is one experiment on all dynamixel's
+ * @param t_iterations the max amount of iterations
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Tuner::set_tune(int t_iterations) {
+    if (!m_get_ready()) {
+        return false;
+    }
+    for (int i = 0; i < t_iterations; i++) {
+        if (std::all_of(m_searches.begin(), m_searches.end(), [](const Dynamixel_Search &t_search) { return t_search.done; })) {
+            break;
+        }
+        if (!m_set_gains(true) || !m_set_experiment()) {
+            m_set_gains(false);
+            return false;
+        }
+        for (size_t j = 0; j < m_searches.size(); j++) {
+            Dynamixel_Search &dxl_search = m_searches[j];
+            if (dxl_search.done) {
+                continue;
+            }
+            Dynamixel_Response dxl_response = m_get_response(j);
+            bool dxl_improved = !dxl_search.evaluated || dxl_response.cost < dxl_search.response.cost;
+            if (dxl_improved) {
+                dxl_search.best = dxl_search.candidate;
+                dxl_search.response = dxl_response;
+                dxl_search.evaluated = true;
+            }
+            m_set_next(dxl_search, dxl_improved);
+        }
+    }
+    return m_set_gains(false);
+}
+/**
+ * write the best gains of all dynamixel's in one sync write
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Tuner::set_apply() {
+    return m_set_gains(false);
+}
+/**
+ * get the best gains of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the gains
+ */
+Dynamixel_Gains Dynamixel_Tuner::get_gains(uint8_t t_dxl_id) {
+    for (const Dynamixel_Search &dxl_search : m_searches) {
+        if (dxl_search.id == t_dxl_id) {
+            return dxl_search.best;
+        }
+    }
+    printf("failed: unknown dynamixel: %d\n", t_dxl_id);
+    return {};
+}
+/**
+ * get the response of the best gains of a dynamixel
+ * @param t_dxl_id the identifier of the dynamixel
+ * @return the response
+ */
+Dynamixel_Response Dynamixel_Tuner::get_response(uint8_t t_dxl_id) {
+    for (const Dynamixel_Search &dxl_search : m_searches) {
+        if (dxl_search.id == t_dxl_id) {
+            return dxl_search.response;
+        }
+    }
+    printf("failed: unknown dynamixel: %d\n", t_dxl_id);
+    return {};
+}
+
+// MARK: - Private Functions
+/**
+ * write the gains of all dynamixel's in one sync write
+ * @param t_candidate true for the candidates, false for the best gains
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Tuner::m_set_gains(bool t_candidate) {
+    for (const Dynamixel_Search &dxl_search : m_searches) {
+        Dynamixel_Gains dxl_gains = t_candidate ? dxl_search.candidate : dxl_search.best;
+        for (int i = 0; i < DXL_TUNER_GAINS; i++) {
+            m_gain_plan.set_value(dxl_search.gains[i], m_get_gain(dxl_gains, i));
+        }
+    }
+    if (!m_gain_plan.set_execute()) {
+        printf("failed: write of gains\n");
+        return false;
+    }
+    return true;
+}
+/**
+ * check that every dynamixel is in a position mode with torque enabled
+ * @return true if the experiment may move them
+ */
+bool Dynamixel_Tuner::m_get_ready() {
+    bool dxl_ready = true;
+    for (const Dynamixel_Search &dxl_search : m_searches) {
+        uint8_t dxl_mode = m_dynamixel.get_operating_mode(dxl_search.id);
+        if (dxl_mode != ADDR_CONTROL_MODE_POSITION && dxl_mode != ADDR_CONTROL_MODE_EXTENDED_POSITION && dxl_mode != ADDR_CONTROL_MODE_CURRENT_POSITION) {
+            printf("failed: id: %i is not in a position mode: %i\n", dxl_search.id, dxl_mode);
+            dxl_ready = false;
+        }
+        if (m_dynamixel.get_torque(dxl_search.id) != 1) {
+            printf("failed: torque of id: %i is disabled\n", dxl_search.id);
+            dxl_ready = false;
+        }
+    }
+    return dxl_ready;
+}
+/**
+ * get a gain of a gain set
+ * @param t_gains the gain set
+ * @param t_gain the gain
+ * @return the raw gain
+ */
+uint16_t &Dynamixel_Tuner::m_get_gain(Dynamixel_Gains &t_gains, int t_gain) {
+    switch (t_gain) {
+        case DXL_GAIN_POSITION_D:
+            return t_gains.kd;
+        case DXL_GAIN_POSITION_I:
+            return t_gains.ki;
+        case DXL_GAIN_FEEDFORWARD_1:
+            return t_gains.ff1;
+        case DXL_GAIN_FEEDFORWARD_2:
+            return t_gains.ff2;
+        case DXL_GAIN_VELOCITY_P:
+            return t_gains.vp;
+        case DXL_GAIN_VELOCITY_I:
+            return t_gains.vi;
+        default:
+            return t_gains.kp;
+    }
+}
+/**
+ * run the experiment on all dynamixel's, one batched write/read per sample
+ * @return true if success otherwise false
+ */
+bool Dynamixel_Tuner::m_set_experiment() {
+    size_t dxl_total = 3 * m_samples;
+    size_t dxl_failures = 0;
+    auto dxl_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / m_rate));
+    auto dxl_deadline = std::chrono::steady_clock::now();
+
+    // hold the origin for one segment first, the previous experiment may still ring
+    for (size_t i = 0; i < m_samples + dxl_total; i++) {
+        bool dxl_record = i >= m_samples;
+        size_t dxl_sample = dxl_record ? i - m_samples : 0;
+        for (const Dynamixel_Search &dxl_search : m_searches) {
+            m_plan.set_value(dxl_search.goal, dxl_search.origin + (dxl_record ? m_goals[dxl_sample] : 0));
+        }
+        if (!m_plan.set_execute() && dxl_record) {
+            dxl_failures++;
+        }
+        for (size_t j = 0; j < m_searches.size() && dxl_record; j++) {
+            int32_t *dxl_positions = m_positions.data() + j * dxl_total;
+            if (m_plan.get_valid(m_searches[j].position)) {
+                dxl_positions[dxl_sample] = (int32_t)m_plan.get_value(m_searches[j].position) - m_searches[j].origin;
+            } else {
+                dxl_positions[dxl_sample] = dxl_sample > 0 ? dxl_positions[dxl_sample - 1] : 0;
+            }
+        }
+        dxl_deadline += dxl_period;
+        std::this_thread::sleep_until(dxl_deadline);
+    }
+    if (dxl_failures * 10 > dxl_total) {
+        printf("failed: experiment lost %zu of %zu samples\n", dxl_failures, dxl_total);
+        return false;
+    }
+    return true;
+}
+/**
+ * evaluate the recorded response of a dynamixel
+ * @param t_index the index of the dynamixel
+ * @return the response
+ */
+Dynamixel_Response Dynamixel_Tuner::m_get_response(size_t t_index) {
+    const int32_t *dxl_positions = m_positions.data() + t_index * 3 * m_samples;
+    Dynamixel_Response dxl_response{};
+
+    double dxl_error = 0.0;
+    for (size_t i = 0; i < m_samples; i++) {
+        double dxl_difference = (double)(dxl_positions[i] - m_goals[i]);
+        dxl_error += dxl_difference * dxl_difference;
+    }
+    dxl_response.tracking_error = std::sqrt(dxl_error / (double)m_samples) / m_amplitude;
+
+    double dxl_up_overshoot = 0.0;
+    double dxl_down_overshoot = 0.0;
+    double dxl_up = m_get_settling(dxl_positions + m_samples, m_samples, 0, m_amplitude, dxl_up_overshoot);
+    double dxl_down = m_get_settling(dxl_positions + 2 * m_samples, m_samples, m_amplitude, 0, dxl_down_overshoot);
+    dxl_response.overshoot = std::max(dxl_up_overshoot, dxl_down_overshoot);
+    dxl_response.settling_time = 0.5 * (dxl_up + dxl_down);
+
+    // the overshoot limit is a steep penalty, steep enough to act as a constraint
+    dxl_response.cost = dxl_response.settling_time / m_duration + dxl_response.tracking_error;
+    if (dxl_response.overshoot > m_overshoot) {
+        dxl_response.cost += 20.0 * (dxl_response.overshoot - m_overshoot);
+    }
+    return dxl_response;
+}
+/**
+ * get the settling time and the overshoot of a step
+ * @param t_positions the positions relative to the origin
+ * @param t_count the amount of positions
+ * @param t_start the position before the step
+ * @param t_target the target of the step
+ * @param t_overshoot the overshoot relative to the step
+ * @return the settling time in seconds, beyond the duration by the final error if it never settled
+ */
+double Dynamixel_Tuner::m_get_settling(const int32_t *t_positions, size_t t_count, int32_t t_start, int32_t t_target, double &t_overshoot) {
+    double dxl_step = (double)(t_target - t_start);
+    double dxl_band = m_settling_band * std::fabs(dxl_step);
+    double dxl_peak = 0.0;
+    size_t dxl_settled = 0;
+    for (size_t i = 0; i < t_count; i++) {
+        dxl_peak = std::max(dxl_peak, (double)(t_positions[i] - t_start) / dxl_step);
+        if (std::fabs((double)(t_positions[i] - t_target)) > dxl_band) {
+            dxl_settled = i + 1;
+        }
+    }
+    t_overshoot = std::max(dxl_peak - 1.0, 0.0);
+    // keep the cost informative for slow responses instead of a flat plateau
+    if (dxl_settled == t_count) {
+        return m_duration * (1.0 + std::fabs((double)(t_positions[t_count - 1] - t_target)) / std::fabs(dxl_step));
+    }
+    return (double)dxl_settled / m_rate;
+}
+/**
+ * advance the search of a dynamixel and set its next candidate
+ * @param t_search the search
+ * @param t_improved true if the last candidate was an improvement
+ */
+void Dynamixel_Tuner::m_set_next(Dynamixel_Search &t_search, bool t_improved) {
+    // coordinate search: p, d, i, feedforward (and velocity), both directions, shrink the factor after a full miss
+    int dxl_coordinates = m_velocity ? DXL_TUNER_GAINS : DXL_GAIN_VELOCITY_P;
+    for (int i = 0; i < 2 * dxl_coordinates && !t_search.done; i++) {
+        if (!t_improved) {
+            if (t_search.direction > 0) {
+                t_search.direction = -1;
+            } else {
+                t_search.direction = 1;
+                t_search.coordinate = (t_search.coordinate + 1) % dxl_coordinates;
+                if (++t_search.misses >= dxl_coordinates) {
+                    t_search.factor = std::sqrt(t_search.factor);
+                    t_search.misses = 0;
+                    t_search.done = t_search.factor < 1.05;
+                }
+            }
+        }
+        t_improved = false;
+        t_search.candidate = t_search.best;
+        uint16_t &dxl_gain = m_get_gain(t_search.candidate, t_search.coordinate);
+        uint16_t dxl_next = m_get_step(dxl_gain, t_search.coordinate, t_search.direction, t_search.factor);
+        if (dxl_next != dxl_gain) {
+            dxl_gain = dxl_next;
+            return;
+        }
+    }
+    t_search.candidate = t_search.best;
+}
+/**
+ * get the next value of a gain
+ * @param t_gain the current gain
+ * @param t_coordinate the gain -> Dynamixel_Gain
+ * @param t_direction the direction -> 1 = up, -1 = down
+ * @param t_factor the multiplicative step
+ * @return the next gain
+ */
+uint16_t Dynamixel_Tuner::m_get_step(uint16_t t_gain, int t_coordinate, int t_direction, double t_factor) {
+    // a zero gain needs a floor to start from, position p and velocity p never drop below their floor
+    const double dxl_floors[DXL_TUNER_GAINS] = {100.0, 50.0, 10.0, 50.0, 50.0, 50.0, 10.0};
+    double dxl_gain = t_direction > 0 ? std::max(t_gain * t_factor, dxl_floors[t_coordinate]) : t_gain / t_factor;
+    if (dxl_gain < dxl_floors[t_coordinate]) {
+        dxl_gain = t_coordinate == DXL_GAIN_POSITION_P || t_coordinate == DXL_GAIN_VELOCITY_P ? dxl_floors[t_coordinate] : 0.0;
+    }
+    return (uint16_t)std::lround(std::min(dxl_gain, (double)DXL_TUNER_GAIN_MAX));
+}
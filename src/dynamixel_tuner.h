@@ -0,0 +1,286 @@
+/*
+ * Dynamixel
+ *
+ * Copyright (C) 2020 Vinzenz Weist Vinz1911@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNAMIXEL_DYNAMIXEL_TUNER_H
+#define DYNAMIXEL_DYNAMIXEL_TUNER_H
+
+#include <cstdint>
+#include <vector>
+#include "dynamixel.h"
+#include "dynamixel_transaction.h"
+
+#define DXL_TUNER_GAIN_MAX 16383
+#define DXL_TUNER_GAINS 7
+
+/**
+ * the gains of the search, in the order the coordinate search visits them
+ */
+enum Dynamixel_Gain {
+    DXL_GAIN_POSITION_P = 0,
+    DXL_GAIN_POSITION_D = 1,
+    DXL_GAIN_POSITION_I = 2,
+    DXL_GAIN_FEEDFORWARD_1 = 3,
+    DXL_GAIN_FEEDFORWARD_2 = 4,
+    DXL_GAIN_VELOCITY_P = 5,
+    DXL_GAIN_VELOCITY_I = 6
+};
+
+/**
+ * the position pid, feedforward and velocity pi gains of a dynamixel in raw register units
+ */
+struct Dynamixel_Gains {
+    /**
+     * the position P-GAIN
+     */
+    uint16_t kp;
+    /**
+     * the position I-GAIN
+     */
+    uint16_t ki;
+    /**
+     * the position D-GAIN
+     */
+    uint16_t kd;
+    /**
+     * the feedforward 1st gain (velocity)
+     */
+    uint16_t ff1;
+    /**
+     * the feedforward 2nd gain (acceleration)
+     */
+    uint16_t ff2;
+    /**
+     * the velocity P-GAIN
+     */
+    uint16_t vp;
+    /**
+     * the velocity I-GAIN
+     */
+    uint16_t vi;
+};
+
+/**
+ * the measured response of a dynamixel during one experiment
+ */
+struct Dynamixel_Response {
+    /**
+     * the overshoot of the steps relative to the amplitude
+     */
+    double overshoot;
+    /**
+     * the settling time of the steps in seconds
+     */
+    double settling_time;
+    /**
+     * the rms tracking error of the chirp relative to the amplitude
+     */
+    double tracking_error;
+    /**
+     * the cost which is minimized by the tuner
+     */
+    double cost;
+};
+
+/**
+ * tunes the position pid and feedforward gains of many dynamixel's at once, every servo runs
+ * its own search but the experiments share the bus ticks (batched reads/writes)
+ * NOTE: the dynamixel's must be in a position mode with torque enabled, this is checked before every tune
+ */
+class Dynamixel_Tuner {
+// public declaration
+public:
+    /**
+     * initialize the tuner, reads the current gains as starting point
+     * @param t_dynamixel the dynamixel bus
+     * @param t_dxl_ids the identifiers of the dynamixel's to tune
+     */
+    Dynamixel_Tuner(Dynamixel &t_dynamixel, const std::vector<uint8_t> &t_dxl_ids);
+    /**
+     * set the experiment
+     * @param t_amplitude the step and chirp amplitude in ticks
+     * @param t_duration the duration of a step and of the chirp in seconds
+     * @param t_rate the sample rate in hz
+     */
+    void set_experiment(uint16_t t_amplitude, double t_duration, double t_rate);
+    /**
+     * set the limits of the response
+     * @param t_overshoot the max overshoot relative to the amplitude -> 0.05 = 5%
+     * @param t_settling_band the settling band relative to the amplitude
+     */
+    void set_limits(double t_overshoot, double t_settling_band);
+    /**
+     * add the velocity pi gains to the search, the position modes of the x series don't
+     * use the velocity loop, so this only pays off on models which cascade it | default -> false
+     * @param t_velocity true to search the velocity gains as well
+     */
+    void set_velocity_search(bool t_velocity);
+    /**
+     * run the search, every iteration is one experiment on all dynamixel's
+     * @param t_iterations the max amount of iterations
+     * @return true if success otherwise false
+     */
+    bool set_tune(int t_iterations);
+    /**
+     * write the best gains of all dynamixel's in one sync write
+     * @return true if success otherwise false
+     */
+    bool set_apply();
+    /**
+     * get the best gains of a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return the gains
+     */
+    Dynamixel_Gains get_gains(uint8_t t_dxl_id);
+    /**
+     * get the response of the best gains of a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @return the response
+     */
+    Dynamixel_Response get_response(uint8_t t_dxl_id);
+
+// private declaration
+private:
+    /**
+     * the search state of a single dynamixel
+     */
+    struct Dynamixel_Search {
+        uint8_t id;
+        Dynamixel_Gains best;
+        Dynamixel_Gains candidate;
+        Dynamixel_Response response;
+        double factor;
+        int coordinate;
+        int direction;
+        int misses;
+        bool done;
+        size_t gains[DXL_TUNER_GAINS];
+        size_t goal;
+        size_t position;
+        int32_t origin;
+        bool evaluated;
+    };
+    /**
+     * the dynamixel bus
+     */
+    Dynamixel &m_dynamixel;
+    /**
+     * the searches, one per dynamixel
+     */
+    std::vector<Dynamixel_Search> m_searches;
+    /**
+     * the recorded positions relative to the origin, one experiment per dynamixel
+     */
+    std::vector<int32_t> m_positions;
+    /**
+     * the goals of the experiment relative to the origin
+     */
+    std::vector<int32_t> m_goals;
+    /**
+     * the amount of samples of a single segment
+     */
+    size_t m_samples = 0;
+    /**
+     * the sync write of the gains
+     */
+    Dynamixel_Plan m_gain_plan;
+    /**
+     * the goal write and the position read of a sample
+     */
+    Dynamixel_Plan m_plan;
+    /**
+     * the step and chirp amplitude in ticks
+     */
+    uint16_t m_amplitude = 200;
+    /**
+     * the duration of a segment in seconds
+     */
+    double m_duration = 0.5;
+    /**
+     * the sample rate in hz
+     */
+    double m_rate = 200.0;
+    /**
+     * the max overshoot relative to the amplitude
+     */
+    double m_overshoot = 0.05;
+    /**
+     * the settling band relative to the amplitude
+     */
+    double m_settling_band = 0.05;
+    /**
+     * true if the velocity gains are searched as well
+     */
+    bool m_velocity = false;
+    /**
+     * write the gains of all dynamixel's in one sync write
+     * @param t_candidate true for the candidates, false for the best gains
+     * @return true if success otherwise false
+     */
+    bool m_set_gains(bool t_candidate);
+    /**
+     * check that every dynamixel is in a position mode with torque enabled
+     * @return true if the experiment may move them
+     */
+    bool m_get_ready();
+    /**
+     * get a gain of a gain set
+     * @param t_gains the gain set
+     * @param t_gain the gain
+     * @return the raw gain
+     */
+    static uint16_t &m_get_gain(Dynamixel_Gains &t_gains, int t_gain);
+    /**
+     * run the experiment on all dynamixel's, one batched write/read per sample
+     * @return true if success otherwise false
+     */
+    bool m_set_experiment();
+    /**
+     * evaluate the recorded response of a dynamixel
+     * @param t_index the index of the dynamixel
+     * @return the response
+     */
+    Dynamixel_Response m_get_response(size_t t_index);
+    /**
+     * get the settling time and the overshoot of a step
+     * @param t_positions the positions relative to the origin
+     * @param t_count the amount of positions
+     * @param t_start the position before the step
+     * @param t_target the target of the step
+     * @param t_overshoot the overshoot relative to the step
+     * @return the settling time in seconds, beyond the duration by the final error if it never settled
+     */
+    double m_get_settling(const int32_t *t_positions, size_t t_count, int32_t t_start, int32_t t_target, double &t_overshoot);
+    /**
+     * advance the search of a dynamixel and set its next candidate
+     * @param t_search the search
+     * @param t_improved true if the last candidate was an improvement
+     */
+    void m_set_next(Dynamixel_Search &t_search, bool t_improved);
+    /**
+     * get the next value of a gain
+     * @param t_gain the current gain
+     * @param t_coordinate the gain -> Dynamixel_Gain
+     * @param t_direction the direction -> 1 = up, -1 = down
+     * @param t_factor the multiplicative step
+     * @return the next gain
+     */
+    static uint16_t m_get_step(uint16_t t_gain, int t_coordinate, int t_direction, double t_factor);
+};
+
+#endif
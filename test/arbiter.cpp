@@ -0,0 +1,80 @@
+//
+//  arbiter.cpp
+//  Dynamixel
+//
+//  Created by Vinzenz Weist on 27.04.20.
+//  Copyright © 2020 Vinzenz Weist. All rights reserved.
+//
+
+#include <chrono>
+#include "../src/dynamixel_arbiter.h"
+#include "dynamixel_fake_port.h"
+
+#define DXL_FAKE_SUBMITTERS 2
+#define DXL_FAKE_GOALS 200
+#define DXL_FAKE_WRITE_TIME 0.002
+#define DXL_FAKE_FLUSH_PAUSE 0.0001
+
+/**
+ * a fake bus which takes its time for every write,
+ * the arbiter writes after it marked the goals as sent and before it published the outcome
+ */
+class Dynamixel_Slow_Port : public Dynamixel_Fake_Port {
+// public declaration
+public:
+    /**
+     * execute the instructions after the time of the write
+     * @param t_packet the packets
+     * @param t_length the length of the packets
+     * @return the amount of bytes which were written
+     */
+    int writePort(uint8_t *t_packet, int t_length) override {
+        std::this_thread::sleep_for(std::chrono::duration<double>(DXL_FAKE_WRITE_TIME));
+        return Dynamixel_Fake_Port::writePort(t_packet, t_length);
+    };
+};
+
+/**
+ * submits goals for the same dynamixel back to back from two threads against a flushing thread,
+ * the goal one submitter sends in the next window must not take away the outcome of the other
+ */
+int main() {
+    Dynamixel_Slow_Port dxl_port = Dynamixel_Slow_Port();
+    Dynamixel dynamixel = Dynamixel(&dxl_port);
+    if (!dynamixel.set_open()) {
+        printf("failed: could not open the fake port\n");
+        return 1;
+    }
+    Dynamixel_Arbiter dxl_arbiter(dynamixel);
+    if (!dxl_arbiter.set_register(ADDR_GOAL_POSITION, 4)) {
+        return 1;
+    }
+
+    // windows with goals follow back to back, empty ones pause, flushing them without a pause would overrun the kept outcomes
+    std::atomic<bool> dxl_running(true);
+    std::thread dxl_flusher([&dxl_arbiter, &dxl_running]() {
+        while (dxl_running.load(std::memory_order_relaxed)) {
+            if (dxl_arbiter.set_flush() == 0) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(DXL_FAKE_FLUSH_PAUSE));
+            }
+        }
+    });
+    std::atomic<int> dxl_failed(0);
+    std::vector<std::thread> dxl_submitters;
+    for (int i = 0; i < DXL_FAKE_SUBMITTERS; i++) {
+        dxl_submitters.emplace_back([&dxl_arbiter, &dxl_failed, i]() {
+            for (int j = 0; j < DXL_FAKE_GOALS; j++) {
+                if (!dxl_arbiter.set_goal_position(1, (uint32_t)(i * DXL_FAKE_GOALS + j))) {
+                    dxl_failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (std::thread &dxl_submitter : dxl_submitters) {
+        dxl_submitter.join();
+    }
+    dxl_running.store(false, std::memory_order_relaxed);
+    dxl_flusher.join();
+    printf("goals: %i, failed goals: %i\n", DXL_FAKE_SUBMITTERS * DXL_FAKE_GOALS, dxl_failed.load());
+    return dxl_failed.load() != 0;
+}
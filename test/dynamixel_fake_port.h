@@ -0,0 +1,269 @@
+//
+//  dynamixel_fake_port.h
+//  Dynamixel
+//
+//  Created by Vinzenz Weist on 27.04.20.
+//  Copyright © 2020 Vinzenz Weist. All rights reserved.
+//
+
+#ifndef DYNAMIXEL_DYNAMIXEL_FAKE_PORT_H
+#define DYNAMIXEL_DYNAMIXEL_FAKE_PORT_H
+
+#include <cstring>
+#include "../src/dynamixel.h"
+#include "../src/dynamixel_packet.h"
+
+#define DXL_FAKE_IDS 8
+#define DXL_FAKE_REGISTERS 256
+#define DXL_FAKE_RX_LEN 4096
+
+/**
+ * a bus without hardware, answers every instruction from a register image of DXL_FAKE_IDS dynamixel's
+ * NOTE: byte stuffing is not removed, the test keeps every value free of 0xFF 0xFF 0xFD
+ */
+class Dynamixel_Fake_Port : public dynamixel::PortHandler {
+// public declaration
+public:
+    /**
+     * initialize the fake port
+     */
+    Dynamixel_Fake_Port() {
+        is_using_ = false;
+    };
+    /**
+     * open the fake port
+     * @return true
+     */
+    bool openPort() override {
+        return true;
+    };
+    /**
+     * close the fake port
+     */
+    void closePort() override {
+    };
+    /**
+     * drop all received bytes
+     */
+    void clearPort() override {
+        m_rx_head = m_rx_tail;
+    };
+    /**
+     * set the name of the fake port, the name is fixed
+     * @param t_port_name the name of the port
+     */
+    void setPortName(const char *t_port_name) override {
+        (void)t_port_name;
+    };
+    /**
+     * get the name of the fake port
+     * @return the name of the port
+     */
+    char *getPortName() override {
+        return m_port_name;
+    };
+    /**
+     * set the baud rate
+     * @param t_baud_rate the baud rate
+     * @return true
+     */
+    bool setBaudRate(const int t_baud_rate) override {
+        m_baud_rate = t_baud_rate;
+        return true;
+    };
+    /**
+     * get the baud rate
+     * @return the baud rate
+     */
+    int getBaudRate() override {
+        return m_baud_rate;
+    };
+    /**
+     * get the amount of received bytes
+     * @return the amount of bytes
+     */
+    int getBytesAvailable() override {
+        return (int)(m_rx_tail - m_rx_head);
+    };
+    /**
+     * read the received bytes
+     * @param t_packet the buffer
+     * @param t_length the length of the buffer
+     * @return the amount of bytes which were read
+     */
+    int readPort(uint8_t *t_packet, int t_length) override {
+        int dxl_length = 0;
+        while (dxl_length < t_length && m_rx_head != m_rx_tail) {
+            t_packet[dxl_length++] = m_rx[m_rx_head++ % DXL_FAKE_RX_LEN];
+        }
+        return dxl_length;
+    };
+    /**
+     * execute every instruction of a write against the register image and queue the statuses
+     * @param t_packet the packets
+     * @param t_length the length of the packets
+     * @return the amount of bytes which were written
+     */
+    int writePort(uint8_t *t_packet, int t_length) override {
+        for (int i = 0; i + DXL_INSTRUCTION_FRAME_LEN <= t_length;) {
+            uint8_t dxl_id = t_packet[i + 4];
+            uint16_t dxl_length = DXL_MAKEWORD(t_packet[i + 5], t_packet[i + 6]);
+            m_set_instruction(dxl_id, t_packet[i + 7], t_packet + i + 8, dxl_length - 3);
+            i += 7 + dxl_length;
+        }
+        return t_length;
+    };
+    /**
+     * start waiting for a status, statuses are queued while writing
+     * @param t_packet_length the length of the status in bytes
+     */
+    void setPacketTimeout(uint16_t t_packet_length) override {
+        (void)t_packet_length;
+    };
+    /**
+     * start waiting for a fixed time, statuses are queued while writing
+     * @param t_msec the time in milliseconds
+     */
+    void setPacketTimeout(double t_msec) override {
+        (void)t_msec;
+    };
+    /**
+     * check if the wait timed out, everything which will arrive is already queued
+     * @return true
+     */
+    bool isPacketTimeout() override {
+        return true;
+    };
+    /**
+     * set a register of a dynamixel in the register image
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the address of the register
+     * @param t_length the length of the register -> 1, 2, 4
+     * @param t_value the value
+     */
+    void set_register(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length, uint32_t t_value) {
+        for (uint16_t i = 0; i < t_length; i++) {
+            m_registers[t_dxl_id][t_address + i] = (uint8_t)(t_value >> (8 * i));
+        }
+    };
+
+// private declaration
+private:
+    /**
+     * the register image of every dynamixel
+     */
+    uint8_t m_registers[DXL_FAKE_IDS][DXL_FAKE_REGISTERS] = {};
+    /**
+     * the received bytes, a ring buffer
+     */
+    uint8_t m_rx[DXL_FAKE_RX_LEN] = {};
+    /**
+     * the read position in the ring buffer
+     */
+    size_t m_rx_head = 0;
+    /**
+     * the write position in the ring buffer
+     */
+    size_t m_rx_tail = 0;
+    /**
+     * the name of the fake port
+     */
+    char m_port_name[5] = "fake";
+    /**
+     * the baud rate
+     */
+    int m_baud_rate = 1000000;
+    /**
+     * check if a register block exists in the register image
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the address of the block
+     * @param t_length the length of the block
+     * @return true if the block exists otherwise false
+     */
+    static bool m_get_known(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length) {
+        return t_dxl_id < DXL_FAKE_IDS && t_address + t_length <= DXL_FAKE_REGISTERS;
+    };
+    /**
+     * queue the status of a dynamixel with a block of its registers
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the address of the block
+     * @param t_length the length of the block
+     */
+    void m_set_status(uint8_t t_dxl_id, uint16_t t_address, uint16_t t_length) {
+        if (!m_get_known(t_dxl_id, t_address, t_length)) {
+            return;
+        }
+        uint8_t dxl_param[DXL_FAKE_REGISTERS + 1];
+        dxl_param[0] = 0;
+        memcpy(dxl_param + 1, m_registers[t_dxl_id] + t_address, t_length);
+        uint8_t dxl_status[2 * DXL_FAKE_REGISTERS + DXL_STATUS_FRAME_LEN];
+        size_t dxl_length = Dynamixel_Packet::set_instruction(dxl_status, sizeof(dxl_status), t_dxl_id, DXL_STATUS_INSTRUCTION, dxl_param, t_length + 1);
+        for (size_t i = 0; i < dxl_length; i++) {
+            m_rx[m_rx_tail++ % DXL_FAKE_RX_LEN] = dxl_status[i];
+        }
+    };
+    /**
+     * write a block into the registers of a dynamixel
+     * @param t_dxl_id the identifier of the dynamixel
+     * @param t_address the address of the block
+     * @param t_data the data
+     * @param t_length the length of the block
+     */
+    void m_set_block(uint8_t t_dxl_id, uint16_t t_address, const uint8_t *t_data, uint16_t t_length) {
+        if (!m_get_known(t_dxl_id, t_address, t_length)) {
+            return;
+        }
+        memcpy(m_registers[t_dxl_id] + t_address, t_data, t_length);
+    };
+    /**
+     * execute a single instruction
+     * @param t_dxl_id the identifier in the instruction
+     * @param t_instruction the instruction
+     * @param t_param the parameters
+     * @param t_length the length of the parameters
+     */
+    void m_set_instruction(uint8_t t_dxl_id, uint8_t t_instruction, const uint8_t *t_param, int t_length) {
+        uint16_t dxl_address = t_length >= 2 ? DXL_MAKEWORD(t_param[0], t_param[1]) : 0;
+        uint16_t dxl_length = t_length >= 4 ? DXL_MAKEWORD(t_param[2], t_param[3]) : 0;
+        switch (t_instruction) {
+            case INST_PING:
+                m_set_status(t_dxl_id, ADDR_MODEL_NUMBER, 3);
+                break;
+            case INST_READ:
+                m_set_status(t_dxl_id, dxl_address, dxl_length);
+                break;
+            case INST_WRITE:
+                m_set_block(t_dxl_id, dxl_address, t_param + 2, t_length - 2);
+                if (t_dxl_id != BROADCAST_ID) {
+                    m_set_status(t_dxl_id, 0, 0);
+                }
+                break;
+            case INST_SYNC_READ:
+                for (int i = 4; i < t_length; i++) {
+                    m_set_status(t_param[i], dxl_address, dxl_length);
+                }
+                break;
+            case INST_SYNC_WRITE:
+                for (int i = 4; i + 1 + dxl_length <= t_length; i += 1 + dxl_length) {
+                    m_set_block(t_param[i], dxl_address, t_param + i + 1, dxl_length);
+                }
+                break;
+            case INST_BULK_READ:
+                for (int i = 0; i + 5 <= t_length; i += 5) {
+                    m_set_status(t_param[i], DXL_MAKEWORD(t_param[i + 1], t_param[i + 2]), DXL_MAKEWORD(t_param[i + 3], t_param[i + 4]));
+                }
+                break;
+            case INST_BULK_WRITE:
+                for (int i = 0; i + 5 <= t_length;) {
+                    uint16_t dxl_block = DXL_MAKEWORD(t_param[i + 3], t_param[i + 4]);
+                    m_set_block(t_param[i], DXL_MAKEWORD(t_param[i + 1], t_param[i + 2]), t_param + i + 5, dxl_block);
+                    i += 5 + dxl_block;
+                }
+                break;
+            default:
+                break;
+        }
+    };
+};
+
+#endif
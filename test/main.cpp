@@ -0,0 +1,87 @@
+//
+//  main.cpp
+//  Dynamixel
+//
+//  Created by Vinzenz Weist on 27.04.20.
+//  Copyright © 2020 Vinzenz Weist. All rights reserved.
+//
+
+#include "../src/dynamixel_audit.h"
+#include "../src/dynamixel_pwm.h"
+#include "../src/dynamixel_scheduler.h"
+#include "../src/dynamixel_transaction.h"
+#include "dynamixel_fake_port.h"
+
+#define DXL_FAKE_TICKS 200
+
+/**
+ * drives the plan, group write, scheduler and pwm ticks against a fake bus in an audit build,
+ * fails if any tick allocated
+ */
+int main() {
+    std::vector<uint8_t> dxl_ids = {1, 2, 3, 4};
+    Dynamixel_Fake_Port dxl_port = Dynamixel_Fake_Port();
+    for (uint8_t dxl_id : dxl_ids) {
+        dxl_port.set_register(dxl_id, ADDR_OPERATING_MODE, 1, ADDR_CONTROL_MODE_POSITION);
+        dxl_port.set_register(dxl_id, ADDR_TORQUE, 1, 1);
+        dxl_port.set_register(dxl_id, ADDR_PWM_LIMIT, 2, 885);
+        dxl_port.set_register(dxl_id, ADDR_PRESENT_POSITION, 4, 1024 * dxl_id);
+    }
+    Dynamixel dynamixel = Dynamixel(&dxl_port);
+    if (!dynamixel.set_open()) {
+        printf("failed: could not open the fake port\n");
+        return 1;
+    }
+    Dynamixel_Audit::set_fatal(false);
+
+    // the audit has to catch a deliberate allocation, else passing ticks prove nothing
+    {
+        Dynamixel_Tick_Guard dxl_guard("baseline");
+        uint8_t *volatile dxl_block = new uint8_t[DXL_FAKE_REGISTERS];
+        delete[] dxl_block;
+    }
+    uint64_t dxl_baseline = Dynamixel_Audit::get_failures();
+    if (dxl_baseline != 1) {
+        printf("failed: the audit missed a deliberate allocation\n");
+        return 1;
+    }
+
+    // everything which may allocate is prepared before the first tick
+    Dynamixel_Builder dxl_builder = Dynamixel_Builder();
+    std::vector<size_t> dxl_positions, dxl_goals;
+    for (uint8_t dxl_id : dxl_ids) {
+        dxl_positions.push_back(dxl_builder.set_read(dxl_id, ADDR_PRESENT_POSITION, 4));
+        dxl_goals.push_back(dxl_builder.set_write(dxl_id, ADDR_GOAL_POSITION, 4, 0));
+    }
+    Dynamixel_Plan dxl_plan = dxl_builder.get_plan(dynamixel);
+    Dynamixel_Scheduler dxl_scheduler = Dynamixel_Scheduler(dynamixel);
+    for (uint8_t dxl_id : dxl_ids) {
+        dxl_scheduler.set_register(dxl_id, ADDR_PRESENT_POSITION, 4, 1000.0);
+        dxl_scheduler.set_register(dxl_id, ADDR_PRESENT_TEMPERATURE, 1, 500.0);
+    }
+    Dynamixel_Pwm_Control dxl_pwm = Dynamixel_Pwm_Control(dynamixel, dxl_ids);
+    if (!dxl_pwm.set_open()) {
+        printf("failed: could not open the pwm control\n");
+        return 1;
+    }
+
+    bool dxl_success = true;
+    for (int i = 0; i < DXL_FAKE_TICKS; i++) {
+        Dynamixel_Tick_Guard dxl_guard("control");
+        for (size_t j = 0; j < dxl_ids.size(); j++) {
+            dxl_plan.set_value(dxl_goals[j], (uint32_t)(i + j));
+        }
+        dxl_success &= dxl_plan.set_execute();
+        dynamixel.set_group_goal_position(dxl_ids[0], dxl_ids[1], i, 2 * i);
+        dxl_scheduler.set_tick(1.0);
+        dxl_pwm.set_pwm(0, (int16_t)i);
+        dxl_success &= dxl_pwm.set_cycle();
+    }
+    if (!dxl_success || dxl_plan.get_value(dxl_positions[2]) != 1024 * dxl_ids[2]) {
+        printf("failed: the ticks did not reach the fake bus\n");
+        return 1;
+    }
+    uint64_t dxl_failures = Dynamixel_Audit::get_failures() - dxl_baseline;
+    printf("ticks: %i, failed ticks: %llu\n", DXL_FAKE_TICKS, (unsigned long long)dxl_failures);
+    return dxl_failures != 0;
+}